@@ -37,13 +37,14 @@ namespace core
         void imguiEndFrame();
 
         void checkersBotSelectionMenu(BitBoard& board);
-        void runCheckers(Checkers& checkers, BitBoard& board, NETWORK::CheckersMinMax& algorithm, NTARS::DenseNeuralNetwork& network, std::vector<NTARS::DATA::TrainingData<std::vector<float>>>& trainingData);
+        void runCheckers(Checkers& checkers, BitBoard& board, NETWORK::CheckersMinMax& algorithm, NTARS::DenseNeuralNetwork& network, std::vector<NETWORK::CheckersSample>& trainingData);
         void runPresentation();
         void runAITraining();
         void runMenu();
 
         void initBots();
         void drawNetwork();
+        void drawTrainingTelemetry();
 
         CurrentPart part{CurrentPart::MENU};
 
@@ -51,6 +52,7 @@ namespace core
 
         const size_t batch_size = 300;
         float learningRate = 1.5;
+        int32_t currentOptimizer = NTARS::OptimizerType_SGD;
 
         NTARS::DenseNeuralNetwork numberNetwork{{784, 100, 50, 10}, "ExampleNet_V1"};
         mnist::MNIST_dataset<std::vector, std::vector<uint8_t>, uint8_t> dataset{};
@@ -63,6 +65,31 @@ namespace core
         SoundHandle soundHandle;
         std::unique_ptr<window_t> window;
     };
+
+    // One rank of data-parallel checkers training, started in-process as rank 0 or as a "--train-worker" process
+    int32_t runTrainingWorker(const NTARS::TransportConfig& config);
+
+    // Trains a small network on numRanks single-threaded ranks and on one process with numRanks threads, the
+    // weights have to match bit for bit. 0 when they do. Ranks with several threads each fold their slice in a
+    // different order and only agree to rounding, so the guarantee is for single-threaded ranks only
+    int32_t verifyLoopbackTraining(size_t numRanks, NTARS::TransportType_ transport);
+    // One of its ranks, started as a "--loopback-worker" process
+    int32_t runLoopbackWorker(const NTARS::TransportConfig& config);
+
+    // Opens damaged copies of a small .tds dataset, every one has to be refused cleanly. 0 when they are
+    int32_t verifyDatasetChecks();
+
+    // Trains a BatchNorm network on 1 to 64 threads from the same start, the parameters may only differ by
+    // rounding. 0 when they do
+    int32_t verifyBatchNormThreads();
+
+    // Interrupts and resumes training with dropout and dynamic loss scaling, the weights have to match an
+    // uninterrupted run bit for bit. 0 when they do
+    int32_t verifyCheckpointResume();
+
+    // Writes NaN and infinities to NDJSON and reads them back through both parsers, no record may be lost.
+    // 0 when none is
+    int32_t verifyNDJSONRoundTrip();
     
 } // namespace core
 
@@ -383,6 +383,31 @@ std::vector<float> BitBoard::vectorBoard(BoardStruct& board)
     return vec;
 }
 
+size_t BitBoard::featureBoard(const BoardStruct& board, uint32_t* features) const
+{
+    const uint64_t pieces[4] = {
+        board.board_state[MAX] & ~board.queenBoard,
+        board.board_state[MAX] & board.queenBoard,
+        board.board_state[MIN] & ~board.queenBoard,
+        board.board_state[MIN] & board.queenBoard};
+
+    size_t count = 0;
+    for (uint32_t type = 0; type < 4; ++type)
+    {
+        uint64_t remaining = pieces[type];
+        while (remaining && count < maxActiveFeatures)
+        {
+            unsigned long index;
+            _BitScanForward64(&index, remaining);
+
+            features[count++] = type * 64 + static_cast<uint32_t>(index);
+            remaining &= (remaining - 1);
+        }
+    }
+
+    return count;
+}
+
 std::vector<uint64_t> BitBoard::getPieceIndices(BoardStruct& board, bool max)
 {
     std::vector<uint64_t> indices;
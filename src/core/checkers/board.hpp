@@ -214,6 +214,13 @@ public:
 
     inline BoardStruct& bitboard() { return board; }
     std::vector<float> vectorBoard(BoardStruct& board);
+
+    // One-hot piece type x square features for a sparse first layer (NTARS::InferencePlan with a sparse input):
+    // MAX men, MAX queens, MIN men and MIN queens, 64 squares each. Writes one index per piece, pieces only stand on
+    // the 32 dark squares, and returns how many were written
+    static constexpr uint32_t numFeatures = 4 * 64;
+    static constexpr size_t maxActiveFeatures = 32;
+    size_t featureBoard(const BoardStruct& board, uint32_t* features) const;
     inline void changeTurn() { currentTurn = !currentTurn; }
 
     inline uint32_t getSize() { return 8; }
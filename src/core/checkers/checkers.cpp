@@ -48,7 +48,7 @@ bool isClicked(const ImVec2 center, const float tile_size)
 int32_t currentSelectedPiece = -1;
 std::vector<BitMove> movesPossibleCurrentPiece{};
 
-void Checkers::handleNetworkAction(std::vector<float>& activations, NETWORK::CheckersMinMax& algorithm)
+void Checkers::handleNetworkAction(std::span<const float> activations, NETWORK::CheckersMinMax& algorithm)
 {
     BoardStruct& board_state = board.bitboard();
     std::vector<BitMove> currentMoves = board.getMoves(board_state, true);
@@ -10,6 +10,7 @@
 
 #include <vector>
 #include <map>
+#include <span>
 
 class Checkers 
 {
@@ -19,7 +20,7 @@ public:
     void drawBoard(Bot& bot);
     void drawInfo(int32_t boardScore, Bot& bot);
 
-    void handleNetworkAction(std::vector<float>& activations, NETWORK::CheckersMinMax& algorithm);
+    void handleNetworkAction(std::span<const float> activations, NETWORK::CheckersMinMax& algorithm);
     void handleAction(uint64_t pieceIndex, uint64_t moveIndex);
 
     inline const int32_t getCellMouseAt(const ImVec2 boardStart) const
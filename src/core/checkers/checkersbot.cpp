@@ -1,8 +1,7 @@
 #include "checkersbot.hpp"
 
-#include <cstdlib>
-#include <ctime>
 #include <core/audio.hpp>
+#include <ntars/base/random.hpp>
 
 Bot::Bot(BotInfo info, const std::string& path)
     : info(info)
@@ -12,7 +11,7 @@ Bot::Bot(BotInfo info, const std::string& path)
 
 bool Bot::shouldBlunder()
 {
-    return (std::rand() % 100) < static_cast<int32_t>(info.blunderChance * 100);
+    return NTARS::threadRandom().bernoulli(info.blunderChance);
 }
 
 void Bot::handleSpeech(int32_t boardScore)
@@ -20,16 +19,17 @@ void Bot::handleSpeech(int32_t boardScore)
     SpeechType type{SpeechType::Neutral};
     bool tendsToDraw = (boardScore >= -10 && boardScore <= 10);
 
-    int roll = std::rand() % 20;
+    NTARS::Random& random = NTARS::threadRandom();
+    int roll = random.uniformInt(20);
 
     if (roll < 5)
     {
-        type = static_cast<SpeechType>((std::rand() % 2 == 0) ? SpeechType::Taunt : SpeechType::Surprise);
+        type = static_cast<SpeechType>((random.uniformInt(2) == 0) ? SpeechType::Taunt : SpeechType::Surprise);
     }
     else if (roll < 15)
     {
         do {
-            type = static_cast<SpeechType>(std::rand() % static_cast<int32_t>(SpeechType::Neutral));
+            type = static_cast<SpeechType>(random.uniformInt(static_cast<uint32_t>(SpeechType::Neutral)));
         } while (type == SpeechType::Win || type == SpeechType::Lose || type == SpeechType::Capture || type == SpeechType::MultiCapture);
     }
     else
@@ -67,14 +67,7 @@ void Bot::chooseSpeech(SpeechType type)
         return;
     }
 
-    static bool seeded = false;
-    if (!seeded)
-    {
-        std::srand(std::time(nullptr));
-        seeded = true;
-    }
-
-    int32_t randomIndex = std::rand() % matchingSpeeches.size();
+    int32_t randomIndex = NTARS::threadRandom().uniformInt(static_cast<uint32_t>(matchingSpeeches.size()));
     auto it = std::find_if(info.speeches.begin(), info.speeches.end(),
         [&](const BotSpeech& s) { return s.text == matchingSpeeches[randomIndex]; });
     info.currentSpeech = static_cast<int32_t>(std::distance(info.speeches.begin(), it));
@@ -1,10 +1,10 @@
 #include "checkersminmax.hpp"
 #include <tarsmath/linear_algebra/vector_component.hpp>
+#include <ntars/base/random.hpp>
 
 #include <string>
 #include <iostream>
 #include <algorithm>
-#include <random>
 
 namespace NETWORK
 {
@@ -18,43 +18,7 @@ namespace NETWORK
         return sqrtf(powf(x1.x - x0.x, 2) + powf(x1.y - x0.y, 2));
     }
 
-    std::vector<float> CheckersMinMax::getTrainingLabel(uint64_t moveIndex)
-    {
-        std::vector<float> emptyBoard(board.getSize() * board.getSize(), 0);
-
-        unsigned long rawIndex;
-        _BitScanForward64(&rawIndex, moveIndex);
-
-        emptyBoard[rawIndex] = 1.0;
-
-        return emptyBoard;
-    }
-
-    std::vector<float> getTrainingBoard(BoardStruct& board_state)
-    {
-        std::vector<float> result(64, 0.0f); 
-
-        for (int i = 0; i < 64; ++i)
-        {
-            uint64_t mask = 1ULL << i;
-
-            bool occupied = board_state.occupiedBoard & mask;
-            if (!occupied) continue;
-
-            bool isMax = board_state.board_state[MAX] & mask;
-            bool isMin = board_state.board_state[MIN] & mask;
-            bool isQueen = board_state.queenBoard & mask;
-
-            if (isMax)
-                result[i] = isQueen ? 2.0f : 1.0f;
-            else if (isMin)
-                result[i] = isQueen ? 4.0f : 3.0f;
-        }
-
-        return result;
-    }
-
-    BitMove CheckersMinMax::getBestMove(BoardStruct& board_state, std::vector<NTARS::DATA::TrainingData<std::vector<float>>>& trainingData, bool max, float blunderChance)
+    BitMove CheckersMinMax::getBestMove(BoardStruct& board_state, std::vector<CheckersSample>& trainingData, bool max, float blunderChance)
     {
         checkedMoves = 0;
 
@@ -69,11 +33,8 @@ namespace NETWORK
 
         if (blunderChance > 0.0f)
         {
-            std::random_device rd;
-            std::mt19937 gen(rd());
-            std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-
-            if (dist(gen) < blunderChance)
+            NTARS::Random& random = NTARS::threadRandom();
+            if (random.bernoulli(blunderChance))
             {
                 std::vector<BitMove> legalMoves = board.getMoves(board_state, max);
 
@@ -86,7 +47,7 @@ namespace NETWORK
 
                 if (!badChoices.empty())
                 {
-                    return badChoices[rand() % badChoices.size()];
+                    return badChoices[random.uniformInt(static_cast<uint32_t>(badChoices.size()))];
                 }
             }
         }
@@ -96,7 +57,7 @@ namespace NETWORK
 
     std::pair<int32_t, BitMove> CheckersMinMax::minimax(
         BoardStruct& board_state, 
-        std::vector<NTARS::DATA::TrainingData<std::vector<float>>>& trainingData, 
+        std::vector<CheckersSample>& trainingData, 
         bool max, uint32_t currentDepth, uint32_t maxDepth, int32_t alpha, int32_t beta)
     {
         if (currentDepth == maxDepth)
@@ -160,14 +121,15 @@ namespace NETWORK
         boardScore = bestValue;
 
         if ((chosenMove.moveMask != 0 || chosenMove.indexMask != 0) && _inserted == true) {
-            NTARS::DATA::TrainingData<std::vector<float>> moveData;
-            moveData.data = getTrainingBoard(board_state);
-            moveData.label = getTrainingLabel(chosenMove.moveMask);
+            unsigned long moveSquare;
+            _BitScanForward64(&moveSquare, chosenMove.moveMask);
+
+            CheckersSample moveData{board_state, static_cast<uint8_t>(moveSquare)};
 
             auto exists = std::find_if(trainingData.begin(), trainingData.end(), 
-            [&](const NTARS::DATA::TrainingData<std::vector<float>>& existingData)
+            [&](const CheckersSample& existingData)
             {
-                return moveData.data == existingData.data;
+                return moveData.board == existingData.board;
             });
 
             if (exists == trainingData.end())
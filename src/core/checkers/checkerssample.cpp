@@ -0,0 +1,187 @@
+#include "checkerssample.hpp"
+
+#include "tarsmath/linear_algebra/matrix_component.hpp"
+#include "ntars/base/model_format.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace NETWORK
+{
+    struct CheckersSampleHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t numSamples;
+        uint64_t payloadChecksum;
+    };
+
+    constexpr char checkersSampleMagic[4] = {'T', 'C', 'K', 'S'};
+    constexpr uint32_t checkersSampleVersion = 1;
+    constexpr size_t checkersRecordSize = sizeof(BoardStruct) + 1;
+
+    void expandBoard(const BoardStruct& board, float* out)
+    {
+        // MAX wins a square claimed by both sides, as it always did
+        const uint64_t maxPieces = board.board_state[MAX] & board.occupiedBoard;
+        const uint64_t minPieces = board.board_state[MIN] & board.occupiedBoard & ~maxPieces;
+        const uint64_t queens = board.queenBoard & (maxPieces | minPieces);
+
+        #ifdef USE_SIMD
+        // eight squares per step, each lane tests its own bit of the step's byte
+        const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 three = _mm256_set1_ps(3.0f);
+
+        auto squares = [&](uint64_t pieces, size_t step) {
+            const __m256i byte = _mm256_set1_epi32(static_cast<int32_t>((pieces >> (step * 8)) & 0xFF));
+            return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(byte, bits), bits));
+        };
+
+        for (size_t step = 0; step < 8; ++step)
+        {
+            __m256 value = _mm256_and_ps(squares(maxPieces, step), one);
+            value = _mm256_add_ps(value, _mm256_and_ps(squares(minPieces, step), three));
+            value = _mm256_add_ps(value, _mm256_and_ps(squares(queens, step), one));
+            _mm256_storeu_ps(out + step * 8, value);
+        }
+        #else
+        for (size_t i = 0; i < checkersSquares; ++i)
+        {
+            out[i] = static_cast<float>((maxPieces >> i) & 1) + 3.0f * static_cast<float>((minPieces >> i) & 1)
+                + static_cast<float>((queens >> i) & 1);
+        }
+        #endif
+    }
+
+    void expandSamples(std::span<const CheckersSample> samples, std::vector<NTARS::DATA::TrainingData<std::vector<float>>>& out)
+    {
+        out.resize(samples.size());
+
+        for (size_t i = 0; i < samples.size(); ++i)
+        {
+            out[i].data.resize(checkersSquares);
+            expandBoard(samples[i].board, out[i].data.data());
+
+            out[i].label.assign(checkersSquares, 0.0f);
+            out[i].label[samples[i].moveSquare] = 1.0f;
+        }
+    }
+
+    CheckersSample compressSample(std::span<const float> board, std::span<const float> label)
+    {
+        CheckersSample sample{};
+
+        for (size_t i = 0; i < std::min(board.size(), checkersSquares); ++i)
+        {
+            const uint64_t bit = 1ULL << i;
+            const int32_t piece = static_cast<int32_t>(std::lround(board[i]));
+            if (piece < 1 || piece > 4)
+                continue;
+
+            sample.board.board_state[piece <= 2 ? MAX : MIN] |= bit;
+            sample.board.occupiedBoard |= bit;
+            if (piece == 2 || piece == 4)
+                sample.board.queenBoard |= bit;
+        }
+
+        const size_t labelSize = std::min(label.size(), checkersSquares);
+        sample.moveSquare = static_cast<uint8_t>(std::max_element(label.begin(), label.begin() + labelSize) - label.begin());
+
+        return sample;
+    }
+
+    bool saveCheckersSamples(std::span<const CheckersSample> samples, const std::filesystem::path& path)
+    {
+        std::vector<char> payload(samples.size() * checkersRecordSize);
+        for (size_t i = 0; i < samples.size(); ++i)
+        {
+            char* record = payload.data() + i * checkersRecordSize;
+            std::memcpy(record, &samples[i].board, sizeof(BoardStruct));
+            record[sizeof(BoardStruct)] = static_cast<char>(samples[i].moveSquare);
+        }
+
+        CheckersSampleHeader header{};
+        std::memcpy(header.magic, checkersSampleMagic, sizeof(header.magic));
+        header.version = checkersSampleVersion;
+        header.numSamples = samples.size();
+        header.payloadChecksum = NTARS::FORMAT::checksum(payload.data(), payload.size());
+
+        if (path.has_parent_path())
+        {
+            std::error_code error;
+            std::filesystem::create_directories(path.parent_path(), error);
+        }
+
+        std::filesystem::path tempPath = path;
+        tempPath += ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(payload.data(), payload.size());
+            if (!out.good())
+            {
+                std::cerr << "Could not open file for writing: " << tempPath << std::endl;
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, path, error);
+        if (error)
+        {
+            std::cerr << "Could not open file for writing: " << path << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    std::vector<CheckersSample> loadCheckersSamples(const std::filesystem::path& path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open())
+        {
+            std::cerr << "Could not open file for reading: " << path << std::endl;
+            return {};
+        }
+
+        CheckersSampleHeader header{};
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!in.good() || std::memcmp(header.magic, checkersSampleMagic, sizeof(header.magic)) != 0 || header.version != checkersSampleVersion)
+        {
+            std::cerr << "Not a checkers sample file: " << path << std::endl;
+            return {};
+        }
+
+        // the count comes from the file, it has to fit in the file before anything is sized from it
+        std::error_code error;
+        const uintmax_t fileSize = std::filesystem::file_size(path, error);
+        if (error || fileSize < sizeof(header) || header.numSamples > (fileSize - sizeof(header)) / checkersRecordSize)
+        {
+            std::cerr << "Checkers sample file is truncated or corrupt: " << path << std::endl;
+            return {};
+        }
+
+        std::vector<char> payload(header.numSamples * checkersRecordSize);
+        in.read(payload.data(), payload.size());
+        if (static_cast<size_t>(in.gcount()) != payload.size() || NTARS::FORMAT::checksum(payload.data(), payload.size()) != header.payloadChecksum)
+        {
+            std::cerr << "Checkers sample file is truncated or corrupt: " << path << std::endl;
+            return {};
+        }
+
+        std::vector<CheckersSample> samples(header.numSamples);
+        for (size_t i = 0; i < samples.size(); ++i)
+        {
+            const char* record = payload.data() + i * checkersRecordSize;
+            std::memcpy(&samples[i].board, record, sizeof(BoardStruct));
+            samples[i].moveSquare = static_cast<uint8_t>(record[sizeof(BoardStruct)]) & 63;
+        }
+
+        return samples;
+    }
+} // namespace NETWORK
@@ -0,0 +1,40 @@
+#ifndef CHECKERS_SAMPLE_HPP
+#define CHECKERS_SAMPLE_HPP
+
+#include <stdint.h>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "ntars/base/data.hpp"
+#include "board.hpp"
+
+namespace NETWORK
+{
+    // A position the minimax searched: its four bitboards and the square the chosen move lands on. The network
+    // sees it as 64 floats of board and a 64 float one-hot label, 512 bytes that are only made per batch by
+    // expandSamples; kept like this it is 40 bytes in memory and 33 on disk
+    struct CheckersSample
+    {
+        BoardStruct board;
+        uint8_t moveSquare;
+    };
+
+    constexpr size_t checkersSquares = 64;
+
+    // 0 empty, 1 MAX man, 2 MAX queen, 3 MIN man, 4 MIN queen per square
+    void expandBoard(const BoardStruct& board, float* out);
+
+    // Rewrites out as the network samples of these positions, reusing the capacity of its vectors so a batch
+    // loop allocates nothing after its first batch
+    void expandSamples(std::span<const CheckersSample> samples, std::vector<NTARS::DATA::TrainingData<std::vector<float>>>& out);
+
+    // The position behind an expanded sample, for datasets saved before the compact format
+    CheckersSample compressSample(std::span<const float> board, std::span<const float> label);
+
+    // "TCKS" header, then 32 bytes of bitboards and the move square per sample
+    bool saveCheckersSamples(std::span<const CheckersSample> samples, const std::filesystem::path& path);
+    std::vector<CheckersSample> loadCheckersSamples(const std::filesystem::path& path);
+} // namespace NETWORK
+
+#endif // CHECKERS_SAMPLE_HPP
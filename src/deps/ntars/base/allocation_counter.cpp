@@ -0,0 +1,104 @@
+#include "telemetry.hpp"
+
+// Replacing the global allocation functions changes the allocator of the whole program and adds a counter to
+// every allocation in it, so it is only built when NTARS_COUNT_ALLOCATIONS is defined
+#ifdef NTARS_COUNT_ALLOCATIONS
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    // plain thread_local, so the counter needs no initialization and is safe to touch from operator new
+    thread_local uint64_t threadAllocations = 0;
+
+    void* allocate(std::size_t size)
+    {
+        ++threadAllocations;
+        if (size == 0)
+            size = 1;
+
+        while (true)
+        {
+            if (void* ptr = std::malloc(size))
+                return ptr;
+
+            std::new_handler handler = std::get_new_handler();
+            if (!handler)
+                throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment)
+    {
+        ++threadAllocations;
+        const std::size_t align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+
+        while (true)
+        {
+            #ifdef _WIN32
+            void* ptr = _aligned_malloc(size == 0 ? 1 : size, align);
+            #else
+            void* ptr = nullptr;
+            if (posix_memalign(&ptr, align, size == 0 ? 1 : size) != 0)
+                ptr = nullptr;
+            #endif
+
+            if (ptr)
+                return ptr;
+
+            std::new_handler handler = std::get_new_handler();
+            if (!handler)
+                throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    void freeAligned(void* ptr)
+    {
+        #ifdef _WIN32
+        _aligned_free(ptr);
+        #else
+        std::free(ptr);
+        #endif
+    }
+} // namespace
+
+// The array forms forward to these by default
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size); }
+    catch (...) { return nullptr; }
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try { return allocateAligned(size, alignment); }
+    catch (...) { return nullptr; }
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { freeAligned(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { freeAligned(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(ptr); }
+
+#endif // NTARS_COUNT_ALLOCATIONS
+
+namespace NTARS
+{
+    uint64_t getThreadAllocationCount()
+    {
+        #ifdef NTARS_COUNT_ALLOCATIONS
+        return threadAllocations;
+        #else
+        return 0;
+        #endif
+    }
+} // namespace NTARS
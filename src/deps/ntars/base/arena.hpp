@@ -0,0 +1,245 @@
+#ifndef NTARS_ARENA_HPP
+#define NTARS_ARENA_HPP
+
+#include "tarsmath/linear_algebra/bfloat16.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace NTARS
+{
+    // Single aligned allocation holding every buffer one thread needs for a training step.
+    // Buffers are [batch x width] row-major, laid out back to back at offsets fixed by plan().
+    //
+    // With a checkpoint interval k > 1 the layers are cut into segments of k. Only the output of each segment's
+    // last layer is kept, the layers in between share k segment buffers and are recomputed during backward,
+    // and the deltas ping-pong between two buffers. Pre-activations are not stored in that mode.
+    class TrainingArena
+    {
+    public:
+        static constexpr size_t alignment = 64;
+
+        // Grows the allocation if needed, replanning the same shape is free
+        void plan(const std::vector<size_t>& structure, size_t batchSize, size_t checkpointInterval = 0)
+        {
+            if (checkpointInterval < 2)
+                checkpointInterval = 0;
+
+            if (structure == plannedStructure && batchSize == plannedBatchSize && checkpointInterval == plannedInterval)
+                return;
+
+            const size_t floats = layout(structure, batchSize, checkpointInterval);
+            if (floats > capacity)
+            {
+                buffer.reset(static_cast<float*>(::operator new[](floats * sizeof(float), std::align_val_t(alignment))));
+                capacity = floats;
+            }
+
+            plannedStructure = structure;
+            plannedBatchSize = batchSize;
+            plannedInterval = checkpointInterval;
+        }
+
+        // Bytes a plan of this shape needs, without allocating anything
+        static size_t requiredBytes(const std::vector<size_t>& structure, size_t batchSize, size_t checkpointInterval = 0)
+        {
+            TrainingArena arena;
+            return arena.layout(structure, batchSize, checkpointInterval < 2 ? 0 : checkpointInterval) * sizeof(float);
+        }
+
+        inline float* input() { return buffer.get() + inputOffset; }
+        inline float* activations(size_t layer) { return buffer.get() + activationOffsets[layer]; }
+        inline float* preActivations(size_t layer) { return buffer.get() + preActivationOffsets[layer]; }
+        // Per layer, or one of the two ping-pong buffers when checkpointing
+        inline float* deltas(size_t layer) { return buffer.get() + deltaOffsets[layer]; }
+
+        // Checkpointed plans: output of the layer, wherever the current segment keeps it
+        inline float* layerOutput(size_t layer)
+        {
+            const size_t segment = layer / plannedInterval;
+            if (layer % plannedInterval == plannedInterval - 1 && segment < checkpointOffsets.size())
+                return buffer.get() + checkpointOffsets[segment];
+
+            return buffer.get() + segmentOffsets[layer % plannedInterval];
+        }
+
+        inline size_t getBatchSize() const { return plannedBatchSize; }
+        inline size_t getCheckpointInterval() const { return plannedInterval; }
+        inline size_t getBytes() const { return capacity * sizeof(float); }
+
+    private:
+        size_t layout(const std::vector<size_t>& structure, size_t batchSize, size_t checkpointInterval)
+        {
+            const size_t numLayers = structure.size() - 1;
+            size_t offset = 0;
+
+            auto reserve = [&](size_t width) {
+                size_t start = offset;
+                offset += roundUp(width * batchSize);
+                return start;
+            };
+
+            inputOffset = reserve(structure.front());
+
+            activationOffsets.clear();
+            preActivationOffsets.clear();
+            deltaOffsets.clear();
+            checkpointOffsets.clear();
+            segmentOffsets.clear();
+
+            if (checkpointInterval == 0)
+            {
+                for (size_t l = 0; l < numLayers; ++l)
+                {
+                    activationOffsets.push_back(reserve(structure[l + 1]));
+                    preActivationOffsets.push_back(reserve(structure[l + 1]));
+                    deltaOffsets.push_back(reserve(structure[l + 1]));
+                }
+
+                return offset;
+            }
+
+            const size_t widest = *std::max_element(structure.begin() + 1, structure.end());
+            const size_t numSegments = (numLayers + checkpointInterval - 1) / checkpointInterval;
+
+            // the last segment's output is the network output, it stays in its segment buffer
+            for (size_t segment = 0; segment + 1 < numSegments; ++segment)
+                checkpointOffsets.push_back(reserve(structure[(segment + 1) * checkpointInterval]));
+
+            for (size_t slot = 0; slot < std::min(checkpointInterval, numLayers); ++slot)
+                segmentOffsets.push_back(reserve(widest));
+
+            deltaOffsets.push_back(reserve(widest));
+            deltaOffsets.push_back(reserve(widest));
+
+            return offset;
+        }
+
+        static constexpr size_t roundUp(size_t floats)
+        {
+            constexpr size_t floatsPerLine = alignment / sizeof(float);
+            return (floats + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+        }
+
+        struct AlignedDeleter
+        {
+            void operator()(float* ptr) const { ::operator delete[](ptr, std::align_val_t(alignment)); }
+        };
+
+        std::unique_ptr<float[], AlignedDeleter> buffer;
+        size_t capacity{0};
+
+        std::vector<size_t> plannedStructure;
+        size_t plannedBatchSize{0};
+        size_t plannedInterval{0};
+
+        size_t inputOffset{0};
+        std::vector<size_t> activationOffsets;
+        std::vector<size_t> preActivationOffsets;
+        std::vector<size_t> deltaOffsets;
+        std::vector<size_t> checkpointOffsets;
+        std::vector<size_t> segmentOffsets;
+    };
+
+    // Whole-batch buffers for BF16 training, shared by every thread: BF16 copies of the weights, the
+    // activations of every layer (layer 0 is the input) and the deltas, plus a small FP32 scratch per thread.
+    // The weight gradient pass reads all samples at once, so nothing is kept per thread beyond the scratch.
+    class MixedPrecisionArena
+    {
+    public:
+        static constexpr size_t alignment = 64;
+
+        void plan(const std::vector<size_t>& structure, size_t batchSize, size_t numThreads, size_t microBatch)
+        {
+            if (structure == plannedStructure && batchSize == plannedBatchSize && numThreads == plannedThreads && microBatch == plannedMicroBatch)
+                return;
+
+            const size_t numLayers = structure.size() - 1;
+            size_t offset = 0;
+
+            auto reserve = [&](size_t elements) {
+                size_t start = offset;
+                offset += roundUp(elements);
+                return start;
+            };
+
+            weightOffsets.resize(numLayers);
+            for (size_t l = 0; l < numLayers; ++l)
+                weightOffsets[l] = reserve(structure[l + 1] * structure[l]);
+
+            activationOffsets.resize(numLayers + 1);
+            for (size_t l = 0; l <= numLayers; ++l)
+                activationOffsets[l] = reserve(structure[l] * batchSize);
+
+            deltaOffsets.resize(numLayers);
+            for (size_t l = 0; l < numLayers; ++l)
+                deltaOffsets[l] = reserve(structure[l + 1] * batchSize);
+
+            if (offset > capacity)
+            {
+                buffer.reset(static_cast<TMATH::bf16_t*>(::operator new[](offset * sizeof(TMATH::bf16_t), std::align_val_t(alignment))));
+                capacity = offset;
+            }
+
+            // pre-activations of one micro-batch, then one FP32 delta row
+            const size_t widest = *std::max_element(structure.begin(), structure.end());
+            deltaRowOffset = roundUp(microBatch * widest);
+            scratchStride = deltaRowOffset + roundUp(widest);
+            if (scratchStride * numThreads > scratchCapacity)
+            {
+                scratch.reset(static_cast<float*>(::operator new[](scratchStride * numThreads * sizeof(float), std::align_val_t(alignment))));
+                scratchCapacity = scratchStride * numThreads;
+            }
+
+            plannedStructure = structure;
+            plannedBatchSize = batchSize;
+            plannedThreads = numThreads;
+            plannedMicroBatch = microBatch;
+        }
+
+        inline TMATH::bf16_t* weights(size_t layer) { return buffer.get() + weightOffsets[layer]; }
+        inline TMATH::bf16_t* activations(size_t layer) { return buffer.get() + activationOffsets[layer]; }
+        inline TMATH::bf16_t* deltas(size_t layer) { return buffer.get() + deltaOffsets[layer]; }
+
+        inline float* preActivations(size_t thread) { return scratch.get() + thread * scratchStride; }
+        inline float* deltaRow(size_t thread) { return scratch.get() + thread * scratchStride + deltaRowOffset; }
+
+        inline size_t getBatchSize() const { return plannedBatchSize; }
+        inline size_t getBytes() const { return capacity * sizeof(TMATH::bf16_t) + scratchCapacity * sizeof(float); }
+
+    private:
+        static constexpr size_t roundUp(size_t elements)
+        {
+            constexpr size_t perLine = alignment / sizeof(TMATH::bf16_t);
+            return (elements + perLine - 1) / perLine * perLine;
+        }
+
+        template<typename T>
+        struct AlignedDeleter
+        {
+            void operator()(T* ptr) const { ::operator delete[](ptr, std::align_val_t(alignment)); }
+        };
+
+        std::unique_ptr<TMATH::bf16_t[], AlignedDeleter<TMATH::bf16_t>> buffer;
+        size_t capacity{0};
+
+        std::unique_ptr<float[], AlignedDeleter<float>> scratch;
+        size_t scratchCapacity{0};
+        size_t scratchStride{0};
+        size_t deltaRowOffset{0};
+
+        std::vector<size_t> plannedStructure;
+        size_t plannedBatchSize{0};
+        size_t plannedThreads{0};
+        size_t plannedMicroBatch{0};
+
+        std::vector<size_t> weightOffsets;
+        std::vector<size_t> activationOffsets;
+        std::vector<size_t> deltaOffsets;
+    };
+} // namespace NTARS
+
+#endif // NTARS_ARENA_HPP
@@ -0,0 +1,160 @@
+#include "checkpoint.hpp"
+#include "mapped_file.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+namespace NTARS
+{
+    void CheckpointSnapshot::clear()
+    {
+        entries.clear();
+        data.clear();
+    }
+
+    void CheckpointSnapshot::addTensor(FORMAT::TensorKind_ kind, uint32_t layer, uint32_t slot, size_t rows, size_t cols, const float* source)
+    {
+        FORMAT::TensorEntry entry{};
+        entry.kind = kind;
+        entry.layer = layer;
+        entry.slot = slot;
+        entry.rows = rows;
+        entry.cols = cols;
+        entry.offset = data.size();
+
+        entries.push_back(entry);
+        data.insert(data.end(), source, source + rows * cols);
+    }
+
+    void CheckpointSnapshot::addBlob(FORMAT::TensorKind_ kind, uint32_t layer, const void* source, size_t bytes)
+    {
+        FORMAT::TensorEntry entry{};
+        entry.kind = kind;
+        entry.layer = layer;
+        entry.rows = 1;
+        entry.cols = bytes / sizeof(float);
+        entry.offset = data.size();
+
+        entries.push_back(entry);
+        data.resize(data.size() + entry.cols);
+        std::memcpy(data.data() + entry.offset, source, entry.cols * sizeof(float));
+    }
+
+    Checkpointer::Checkpointer(const std::filesystem::path& path)
+        : path(path)
+    {
+        writer = std::thread([this]() { writerLoop(); });
+    }
+
+    Checkpointer::~Checkpointer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+
+        if (writer.joinable())
+            writer.join();
+    }
+
+    CheckpointSnapshot& Checkpointer::beginSnapshot()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        assert(filling < 0 && "beginSnapshot() called twice without commit()");
+
+        filling = writing == 0 ? 1 : 0;
+
+        // the writer hasn't picked it up yet, the snapshot about to be taken supersedes it
+        if (pending == filling)
+            pending = -1;
+
+        buffers[filling].clear();
+        return buffers[filling];
+    }
+
+    void Checkpointer::commit()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            assert(filling >= 0 && "commit() called without beginSnapshot()");
+
+            pending = filling;
+            filling = -1;
+        }
+        condition.notify_all();
+    }
+
+    void Checkpointer::flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&]() { return pending < 0 && writing < 0; });
+    }
+
+    void Checkpointer::writerLoop()
+    {
+        while (true)
+        {
+            int32_t index;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [&]() { return stopping || pending >= 0; });
+
+                if (pending < 0)
+                    return;
+
+                index = writing = pending;
+                pending = -1;
+            }
+
+            if (writeSnapshot(buffers[index]))
+                ++written;
+            else
+                ++failed;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                writing = -1;
+            }
+            condition.notify_all();
+        }
+    }
+
+    bool Checkpointer::writeSnapshot(const CheckpointSnapshot& snapshot) const
+    {
+        FORMAT::ModelWriter modelWriter;
+        for (const auto& entry : snapshot.entries)
+        {
+            modelWriter.addTensor(static_cast<FORMAT::TensorKind_>(entry.kind), entry.layer, entry.slot,
+                entry.rows, entry.cols, snapshot.data.data() + entry.offset);
+        }
+        modelWriter.addBlob(FORMAT::TensorKind_TrainingState, &snapshot.record, sizeof(snapshot.record));
+
+        // the previous checkpoint stays in place until the new one is fully on disk
+        std::filesystem::path tempPath = path;
+        tempPath += ".tmp";
+
+        if (path.has_parent_path())
+        {
+            std::error_code directoryError;
+            std::filesystem::create_directories(path.parent_path(), directoryError);
+        }
+
+        if (!modelWriter.write(tempPath, snapshot.structure, snapshot.name, snapshot.flags) || !syncFile(tempPath))
+        {
+            std::cerr << "Could not write checkpoint: " << tempPath.string() << std::endl;
+            return false;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, path, error);
+        if (error)
+        {
+            std::cerr << "Could not replace checkpoint " << path.string() << ": " << error.message() << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+} // namespace NTARS
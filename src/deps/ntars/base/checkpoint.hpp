@@ -0,0 +1,111 @@
+#ifndef NTARS_CHECKPOINT_HPP
+#define NTARS_CHECKPOINT_HPP
+
+#include "ntars/base/model_format.hpp"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace NTARS
+{
+    // Where a training loop is, enough to replay the same batch order after a restart
+    struct TrainingProgress
+    {
+        uint64_t epoch{0};
+        uint64_t batch{0};          // batches finished in the current epoch
+        uint64_t rngSeed{0};
+        uint64_t rngPosition{0};    // draws taken from the seeded generator before the current epoch
+        float learningRate{1.0f};
+        uint32_t reserved{0};
+    };
+
+    // Stored next to the tensors of a checkpoint as a TensorKind_TrainingState blob
+    struct CheckpointRecord
+    {
+        uint32_t optimizerType;     // OptimizerType_
+        uint32_t reserved;
+        uint64_t optimizerStep;
+        TrainingProgress progress;
+    };
+
+    // What a network carries from one training step to the next besides its parameters and optimizer, a second
+    // TensorKind_TrainingState blob (layer 1) followed by the position of every dropout stream
+    struct CheckpointStepState
+    {
+        float lossScale;
+        uint32_t dynamicLossScale;
+        uint64_t cleanSteps;
+        uint64_t skippedSteps;
+        uint64_t dropoutSeed;
+        uint64_t numDropoutStreams;
+    };
+
+    // Owned copy of everything a checkpoint holds, so the writer thread never reads live training buffers
+    struct CheckpointSnapshot
+    {
+        std::vector<size_t> structure;
+        std::string name;
+        uint32_t flags{0};
+        CheckpointRecord record{};
+
+        // offsets in the entries index into data, which keeps its capacity between snapshots
+        std::vector<FORMAT::TensorEntry> entries;
+        std::vector<float> data;
+
+        void clear();
+        void addTensor(FORMAT::TensorKind_ kind, uint32_t layer, uint32_t slot, size_t rows, size_t cols, const float* source);
+        // Untyped record, bytes has to be a multiple of sizeof(float)
+        void addBlob(FORMAT::TensorKind_ kind, uint32_t layer, const void* source, size_t bytes);
+    };
+
+    // Writes checkpoints from a background thread through a double buffer. The training thread fills the
+    // buffer that isn't being written; a snapshot still waiting for the writer is replaced by a newer one.
+    class Checkpointer
+    {
+    public:
+        explicit Checkpointer(const std::filesystem::path& path);
+        ~Checkpointer();
+
+        Checkpointer(const Checkpointer&) = delete;
+        Checkpointer& operator=(const Checkpointer&) = delete;
+
+        // Never blocks on disk I/O, the returned buffer belongs to the caller until commit()
+        CheckpointSnapshot& beginSnapshot();
+        void commit();
+
+        // Waits until every committed snapshot is on disk
+        void flush();
+
+        inline const std::filesystem::path& getPath() const { return path; }
+        inline uint64_t getWrittenCount() const { return written; }
+        inline uint64_t getFailedCount() const { return failed; }
+
+    private:
+        void writerLoop();
+        bool writeSnapshot(const CheckpointSnapshot& snapshot) const;
+
+        std::filesystem::path path;
+        std::array<CheckpointSnapshot, 2> buffers;
+
+        int32_t filling{-1};
+        int32_t pending{-1};
+        int32_t writing{-1};
+        bool stopping{false};
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::thread writer;
+
+        std::atomic<uint64_t> written{0};
+        std::atomic<uint64_t> failed{0};
+    };
+} // namespace NTARS
+
+#endif // NTARS_CHECKPOINT_HPP
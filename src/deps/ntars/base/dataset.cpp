@@ -0,0 +1,433 @@
+#include "dataset.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace NTARS
+{
+    namespace DATA
+    {
+        // records are buffered up to this size before they are written
+        static constexpr size_t chunkBytes = 1 << 20;
+
+        std::filesystem::path shardPath(const std::filesystem::path& path, size_t shard)
+        {
+            std::filesystem::path result = path;
+            result += "." + std::to_string(shard);
+            return result;
+        }
+
+        static void createParentDirectory(const std::filesystem::path& path)
+        {
+            if (path.has_parent_path())
+            {
+                std::error_code error;
+                std::filesystem::create_directories(path.parent_path(), error);
+            }
+        }
+
+        static ShardHeader makeShardHeader(size_t dataSize, size_t labelSize, size_t firstSample, size_t numSamples)
+        {
+            ShardHeader header{};
+            std::memcpy(header.magic, shardMagic, sizeof(header.magic));
+            header.version = datasetVersion;
+            header.dataSize = static_cast<uint32_t>(dataSize);
+            header.labelSize = static_cast<uint32_t>(labelSize);
+            header.firstSample = firstSample;
+            header.numSamples = numSamples;
+
+            return header;
+        }
+
+        // Header padded to the payload offset, the records start right after
+        static void writeShardHeader(std::ofstream& out, const ShardHeader& header)
+        {
+            char padded[shardPayloadOffset]{};
+            std::memcpy(padded, &header, sizeof(header));
+            out.write(padded, sizeof(padded));
+        }
+
+        // Written next to the index and renamed, the index only ever describes shards that are complete
+        static bool writeIndex(const std::filesystem::path& path, size_t dataSize, size_t labelSize, size_t numSamples, size_t samplesPerShard,
+            const std::vector<ShardEntry>& shards)
+        {
+            DatasetHeader header{};
+            std::memcpy(header.magic, datasetMagic, sizeof(header.magic));
+            header.version = datasetVersion;
+            header.dataSize = static_cast<uint32_t>(dataSize);
+            header.labelSize = static_cast<uint32_t>(labelSize);
+            header.numSamples = numSamples;
+            header.samplesPerShard = samplesPerShard;
+            header.numShards = static_cast<uint32_t>(shards.size());
+
+            createParentDirectory(path);
+
+            std::filesystem::path tempPath = path;
+            tempPath += ".tmp";
+            {
+                std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+                out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                out.write(reinterpret_cast<const char*>(shards.data()), shards.size() * sizeof(ShardEntry));
+                if (!out.good())
+                {
+                    std::cerr << "Could not open file for writing: " << tempPath << std::endl;
+                    return false;
+                }
+            }
+
+            std::error_code error;
+            std::filesystem::rename(tempPath, path, error);
+            if (error)
+            {
+                std::cerr << "Could not open file for writing: " << path << std::endl;
+                return false;
+            }
+
+            // shards of an older, larger dataset at the same path
+            for (size_t k = shards.size(); std::filesystem::exists(shardPath(path, k)); ++k)
+                std::filesystem::remove(shardPath(path, k), error);
+
+            return true;
+        }
+
+        DatasetWriter::DatasetWriter(const std::filesystem::path& path, size_t samplesPerShard)
+            : path(path), samplesPerShard(std::max<size_t>(1, samplesPerShard))
+        {
+        }
+
+        DatasetWriter::~DatasetWriter()
+        {
+            if (!finished)
+                finish();
+        }
+
+        bool DatasetWriter::add(std::span<const float> data, std::span<const float> label)
+        {
+            if (failed || finished)
+                return false;
+
+            if (numSamples == 0)
+            {
+                dataSize = data.size();
+                labelSize = label.size();
+            }
+            else if (data.size() != dataSize || label.size() != labelSize)
+            {
+                std::cerr << "Sample of " << data.size() << " + " << label.size() << " floats does not fit a dataset of " << dataSize << " + "
+                          << labelSize << std::endl;
+                return false;
+            }
+
+            if (!shard.is_open() && !openShard())
+                return false;
+
+            chunk.insert(chunk.end(), data.begin(), data.end());
+            chunk.insert(chunk.end(), label.begin(), label.end());
+            ++shardSamples;
+            ++numSamples;
+
+            if (chunk.size() * sizeof(float) >= chunkBytes && !flushChunk())
+                return false;
+
+            if (shardSamples == samplesPerShard)
+                return closeShard();
+
+            return true;
+        }
+
+        bool DatasetWriter::finish()
+        {
+            if (finished)
+                return !failed;
+
+            finished = true;
+            if (shard.is_open() && !closeShard())
+                return false;
+
+            failed = failed || !writeIndex(path, dataSize, labelSize, numSamples, samplesPerShard, shards);
+            return !failed;
+        }
+
+        bool DatasetWriter::openShard()
+        {
+            const std::filesystem::path file = shardPath(path, shards.size());
+            createParentDirectory(file);
+
+            // the header is rewritten with the final count when the shard is closed
+            shard.open(file, std::ios::binary | std::ios::trunc);
+            writeShardHeader(shard, makeShardHeader(dataSize, labelSize, shards.size() * samplesPerShard, 0));
+            if (!shard.good())
+            {
+                std::cerr << "Could not open file for writing: " << file << std::endl;
+                shard.close();
+                failed = true;
+                return false;
+            }
+
+            shardSamples = 0;
+            shardChecksum = FORMAT::Checksum{};
+            return true;
+        }
+
+        bool DatasetWriter::flushChunk()
+        {
+            shard.write(reinterpret_cast<const char*>(chunk.data()), chunk.size() * sizeof(float));
+            shardChecksum.update(chunk.data(), chunk.size() * sizeof(float));
+            chunk.clear();
+
+            if (!shard.good())
+            {
+                std::cerr << "Could not write dataset shard " << shards.size() << " of " << path << std::endl;
+                failed = true;
+            }
+
+            return !failed;
+        }
+
+        bool DatasetWriter::closeShard()
+        {
+            if (!flushChunk())
+                return false;
+
+            shard.seekp(0);
+            writeShardHeader(shard, makeShardHeader(dataSize, labelSize, shards.size() * samplesPerShard, shardSamples));
+            shard.close();
+            if (shard.fail())
+            {
+                std::cerr << "Could not write dataset shard " << shards.size() << " of " << path << std::endl;
+                failed = true;
+                return false;
+            }
+
+            shards.push_back({shardSamples, shardChecksum.value()});
+            return true;
+        }
+
+        static bool writeShard(const std::filesystem::path& file, std::span<const TrainingData<std::vector<float>>> samples, size_t firstSample,
+            size_t dataSize, size_t labelSize, ShardEntry& entry)
+        {
+            std::ofstream out(file, std::ios::binary | std::ios::trunc);
+            writeShardHeader(out, makeShardHeader(dataSize, labelSize, firstSample, samples.size()));
+
+            FORMAT::Checksum checksum;
+            std::vector<float> chunk;
+            chunk.reserve(chunkBytes / sizeof(float) + dataSize + labelSize);
+            for (size_t i = 0; i < samples.size(); ++i)
+            {
+                chunk.insert(chunk.end(), samples[i].data.begin(), samples[i].data.end());
+                chunk.insert(chunk.end(), samples[i].label.begin(), samples[i].label.end());
+
+                if (chunk.size() * sizeof(float) >= chunkBytes || i + 1 == samples.size())
+                {
+                    out.write(reinterpret_cast<const char*>(chunk.data()), chunk.size() * sizeof(float));
+                    checksum.update(chunk.data(), chunk.size() * sizeof(float));
+                    chunk.clear();
+                }
+            }
+
+            if (!out.good())
+            {
+                std::cerr << "Could not open file for writing: " << file << std::endl;
+                return false;
+            }
+
+            entry = {samples.size(), checksum.value()};
+            return true;
+        }
+
+        bool saveDataset(std::span<const TrainingData<std::vector<float>>> samples, const std::filesystem::path& path, size_t samplesPerShard,
+            size_t numThreads)
+        {
+            samplesPerShard = std::max<size_t>(1, samplesPerShard);
+
+            const size_t dataSize = samples.empty() ? 0 : samples.front().data.size();
+            const size_t labelSize = samples.empty() ? 0 : samples.front().label.size();
+            for (const auto& sample : samples)
+            {
+                if (sample.data.size() != dataSize || sample.label.size() != labelSize)
+                {
+                    std::cerr << "Every sample of a dataset needs the same data and label sizes" << std::endl;
+                    return false;
+                }
+            }
+
+            createParentDirectory(path);
+
+            const size_t numShards = (samples.size() + samplesPerShard - 1) / samplesPerShard;
+            if (numThreads == 0)
+                numThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+            numThreads = std::min(numThreads, numShards);
+
+            std::vector<ShardEntry> shards(numShards);
+            std::atomic<size_t> nextShard{0};
+            std::atomic<bool> written{true};
+
+            auto worker = [&]()
+            {
+                for (size_t k = nextShard++; k < numShards; k = nextShard++)
+                {
+                    const size_t first = k * samplesPerShard;
+                    const size_t count = std::min(samplesPerShard, samples.size() - first);
+                    if (!writeShard(shardPath(path, k), samples.subspan(first, count), first, dataSize, labelSize, shards[k]))
+                        written = false;
+                }
+            };
+
+            std::vector<std::thread> workers;
+            for (size_t t = 1; t < numThreads; ++t)
+                workers.emplace_back(worker);
+            worker();
+
+            for (std::thread& thread : workers)
+                thread.join();
+
+            return written && writeIndex(path, dataSize, labelSize, samples.size(), samplesPerShard, shards);
+        }
+
+        bool DatasetReader::open(const std::filesystem::path& path, bool verifyPayload)
+        {
+            close();
+
+            std::ifstream in(path, std::ios::binary);
+            if (!in.is_open())
+            {
+                error = "Could not open dataset: " + path.string();
+                return false;
+            }
+
+            if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, datasetMagic, sizeof(header.magic)) != 0)
+            {
+                error = "Not a .tds dataset: " + path.string();
+                return false;
+            }
+
+            if (header.version > datasetVersion || header.samplesPerShard == 0)
+            {
+                error = "Unsupported dataset version in " + path.string();
+                return false;
+            }
+
+            // the counts come from the file, the index has to hold every entry before the table is sized from it
+            std::error_code sizeError;
+            const uintmax_t indexSize = std::filesystem::file_size(path, sizeError);
+            if (sizeError || indexSize < sizeof(header) || header.numShards > (indexSize - sizeof(header)) / sizeof(ShardEntry))
+            {
+                error = "Dataset index is truncated: " + path.string();
+                return false;
+            }
+
+            std::vector<ShardEntry> entries(header.numShards);
+            if (!in.read(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(ShardEntry)))
+            {
+                error = "Dataset index is truncated: " + path.string();
+                return false;
+            }
+
+            stride = size_t(header.dataSize) + header.labelSize;
+
+            size_t total = 0;
+            for (size_t k = 0; k < entries.size(); ++k)
+            {
+                const std::filesystem::path file = shardPath(path, k);
+                auto shard = std::make_unique<MappedFile>();
+                if (!shard->open(file))
+                {
+                    error = "Could not map dataset shard: " + file.string();
+                    return false;
+                }
+
+                // the record count is bounded by the floats the shard holds before it is multiplied out
+                const size_t available = shard->size() < shardPayloadOffset ? 0 : (shard->size() - shardPayloadOffset) / sizeof(float);
+                const bool fits = shard->size() >= shardPayloadOffset && (stride == 0 || entries[k].numSamples <= available / stride);
+                const size_t payloadBytes = fits ? entries[k].numSamples * stride * sizeof(float) : 0;
+
+                const ShardHeader* shardHeader = reinterpret_cast<const ShardHeader*>(shard->data());
+                const bool fullShard = k + 1 == entries.size() ? entries[k].numSamples <= header.samplesPerShard
+                                                               : entries[k].numSamples == header.samplesPerShard;
+                if (!fits || std::memcmp(shardHeader->magic, shardMagic, sizeof(shardHeader->magic)) != 0 ||
+                    shardHeader->dataSize != header.dataSize || shardHeader->labelSize != header.labelSize ||
+                    shardHeader->numSamples != entries[k].numSamples || shardHeader->firstSample != total || !fullShard)
+                {
+                    error = "Dataset shard does not match its index: " + file.string();
+                    return false;
+                }
+
+                if (verifyPayload && FORMAT::checksum(shard->data() + shardPayloadOffset, payloadBytes) != entries[k].payloadChecksum)
+                {
+                    error = "Dataset shard checksum mismatch: " + file.string();
+                    return false;
+                }
+
+                shardRecords.push_back(reinterpret_cast<const float*>(shard->data() + shardPayloadOffset));
+                shards.push_back(std::move(shard));
+                total += entries[k].numSamples;
+            }
+
+            if (total != header.numSamples)
+            {
+                error = "Dataset shards hold " + std::to_string(total) + " samples, the index " + std::to_string(header.numSamples);
+                return false;
+            }
+
+            opened = true;
+            return true;
+        }
+
+        void DatasetReader::close()
+        {
+            shards.clear();
+            shardRecords.clear();
+            header = {};
+            stride = 0;
+            opened = false;
+            error.clear();
+        }
+
+        void DatasetReader::read(size_t first, size_t count, std::vector<TrainingData<std::vector<float>>>& out) const
+        {
+            first = std::min(first, size());
+            count = std::min(count, size() - first);
+
+            out.resize(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                const float* values = record(first + i);
+                out[i].data.assign(values, values + header.dataSize);
+                out[i].label.assign(values + header.dataSize, values + stride);
+            }
+        }
+
+        std::vector<TrainingData<std::vector<float>>> DatasetReader::readAll(size_t numThreads) const
+        {
+            std::vector<TrainingData<std::vector<float>>> samples(size());
+            if (numThreads == 0)
+                numThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+            numThreads = std::max<size_t>(1, std::min(numThreads, size()));
+
+            auto copyRange = [&](size_t t)
+            {
+                const size_t first = size() * t / numThreads;
+                const size_t last = size() * (t + 1) / numThreads;
+                for (size_t i = first; i < last; ++i)
+                {
+                    const float* values = record(i);
+                    samples[i].data.assign(values, values + header.dataSize);
+                    samples[i].label.assign(values + header.dataSize, values + stride);
+                }
+            };
+
+            std::vector<std::thread> workers;
+            for (size_t t = 1; t < numThreads; ++t)
+                workers.emplace_back(copyRange, t);
+            copyRange(0);
+
+            for (std::thread& thread : workers)
+                thread.join();
+
+            return samples;
+        }
+    } // namespace DATA
+} // namespace NTARS
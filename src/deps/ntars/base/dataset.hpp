@@ -0,0 +1,156 @@
+#ifndef NTARS_DATASET_HPP
+#define NTARS_DATASET_HPP
+
+#include "ntars/base/data.hpp"
+#include "ntars/base/mapped_file.hpp"
+#include "ntars/base/model_format.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace NTARS
+{
+    namespace DATA
+    {
+        // .tds dataset, little endian. The index at the given path holds
+        //   DatasetHeader | ShardEntry[numShards]
+        // and shard k lives next to it at <path>.<k>:
+        //   ShardHeader | padding to 64 bytes | records
+        // Every record is dataSize floats of data then labelSize floats of label. Every shard but the last holds
+        // exactly samplesPerShard records, so sample i is found without searching
+        constexpr char datasetMagic[4] = {'T', 'D', 'S', 'I'};
+        constexpr char shardMagic[4] = {'T', 'D', 'S', 'S'};
+        constexpr uint32_t datasetVersion = 1;
+        constexpr size_t shardPayloadOffset = 64;
+        constexpr size_t defaultSamplesPerShard = 1 << 18;
+
+        struct DatasetHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t dataSize;       // floats per sample
+            uint32_t labelSize;
+            uint64_t numSamples;
+            uint64_t samplesPerShard;
+            uint32_t numShards;
+            uint32_t reserved;
+        };
+
+        struct ShardEntry
+        {
+            uint64_t numSamples;
+            uint64_t payloadChecksum;
+        };
+
+        struct ShardHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t dataSize;
+            uint32_t labelSize;
+            uint64_t firstSample;
+            uint64_t numSamples;
+        };
+
+        std::filesystem::path shardPath(const std::filesystem::path& path, size_t shard);
+
+        // Appends samples one at a time. Records collect in a chunk that goes out in one write, a new shard is
+        // started every samplesPerShard samples and the index is written last, so a dataset whose writer never
+        // finished has no index and cannot be opened. The first sample fixes the data and label sizes
+        class DatasetWriter
+        {
+        public:
+            explicit DatasetWriter(const std::filesystem::path& path, size_t samplesPerShard = defaultSamplesPerShard);
+            ~DatasetWriter();
+
+            DatasetWriter(const DatasetWriter&) = delete;
+            DatasetWriter& operator=(const DatasetWriter&) = delete;
+
+            bool add(std::span<const float> data, std::span<const float> label);
+
+            template<typename T>
+            inline bool add(const TrainingData<T>& sample)
+            {
+                return add(std::span<const float>(sample.data.data(), sample.data.size()), std::span<const float>(sample.label));
+            }
+
+            // Closes the last shard and writes the index, the destructor calls it if nobody did
+            bool finish();
+
+            inline size_t size() const { return numSamples; }
+            inline bool good() const { return !failed; }
+
+        private:
+            bool openShard();
+            bool flushChunk();
+            bool closeShard();
+
+            std::filesystem::path path;
+            size_t samplesPerShard;
+            size_t dataSize{0};
+            size_t labelSize{0};
+            size_t numSamples{0};
+
+            std::ofstream shard;
+            size_t shardSamples{0};
+            FORMAT::Checksum shardChecksum;
+            std::vector<ShardEntry> shards;
+
+            std::vector<float> chunk;
+
+            bool finished{false};
+            bool failed{false};
+        };
+
+        // Writes the samples as a .tds dataset, every shard on its own thread
+        bool saveDataset(std::span<const TrainingData<std::vector<float>>> samples, const std::filesystem::path& path,
+            size_t samplesPerShard = defaultSamplesPerShard, size_t numThreads = 0);
+
+        // Maps every shard of a .tds dataset, samples are read in place and only copied when asked to
+        class DatasetReader
+        {
+        public:
+            DatasetReader() = default;
+            explicit DatasetReader(const std::filesystem::path& path) { open(path); }
+
+            bool open(const std::filesystem::path& path, bool verifyPayload = false);
+            void close();
+
+            inline bool isOpen() const { return opened; }
+            inline size_t size() const { return header.numSamples; }
+            inline size_t getDataSize() const { return header.dataSize; }
+            inline size_t getLabelSize() const { return header.labelSize; }
+            inline const std::string& getError() const { return error; }
+
+            inline std::span<const float> data(size_t index) const { return {record(index), header.dataSize}; }
+            inline std::span<const float> label(size_t index) const { return {record(index) + header.dataSize, header.labelSize}; }
+
+            // Copies count samples from first into out, reusing the capacity of its vectors
+            void read(size_t first, size_t count, std::vector<TrainingData<std::vector<float>>>& out) const;
+            // Every sample, copied in parallel
+            std::vector<TrainingData<std::vector<float>>> readAll(size_t numThreads = 0) const;
+
+        private:
+            inline const float* record(size_t index) const
+            {
+                const size_t shard = index / header.samplesPerShard;
+                return shardRecords[shard] + (index - shard * header.samplesPerShard) * stride;
+            }
+
+            DatasetHeader header{};
+            size_t stride{0};   // floats per record
+
+            std::vector<std::unique_ptr<MappedFile>> shards;
+            std::vector<const float*> shardRecords;
+            bool opened{false};
+            std::string error;
+        };
+    } // namespace DATA
+} // namespace NTARS
+
+#endif // NTARS_DATASET_HPP
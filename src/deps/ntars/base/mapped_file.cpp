@@ -0,0 +1,120 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace NTARS
+{
+    bool MappedFile::open(const std::filesystem::path& path)
+    {
+        close();
+
+        #ifdef _WIN32
+        // FlushFileBuffers needs a handle with write access. Sharing read and write lets it open while the writer
+        // that just filled the file, or a reader mapping it, still holds a handle of its own
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE fileMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (fileMapping == nullptr)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        void* view = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr)
+        {
+            CloseHandle(fileMapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        fileHandle = file;
+        mappingHandle = fileMapping;
+        mapping = view;
+        mappedSize = static_cast<size_t>(fileSize.QuadPart);
+        #else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+
+        if (view == MAP_FAILED)
+            return false;
+
+        mapping = view;
+        mappedSize = static_cast<size_t>(info.st_size);
+        #endif
+
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (mapping == nullptr)
+            return;
+
+        #ifdef _WIN32
+        UnmapViewOfFile(mapping);
+        CloseHandle(static_cast<HANDLE>(mappingHandle));
+        CloseHandle(static_cast<HANDLE>(fileHandle));
+        fileHandle = nullptr;
+        mappingHandle = nullptr;
+        #else
+        munmap(mapping, mappedSize);
+        #endif
+
+        mapping = nullptr;
+        mappedSize = 0;
+    }
+
+    bool syncFile(const std::filesystem::path& path)
+    {
+        #ifdef _WIN32
+        // FlushFileBuffers needs a handle with write access. Sharing read and write lets it open while the writer
+        // that just filled the file, or a reader mapping it, still holds a handle of its own
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        const bool flushed = FlushFileBuffers(file) != 0;
+        CloseHandle(file);
+        return flushed;
+        #else
+        int fd = ::open(path.c_str(), O_RDWR);
+        if (fd < 0)
+            return false;
+
+        const bool flushed = fsync(fd) == 0;
+        ::close(fd);
+        return flushed;
+        #endif
+    }
+} // namespace NTARS
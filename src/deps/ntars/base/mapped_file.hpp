@@ -0,0 +1,41 @@
+#ifndef NTARS_MAPPED_FILE_HPP
+#define NTARS_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <filesystem>
+
+namespace NTARS
+{
+    // Read-only memory mapping of a whole file, unmapped on destruction
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::filesystem::path& path) { open(path); }
+        ~MappedFile() { close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool open(const std::filesystem::path& path);
+        void close();
+
+        inline bool isOpen() const { return mapping != nullptr; }
+        inline const std::byte* data() const { return static_cast<const std::byte*>(mapping); }
+        inline size_t size() const { return mappedSize; }
+
+    private:
+        void* mapping{nullptr};
+        size_t mappedSize{0};
+
+        #ifdef _WIN32
+        void* fileHandle{nullptr};
+        void* mappingHandle{nullptr};
+        #endif
+    };
+
+    // Pushes a written file's contents to the disk, so a following rename can not expose a partial file after a crash
+    bool syncFile(const std::filesystem::path& path);
+} // namespace NTARS
+
+#endif // NTARS_MAPPED_FILE_HPP
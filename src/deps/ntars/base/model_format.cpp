@@ -0,0 +1,257 @@
+#include "model_format.hpp"
+
+#include <cstring>
+#include <fstream>
+
+namespace NTARS
+{
+    namespace FORMAT
+    {
+        static constexpr uint64_t alignUp(uint64_t value, uint64_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        static constexpr uint64_t checksumPrime = 0x100000001b3ULL;
+
+        void Checksum::update(const void* data, size_t size)
+        {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            size_t i = 0;
+
+            while (tailSize > 0 && tailSize < 8 && i < size)
+                tail[tailSize++] = bytes[i++];
+
+            if (tailSize == 8)
+            {
+                uint64_t word;
+                std::memcpy(&word, tail, sizeof(word));
+                hash = (hash ^ word) * checksumPrime;
+                tailSize = 0;
+            }
+
+            for (; i + 8 <= size; i += 8)
+            {
+                uint64_t word;
+                std::memcpy(&word, bytes + i, sizeof(word));
+                hash = (hash ^ word) * checksumPrime;
+            }
+
+            for (; i < size; ++i)
+                tail[tailSize++] = bytes[i];
+        }
+
+        uint64_t Checksum::value() const
+        {
+            uint64_t result = hash;
+            for (size_t i = 0; i < tailSize; ++i)
+                result = (result ^ tail[i]) * checksumPrime;
+
+            return result;
+        }
+
+        uint64_t checksum(const void* data, size_t size)
+        {
+            Checksum sum;
+            sum.update(data, size);
+            return sum.value();
+        }
+
+        void ModelWriter::addTensor(TensorKind_ kind, uint32_t layer, uint32_t slot, size_t rows, size_t cols, const float* data)
+        {
+            TensorEntry entry{};
+            entry.kind = kind;
+            entry.layer = layer;
+            entry.slot = slot;
+            entry.rows = rows;
+            entry.cols = cols;
+
+            tensors.push_back({entry, data});
+        }
+
+        void ModelWriter::addBlob(TensorKind_ kind, const void* data, size_t bytes)
+        {
+            TensorEntry entry{};
+            entry.kind = kind;
+            entry.rows = 1;
+            entry.cols = bytes / sizeof(float);
+
+            tensors.push_back({entry, data});
+        }
+
+        bool ModelWriter::write(const std::filesystem::path& path, const std::vector<size_t>& structure, const std::string& name, uint32_t flags) const
+        {
+            FileHeader header{};
+            std::memcpy(header.magic, modelMagic, sizeof(modelMagic));
+            header.version = modelVersion;
+            header.flags = flags;
+            header.dtype = DataType_F32;
+            header.numLayers = static_cast<uint32_t>(structure.size() - 1);
+            header.numTensors = static_cast<uint32_t>(tensors.size());
+            header.nameLength = static_cast<uint32_t>(name.size());
+
+            std::vector<uint64_t> sizes(structure.begin(), structure.end());
+
+            const uint64_t nameBytes = alignUp(name.size(), sizeof(uint64_t));
+            const uint64_t headerBytes = sizeof(FileHeader) + sizes.size() * sizeof(uint64_t) + nameBytes + tensors.size() * sizeof(TensorEntry);
+            header.payloadOffset = alignUp(headerBytes, blobAlignment);
+
+            std::vector<TensorEntry> entries;
+            uint64_t offset = header.payloadOffset;
+            for (const auto& tensor : tensors)
+            {
+                TensorEntry entry = tensor.entry;
+                entry.offset = offset;
+                offset = alignUp(offset + entry.rows * entry.cols * sizeof(float), blobAlignment);
+                entries.push_back(entry);
+            }
+            header.payloadBytes = offset - header.payloadOffset;
+
+            const char padding[blobAlignment] = {};
+
+            Checksum payloadHash;
+            for (size_t t = 0; t < tensors.size(); ++t)
+            {
+                const size_t bytes = entries[t].rows * entries[t].cols * sizeof(float);
+                payloadHash.update(tensors[t].data, bytes);
+                payloadHash.update(padding, alignUp(bytes, blobAlignment) - bytes);
+            }
+            header.payloadChecksum = payloadHash.value();
+
+            Checksum headerHash;
+            headerHash.update(&header, sizeof(header));
+            headerHash.update(sizes.data(), sizes.size() * sizeof(uint64_t));
+            headerHash.update(name.data(), name.size());
+            headerHash.update(padding, nameBytes - name.size());
+            headerHash.update(entries.data(), entries.size() * sizeof(TensorEntry));
+            header.headerChecksum = headerHash.value();
+
+            std::ofstream outFile(path, std::ios::binary | std::ios::trunc);
+            if (!outFile.is_open())
+                return false;
+
+            outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            outFile.write(reinterpret_cast<const char*>(sizes.data()), sizes.size() * sizeof(uint64_t));
+            outFile.write(name.data(), name.size());
+            outFile.write(padding, nameBytes - name.size());
+            outFile.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(TensorEntry));
+            outFile.write(padding, header.payloadOffset - headerBytes);
+
+            for (size_t t = 0; t < tensors.size(); ++t)
+            {
+                const size_t bytes = entries[t].rows * entries[t].cols * sizeof(float);
+                outFile.write(reinterpret_cast<const char*>(tensors[t].data), bytes);
+                outFile.write(padding, alignUp(bytes, blobAlignment) - bytes);
+            }
+
+            outFile.close();
+            return !outFile.fail();
+        }
+
+        bool ModelReader::open(const std::filesystem::path& path, bool verifyPayload)
+        {
+            if (!file.open(path))
+            {
+                error = "Could not map file: " + path.string();
+                return false;
+            }
+
+            const std::byte* base = file.data();
+            const size_t fileSize = file.size();
+
+            if (fileSize < sizeof(FileHeader))
+            {
+                error = "File is too small to be a model: " + path.string();
+                return false;
+            }
+
+            header = reinterpret_cast<const FileHeader*>(base);
+            if (std::memcmp(header->magic, modelMagic, sizeof(modelMagic)) != 0)
+            {
+                error = "Not a .tars model: " + path.string();
+                return false;
+            }
+
+            if (header->version > modelVersion || header->dtype != DataType_F32)
+            {
+                error = "Unsupported model version or data type in " + path.string();
+                return false;
+            }
+
+            // every count is bounded by the file size on its own first, so a corrupt header can not wrap the sums
+            const size_t numSizes = static_cast<size_t>(header->numLayers) + 1;
+            if (numSizes > fileSize / sizeof(uint64_t) || header->numTensors > fileSize / sizeof(TensorEntry) || header->nameLength > fileSize ||
+                header->payloadOffset > fileSize || header->payloadBytes > fileSize - header->payloadOffset)
+            {
+                error = "Model file is truncated: " + path.string();
+                return false;
+            }
+
+            const size_t structureBytes = numSizes * sizeof(uint64_t);
+            const size_t nameBytes = alignUp(header->nameLength, sizeof(uint64_t));
+            const size_t headerBytes = sizeof(FileHeader) + structureBytes + nameBytes + static_cast<size_t>(header->numTensors) * sizeof(TensorEntry);
+            if (headerBytes > fileSize)
+            {
+                error = "Model file is truncated: " + path.string();
+                return false;
+            }
+
+            const std::byte* cursor = base + sizeof(FileHeader);
+            const uint64_t* sizes = reinterpret_cast<const uint64_t*>(cursor);
+            cursor += structureBytes;
+            const char* nameData = reinterpret_cast<const char*>(cursor);
+            cursor += nameBytes;
+            entries = reinterpret_cast<const TensorEntry*>(cursor);
+
+            FileHeader zeroed = *header;
+            zeroed.headerChecksum = 0;
+
+            Checksum headerHash;
+            headerHash.update(&zeroed, sizeof(zeroed));
+            headerHash.update(base + sizeof(FileHeader), headerBytes - sizeof(FileHeader));
+            if (headerHash.value() != header->headerChecksum)
+            {
+                error = "Model header checksum mismatch: " + path.string();
+                return false;
+            }
+
+            if (verifyPayload && checksum(base + header->payloadOffset, header->payloadBytes) != header->payloadChecksum)
+            {
+                error = "Model payload checksum mismatch: " + path.string();
+                return false;
+            }
+
+            for (uint32_t t = 0; t < header->numTensors; ++t)
+            {
+                const TensorEntry& entry = entries[t];
+                const uint64_t available = entry.offset > fileSize ? 0 : (fileSize - entry.offset) / sizeof(float);
+                if (entry.offset > fileSize || (entry.cols != 0 && entry.rows > available / entry.cols))
+                {
+                    error = "Model tensor out of bounds: " + path.string();
+                    return false;
+                }
+            }
+
+            structure.assign(sizes, sizes + numSizes);
+            name.assign(nameData, header->nameLength);
+
+            return true;
+        }
+
+        const TensorEntry* ModelReader::findTensor(TensorKind_ kind, uint32_t layer, uint32_t slot) const
+        {
+            for (uint32_t t = 0; t < header->numTensors; ++t)
+            {
+                if (entries[t].kind == kind && entries[t].layer == layer && entries[t].slot == slot)
+                    return &entries[t];
+            }
+
+            return nullptr;
+        }
+
+        const float* ModelReader::tensorData(const TensorEntry& entry) const
+        {
+            return reinterpret_cast<const float*>(file.data() + entry.offset);
+        }
+    } // namespace FORMAT
+} // namespace NTARS
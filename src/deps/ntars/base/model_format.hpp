@@ -0,0 +1,134 @@
+#ifndef NTARS_MODEL_FORMAT_HPP
+#define NTARS_MODEL_FORMAT_HPP
+
+#include "ntars/base/mapped_file.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace NTARS
+{
+    namespace FORMAT
+    {
+        // .tars layout, little endian:
+        // FileHeader | uint64 structure[numLayers + 1] | name padded to 8 bytes | TensorEntry[numTensors] | 64-byte aligned tensor blobs
+        constexpr char modelMagic[4] = {'T', 'A', 'R', 'S'};
+        constexpr uint32_t modelVersion = 1;
+        constexpr size_t blobAlignment = 64;
+
+        enum DataType_ : uint32_t
+        {
+            DataType_F32 = 0,
+        };
+
+        enum TensorKind_ : uint32_t
+        {
+            TensorKind_Weights = 0,
+            TensorKind_Biases,
+            TensorKind_WeightOptimizerState,
+            TensorKind_BiasOptimizerState,
+            TensorKind_TrainingState,    // raw bytes, sized in floats
+            TensorKind_LayerGraph,       // LayerGraphHeader and one LayerRecord per layer, dense-only models have none
+            TensorKind_LayerState,       // untrained values of a graph layer, such as BatchNorm running statistics
+        };
+
+        struct FileHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t flags;          // NeuralNetworkFlags_
+            uint32_t dtype;          // DataType_
+            uint32_t numLayers;      // weight layers, structure holds numLayers + 1 sizes
+            uint32_t numTensors;
+            uint32_t nameLength;
+            uint32_t reserved;
+            uint64_t payloadOffset;
+            uint64_t payloadBytes;
+            uint64_t payloadChecksum;
+            uint64_t headerChecksum; // covers everything before the payload, computed with this field zeroed
+        };
+
+        // Leads the TensorKind_LayerGraph blob, the input shape the layers are rebuilt from
+        struct LayerGraphHeader
+        {
+            uint32_t numLayers;
+            uint32_t channels;
+            uint32_t height;
+            uint32_t width;
+        };
+
+        struct TensorEntry
+        {
+            uint32_t kind;           // TensorKind_
+            uint32_t layer;
+            uint32_t slot;
+            uint32_t reserved;
+            uint64_t rows;
+            uint64_t cols;
+            uint64_t offset;         // from the start of the file
+        };
+
+        // FNV-1a over 8 byte words, streaming so split updates hash the same as one contiguous update
+        class Checksum
+        {
+        public:
+            void update(const void* data, size_t size);
+            uint64_t value() const;
+
+        private:
+            uint64_t hash{0xcbf29ce484222325ULL};
+            unsigned char tail[8]{};
+            size_t tailSize{0};
+        };
+
+        uint64_t checksum(const void* data, size_t size);
+
+        class ModelWriter
+        {
+        public:
+            // The data has to stay alive until write() returns
+            void addTensor(TensorKind_ kind, uint32_t layer, uint32_t slot, size_t rows, size_t cols, const float* data);
+            // Untyped record stored as a single row, bytes has to be a multiple of sizeof(float)
+            void addBlob(TensorKind_ kind, const void* data, size_t bytes);
+            bool write(const std::filesystem::path& path, const std::vector<size_t>& structure, const std::string& name, uint32_t flags) const;
+
+        private:
+            struct PendingTensor
+            {
+                TensorEntry entry;
+                const void* data;
+            };
+
+            std::vector<PendingTensor> tensors;
+        };
+
+        // Maps a .tars file and hands out pointers straight into the mapping
+        class ModelReader
+        {
+        public:
+            bool open(const std::filesystem::path& path, bool verifyPayload = false);
+
+            inline const FileHeader& getHeader() const { return *header; }
+            inline const std::vector<size_t>& getStructure() const { return structure; }
+            inline const std::string& getName() const { return name; }
+            inline const std::string& getError() const { return error; }
+
+            const TensorEntry* findTensor(TensorKind_ kind, uint32_t layer, uint32_t slot = 0) const;
+            const float* tensorData(const TensorEntry& entry) const;
+            inline const std::byte* blobData(const TensorEntry& entry) const { return file.data() + entry.offset; }
+
+        private:
+            MappedFile file;
+            const FileHeader* header{nullptr};
+            const TensorEntry* entries{nullptr};
+
+            std::vector<size_t> structure;
+            std::string name;
+            std::string error;
+        };
+    } // namespace FORMAT
+} // namespace NTARS
+
+#endif // NTARS_MODEL_FORMAT_HPP
@@ -0,0 +1,437 @@
+#ifndef NTARS_NDJSON_HPP
+#define NTARS_NDJSON_HPP
+
+#include "ntars/base/data.hpp"
+#include "ntars/base/thread_pool.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace NTARS
+{
+    namespace DATA
+    {
+        // Newline-delimited JSON, one {"data":[...],"label":[...]} object per line, so a file can be appended to,
+        // cut at any line and read without ever holding more than a block of it
+
+        // Writes samples to a file, after the records already in it when appending or over them otherwise. Lines are
+        // collected in a buffer that is written once it passes flushBytes, only ever whole lines, so a concurrent
+        // reader never sees half a record
+        template<typename T>
+        class NDJSONWriter
+        {
+        public:
+            NDJSONWriter(const std::filesystem::path& path, bool append, size_t flushBytes = 1 << 20)
+                : path(path), flushBytes(flushBytes)
+            {
+                if (path.has_parent_path())
+                {
+                    std::error_code error;
+                    std::filesystem::create_directories(path.parent_path(), error);
+                }
+
+                out.open(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+                if (!out.is_open())
+                    std::cerr << "Could not open file for writing: " << path << std::endl;
+
+                buffer.reserve(flushBytes + 4096);
+            }
+
+            ~NDJSONWriter() { flush(); }
+
+            NDJSONWriter(const NDJSONWriter&) = delete;
+            NDJSONWriter& operator=(const NDJSONWriter&) = delete;
+
+            bool write(const TrainingData<T>& sample)
+            {
+                if (!out.is_open())
+                    return false;
+
+                buffer += "{\"data\":";
+                appendValues(sample.data);
+                buffer += ",\"label\":";
+                appendValues(sample.label);
+                buffer += "}\n";
+                ++numWritten;
+
+                return buffer.size() < flushBytes || flush();
+            }
+
+            bool flush()
+            {
+                if (!out.is_open())
+                    return false;
+
+                if (!buffer.empty())
+                {
+                    out.write(buffer.data(), buffer.size());
+                    out.flush();
+                    buffer.clear();
+                }
+
+                if (!out.good())
+                {
+                    std::cerr << "Could not write to " << path << std::endl;
+                    return false;
+                }
+
+                return true;
+            }
+
+            inline size_t size() const { return numWritten; }
+
+        private:
+            template<typename V>
+            void appendValues(const V& values)
+            {
+                if constexpr (std::is_same_v<V, std::vector<float>>)
+                {
+                    // shortest text that reads back as the same float. Non-finite values have no JSON number,
+                    // they are written as null and read back as NaN
+                    buffer += '[';
+                    char number[32];
+                    for (size_t i = 0; i < values.size(); ++i)
+                    {
+                        if (i != 0)
+                            buffer += ',';
+
+                        if (!std::isfinite(values[i]))
+                        {
+                            buffer += "null";
+                            continue;
+                        }
+
+                        const auto result = std::to_chars(number, number + sizeof(number), values[i]);
+                        buffer.append(number, result.ptr);
+                    }
+                    buffer += ']';
+                }
+                else
+                {
+                    buffer += nlohmann::json(values).dump();
+                }
+            }
+
+            std::filesystem::path path;
+            size_t flushBytes;
+            std::ofstream out;
+            std::string buffer;
+            size_t numWritten{0};
+        };
+
+        // Reads an NDJSON file a block at a time. Each block is cut at line ends into one slice per thread, the
+        // slices are parsed in parallel and their records handed out in file order, so memory stays at about one
+        // block and its records however large the file is. Lines that are not a record are skipped and counted
+        template<typename T>
+        class NDJSONReader
+        {
+        public:
+            class Iterator
+            {
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type = TrainingData<T>;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const value_type*;
+                using reference = const value_type&;
+
+                Iterator() = default;
+                explicit Iterator(NDJSONReader* reader) : reader(reader) { ++(*this); }
+
+                inline reference operator*() const { return current; }
+                inline pointer operator->() const { return &current; }
+
+                Iterator& operator++()
+                {
+                    if (!reader->next(current))
+                        reader = nullptr;
+                    return *this;
+                }
+
+                inline bool operator==(const Iterator& other) const { return reader == other.reader; }
+
+            private:
+                NDJSONReader* reader{nullptr};
+                TrainingData<T> current;
+            };
+
+            explicit NDJSONReader(const std::filesystem::path& path, size_t numThreads = 0, size_t blockBytes = 1 << 22)
+                : pool(numThreads), blockBytes(std::max<size_t>(1, blockBytes)), in(path, std::ios::binary)
+            {
+                if (!in.is_open())
+                    std::cerr << "Could not open file for reading: " << path << std::endl;
+            }
+
+            inline bool isOpen() const { return in.is_open(); }
+            inline size_t getSkippedLines() const { return skippedLines; }
+
+            // Moves the next record into sample, false once the file is exhausted
+            bool next(TrainingData<T>& sample)
+            {
+                while (slice >= slices.size() || position >= slices[slice].size())
+                {
+                    if (slice < slices.size())
+                    {
+                        ++slice;
+                        position = 0;
+                        continue;
+                    }
+
+                    if (!readBlock())
+                        return false;
+                }
+
+                sample = std::move(slices[slice][position++]);
+                return true;
+            }
+
+            // Single pass, the reader only moves forward
+            inline Iterator begin() { return Iterator(this); }
+            inline Iterator end() { return Iterator(); }
+
+        private:
+            bool readBlock()
+            {
+                slices.clear();
+                slice = 0;
+                position = 0;
+
+                // the partial line left by the last block goes first, a block without a line end grows until it has one
+                block = std::move(carry);
+                carry.clear();
+                size_t lineEnd = std::string::npos;
+                while (in.is_open() && !in.eof())
+                {
+                    const size_t filled = block.size();
+                    block.resize(filled + blockBytes);
+                    in.read(block.data() + filled, blockBytes);
+                    block.resize(filled + static_cast<size_t>(in.gcount()));
+
+                    lineEnd = block.rfind('\n');
+                    if (lineEnd != std::string::npos)
+                        break;
+                }
+
+                if (block.empty())
+                    return false;
+
+                if (!in.eof() && lineEnd != std::string::npos)
+                {
+                    carry.assign(block, lineEnd + 1);
+                    block.resize(lineEnd + 1);
+                }
+
+                // slice boundaries moved forward to the next line start
+                const size_t numSlices = std::min(pool.size(), std::max<size_t>(1, block.size() / 4096));
+                std::vector<size_t> bounds(numSlices + 1, block.size());
+                bounds[0] = 0;
+                for (size_t s = 1; s < numSlices; ++s)
+                {
+                    const size_t lineStart = block.find('\n', std::max(bounds[s - 1], block.size() * s / numSlices));
+                    bounds[s] = lineStart == std::string::npos ? block.size() : lineStart + 1;
+                }
+
+                slices.resize(numSlices);
+                std::vector<size_t> skipped(numSlices, 0);
+                pool.parallelFor(numSlices, [&](size_t s)
+                {
+                    std::string_view text(block.data() + bounds[s], bounds[s + 1] - bounds[s]);
+                    while (!text.empty())
+                    {
+                        const size_t end = text.find('\n');
+                        std::string_view line = text.substr(0, end);
+                        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+
+                        while (!line.empty() && std::isspace(static_cast<unsigned char>(line.back())))
+                            line.remove_suffix(1);
+                        if (line.empty())
+                            continue;
+
+                        TrainingData<T> sample{};
+                        if (parseLine(line, sample))
+                            slices[s].push_back(std::move(sample));
+                        else
+                            ++skipped[s];
+                    }
+                });
+
+                for (size_t count : skipped)
+                    skippedLines += count;
+
+                return true;
+            }
+
+            static bool parseLine(std::string_view line, TrainingData<T>& sample)
+            {
+                if constexpr (std::is_same_v<T, std::vector<float>>)
+                {
+                    if (parseFloatRecord(line, sample))
+                        return true;
+                }
+
+                try
+                {
+                    const nlohmann::json entry = nlohmann::json::parse(line);
+                    if constexpr (std::is_same_v<T, std::vector<float>>)
+                    {
+                        if (!readFloats(entry.at("data"), sample.data))
+                            return false;
+                    }
+                    else
+                    {
+                        sample.data = entry.at("data").get<T>();
+                    }
+                    return readFloats(entry.at("label"), sample.label);
+                }
+                catch (const nlohmann::json::exception&)
+                {
+                    return false;
+                }
+            }
+
+            // Float array where null stands for a value NDJSONWriter could not write as a number
+            static bool readFloats(const nlohmann::json& array, std::vector<float>& values)
+            {
+                if (!array.is_array())
+                    return false;
+
+                values.clear();
+                values.reserve(array.size());
+                for (const nlohmann::json& value : array)
+                    values.push_back(value.is_null() ? std::numeric_limits<float>::quiet_NaN() : value.get<float>());
+                return true;
+            }
+
+            // The layout NDJSONWriter produces, in either key order and with any whitespace. Anything else, such as
+            // extra keys, is left to nlohmann
+            static bool parseFloatRecord(std::string_view line, TrainingData<std::vector<float>>& sample)
+            {
+                const char* p = line.data();
+                const char* end = p + line.size();
+
+                auto skipSpace = [&]() {
+                    while (p < end && std::isspace(static_cast<unsigned char>(*p)))
+                        ++p;
+                };
+                auto expect = [&](char c) {
+                    skipSpace();
+                    if (p == end || *p != c)
+                        return false;
+                    ++p;
+                    return true;
+                };
+                auto parseArray = [&](std::vector<float>& values) {
+                    values.clear();
+                    if (!expect('['))
+                        return false;
+                    if (expect(']'))
+                        return true;
+
+                    do
+                    {
+                        skipSpace();
+                        if (end - p >= 4 && std::string_view(p, 4) == "null")
+                        {
+                            values.push_back(std::numeric_limits<float>::quiet_NaN());
+                            p += 4;
+                            continue;
+                        }
+
+                        float value;
+                        const auto result = std::from_chars(p, end, value);
+                        if (result.ec != std::errc())
+                            return false;
+
+                        values.push_back(value);
+                        p = result.ptr;
+                    } while (expect(','));
+
+                    return expect(']');
+                };
+
+                bool hasData = false;
+                bool hasLabel = false;
+                if (!expect('{'))
+                    return false;
+
+                do
+                {
+                    if (!expect('"'))
+                        return false;
+
+                    const char* key = p;
+                    while (p < end && *p != '"')
+                        ++p;
+                    if (p == end)
+                        return false;
+
+                    const std::string_view name(key, p - key);
+                    ++p;
+                    if (!expect(':'))
+                        return false;
+
+                    if (name == "data" && !hasData)
+                        hasData = parseArray(sample.data);
+                    else if (name == "label" && !hasLabel)
+                        hasLabel = parseArray(sample.label);
+                    else
+                        return false;
+
+                    if (!(name == "data" ? hasData : hasLabel))
+                        return false;
+                } while (expect(','));
+
+                if (!expect('}'))
+                    return false;
+
+                skipSpace();
+                return p == end && hasData && hasLabel;
+            }
+
+            ThreadPool pool;
+            size_t blockBytes;
+            std::ifstream in;
+
+            std::string block;
+            std::string carry;
+            std::vector<std::vector<TrainingData<T>>> slices;
+            size_t slice{0};
+            size_t position{0};
+            size_t skippedLines{0};
+        };
+
+        template<typename T>
+        bool saveListDataNDJSON(const std::vector<TrainingData<T>>& inData, const std::filesystem::path& path)
+        {
+            NDJSONWriter<T> writer(path, false);
+            for (const auto& data : inData)
+            {
+                if (!writer.write(data))
+                    return false;
+            }
+
+            return writer.flush();
+        }
+
+        template<typename T>
+        std::vector<TrainingData<T>> loadDataListNDJSON(const std::filesystem::path& path, size_t numThreads = 0)
+        {
+            NDJSONReader<T> reader(path, numThreads);
+            return std::vector<TrainingData<T>>(reader.begin(), reader.end());
+        }
+    } // namespace DATA
+} // namespace NTARS
+
+#endif // NTARS_NDJSON_HPP
@@ -19,6 +19,7 @@ namespace NTARS
         NeuralNetworkFlags_None = 1ULL << 0,
         NeuralNetworkFlags_ReLU_Internal = 1ULL << 1, // ReLU is completely broken as of now;
         NeuralNetworkFlags_ReLU = 1ULL << 2, // on all layers, including output;
+        NeuralNetworkFlags_Linear = 1ULL << 3, // no activation, for layer graph nodes followed by a BatchNorm;
     };
 
     class Neuron
@@ -0,0 +1,172 @@
+#include "optimizer.hpp"
+
+#include "tarsmath/linear_algebra/matrix_component.hpp"
+
+#include <cmath>
+
+namespace NTARS
+{
+    void SGDOptimizer::update(float* params, const float* gradients, float* const* /*state*/, size_t size,
+        float learningRate, float gradientScale, bool /*decay*/) const
+    {
+        const float scale = learningRate * gradientScale;
+        size_t i = 0;
+
+        #ifdef USE_SIMD
+        const __m256 scaleVec = _mm256_set1_ps(scale);
+        for (; i + 8 <= size; i += 8)
+        {
+            __m256 w = _mm256_loadu_ps(&params[i]);
+            __m256 g = _mm256_loadu_ps(&gradients[i]);
+            _mm256_storeu_ps(&params[i], _mm256_fmadd_ps(g, scaleVec, w));
+        }
+        #endif
+
+        for (; i < size; ++i)
+            params[i] += gradients[i] * scale;
+    }
+
+    void MomentumOptimizer::update(float* params, const float* gradients, float* const* state, size_t size,
+        float learningRate, float gradientScale, bool /*decay*/) const
+    {
+        float* velocity = state[0];
+        size_t i = 0;
+
+        #ifdef USE_SIMD
+        const __m256 scaleVec = _mm256_set1_ps(gradientScale);
+        const __m256 momentumVec = _mm256_set1_ps(momentum);
+        const __m256 lrVec = _mm256_set1_ps(learningRate);
+        for (; i + 8 <= size; i += 8)
+        {
+            __m256 g = _mm256_mul_ps(_mm256_loadu_ps(&gradients[i]), scaleVec);
+            __m256 v = _mm256_fmadd_ps(momentumVec, _mm256_loadu_ps(&velocity[i]), g);
+            __m256 step = nesterov ? _mm256_fmadd_ps(momentumVec, v, g) : v;
+
+            _mm256_storeu_ps(&velocity[i], v);
+            _mm256_storeu_ps(&params[i], _mm256_fmadd_ps(lrVec, step, _mm256_loadu_ps(&params[i])));
+        }
+        #endif
+
+        for (; i < size; ++i)
+        {
+            float g = gradients[i] * gradientScale;
+            velocity[i] = momentum * velocity[i] + g;
+            params[i] += learningRate * (nesterov ? g + momentum * velocity[i] : velocity[i]);
+        }
+    }
+
+    void RMSPropOptimizer::update(float* params, const float* gradients, float* const* state, size_t size,
+        float learningRate, float gradientScale, bool /*decay*/) const
+    {
+        float* meanSquare = state[0];
+        size_t i = 0;
+
+        #ifdef USE_SIMD
+        const __m256 scaleVec = _mm256_set1_ps(gradientScale);
+        const __m256 decayVec = _mm256_set1_ps(decayRate);
+        const __m256 oneMinusDecay = _mm256_set1_ps(1.0f - decayRate);
+        const __m256 epsVec = _mm256_set1_ps(epsilon);
+        const __m256 lrVec = _mm256_set1_ps(learningRate);
+        for (; i + 8 <= size; i += 8)
+        {
+            __m256 g = _mm256_mul_ps(_mm256_loadu_ps(&gradients[i]), scaleVec);
+            __m256 s = _mm256_fmadd_ps(decayVec, _mm256_loadu_ps(&meanSquare[i]), _mm256_mul_ps(oneMinusDecay, _mm256_mul_ps(g, g)));
+            __m256 step = _mm256_div_ps(g, _mm256_add_ps(_mm256_sqrt_ps(s), epsVec));
+
+            _mm256_storeu_ps(&meanSquare[i], s);
+            _mm256_storeu_ps(&params[i], _mm256_fmadd_ps(lrVec, step, _mm256_loadu_ps(&params[i])));
+        }
+        #endif
+
+        for (; i < size; ++i)
+        {
+            float g = gradients[i] * gradientScale;
+            meanSquare[i] = decayRate * meanSquare[i] + (1.0f - decayRate) * g * g;
+            params[i] += learningRate * g / (std::sqrt(meanSquare[i]) + epsilon);
+        }
+    }
+
+    void AdamOptimizer::update(float* params, const float* gradients, float* const* state, size_t size,
+        float learningRate, float gradientScale, bool decay) const
+    {
+        float* firstMoment = state[0];
+        float* secondMoment = state[1];
+
+        const uint64_t t = step > 0 ? step : 1;
+        const float correction1 = 1.0f / (1.0f - std::pow(beta1, static_cast<float>(t)));
+        const float correction2 = 1.0f / (1.0f - std::pow(beta2, static_cast<float>(t)));
+
+        // L2 decay pulls the descent direction towards zero, AdamW shrinks the parameter directly
+        const float l2Decay = (decay && !decoupled) ? weightDecay : 0.0f;
+        const float paramDecay = (decay && decoupled) ? 1.0f - learningRate * weightDecay : 1.0f;
+
+        size_t i = 0;
+
+        #ifdef USE_SIMD
+        const __m256 scaleVec = _mm256_set1_ps(gradientScale);
+        const __m256 l2Vec = _mm256_set1_ps(l2Decay);
+        const __m256 beta1Vec = _mm256_set1_ps(beta1);
+        const __m256 beta2Vec = _mm256_set1_ps(beta2);
+        const __m256 oneMinusBeta1 = _mm256_set1_ps(1.0f - beta1);
+        const __m256 oneMinusBeta2 = _mm256_set1_ps(1.0f - beta2);
+        const __m256 correction1Vec = _mm256_set1_ps(correction1);
+        const __m256 correction2Vec = _mm256_set1_ps(correction2);
+        const __m256 epsVec = _mm256_set1_ps(epsilon);
+        const __m256 lrVec = _mm256_set1_ps(learningRate);
+        const __m256 paramDecayVec = _mm256_set1_ps(paramDecay);
+        for (; i + 8 <= size; i += 8)
+        {
+            __m256 w = _mm256_loadu_ps(&params[i]);
+            __m256 g = _mm256_fnmadd_ps(l2Vec, w, _mm256_mul_ps(_mm256_loadu_ps(&gradients[i]), scaleVec));
+
+            __m256 m = _mm256_fmadd_ps(beta1Vec, _mm256_loadu_ps(&firstMoment[i]), _mm256_mul_ps(oneMinusBeta1, g));
+            __m256 v = _mm256_fmadd_ps(beta2Vec, _mm256_loadu_ps(&secondMoment[i]), _mm256_mul_ps(oneMinusBeta2, _mm256_mul_ps(g, g)));
+
+            __m256 mHat = _mm256_mul_ps(m, correction1Vec);
+            __m256 vHat = _mm256_mul_ps(v, correction2Vec);
+            __m256 step = _mm256_div_ps(mHat, _mm256_add_ps(_mm256_sqrt_ps(vHat), epsVec));
+
+            _mm256_storeu_ps(&firstMoment[i], m);
+            _mm256_storeu_ps(&secondMoment[i], v);
+            _mm256_storeu_ps(&params[i], _mm256_fmadd_ps(lrVec, step, _mm256_mul_ps(w, paramDecayVec)));
+        }
+        #endif
+
+        for (; i < size; ++i)
+        {
+            float g = gradients[i] * gradientScale - l2Decay * params[i];
+            firstMoment[i] = beta1 * firstMoment[i] + (1.0f - beta1) * g;
+            secondMoment[i] = beta2 * secondMoment[i] + (1.0f - beta2) * g * g;
+
+            float mHat = firstMoment[i] * correction1;
+            float vHat = secondMoment[i] * correction2;
+            params[i] = params[i] * paramDecay + learningRate * mHat / (std::sqrt(vHat) + epsilon);
+        }
+    }
+
+    std::unique_ptr<Optimizer> createOptimizer(OptimizerType_ type)
+    {
+        switch (type)
+        {
+            case OptimizerType_Momentum: return std::make_unique<MomentumOptimizer>(0.9f, false);
+            case OptimizerType_Nesterov: return std::make_unique<MomentumOptimizer>(0.9f, true);
+            case OptimizerType_RMSProp:  return std::make_unique<RMSPropOptimizer>();
+            case OptimizerType_Adam:     return std::make_unique<AdamOptimizer>();
+            case OptimizerType_AdamW:    return std::make_unique<AdamOptimizer>(0.9f, 0.999f, 1e-8f, 0.01f, true);
+            default:                     return std::make_unique<SGDOptimizer>();
+        }
+    }
+
+    std::string getOptimizerName(OptimizerType_ type)
+    {
+        switch (type)
+        {
+            case OptimizerType_Momentum: return "Momentum";
+            case OptimizerType_Nesterov: return "Nesterov";
+            case OptimizerType_RMSProp:  return "RMSProp";
+            case OptimizerType_Adam:     return "Adam";
+            case OptimizerType_AdamW:    return "AdamW";
+            default:                     return "SGD";
+        }
+    }
+} // namespace NTARS
@@ -0,0 +1,114 @@
+#ifndef NTARS_OPTIMIZER_HPP
+#define NTARS_OPTIMIZER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace NTARS
+{
+    enum OptimizerType_
+    {
+        OptimizerType_SGD = 0,
+        OptimizerType_Momentum,
+        OptimizerType_Nesterov,
+        OptimizerType_RMSProp,
+        OptimizerType_Adam,
+        OptimizerType_AdamW,
+    };
+
+    // Gradients handed to an optimizer are the summed descent direction of the batch (expected - output),
+    // so every update adds to the parameters; gradientScale turns the sum into a mean.
+    class Optimizer
+    {
+    public:
+        virtual ~Optimizer() = default;
+
+        virtual OptimizerType_ getType() const = 0;
+
+        // Number of state buffers (each the size of the parameter tensor) this optimizer keeps
+        virtual size_t getStateCount() const = 0;
+
+        // One fused pass over params, state and gradient; state holds getStateCount() pointers
+        virtual void update(float* params, const float* gradients, float* const* state, size_t size,
+            float learningRate, float gradientScale, bool decay) const = 0;
+
+        inline void beginStep() { ++step; }
+        inline uint64_t getStep() const { return step; }
+        inline void setStep(uint64_t newStep) { step = newStep; }
+
+    protected:
+        uint64_t step{0};
+    };
+
+    class SGDOptimizer : public Optimizer
+    {
+    public:
+        OptimizerType_ getType() const override { return OptimizerType_SGD; }
+        size_t getStateCount() const override { return 0; }
+
+        void update(float* params, const float* gradients, float* const* state, size_t size,
+            float learningRate, float gradientScale, bool decay) const override;
+    };
+
+    class MomentumOptimizer : public Optimizer
+    {
+    public:
+        MomentumOptimizer(float momentum = 0.9f, bool nesterov = false)
+            : momentum(momentum), nesterov(nesterov) {}
+
+        OptimizerType_ getType() const override { return nesterov ? OptimizerType_Nesterov : OptimizerType_Momentum; }
+        size_t getStateCount() const override { return 1; }
+
+        void update(float* params, const float* gradients, float* const* state, size_t size,
+            float learningRate, float gradientScale, bool decay) const override;
+
+    private:
+        float momentum;
+        bool nesterov;
+    };
+
+    class RMSPropOptimizer : public Optimizer
+    {
+    public:
+        RMSPropOptimizer(float decayRate = 0.9f, float epsilon = 1e-8f)
+            : decayRate(decayRate), epsilon(epsilon) {}
+
+        OptimizerType_ getType() const override { return OptimizerType_RMSProp; }
+        size_t getStateCount() const override { return 1; }
+
+        void update(float* params, const float* gradients, float* const* state, size_t size,
+            float learningRate, float gradientScale, bool decay) const override;
+
+    private:
+        float decayRate;
+        float epsilon;
+    };
+
+    // Adam with L2 weight decay folded into the gradient, or AdamW when decoupled is set
+    class AdamOptimizer : public Optimizer
+    {
+    public:
+        AdamOptimizer(float beta1 = 0.9f, float beta2 = 0.999f, float epsilon = 1e-8f, float weightDecay = 0.0f, bool decoupled = false)
+            : beta1(beta1), beta2(beta2), epsilon(epsilon), weightDecay(weightDecay), decoupled(decoupled) {}
+
+        OptimizerType_ getType() const override { return decoupled ? OptimizerType_AdamW : OptimizerType_Adam; }
+        size_t getStateCount() const override { return 2; }
+
+        void update(float* params, const float* gradients, float* const* state, size_t size,
+            float learningRate, float gradientScale, bool decay) const override;
+
+    private:
+        float beta1;
+        float beta2;
+        float epsilon;
+        float weightDecay;
+        bool decoupled;
+    };
+
+    std::unique_ptr<Optimizer> createOptimizer(OptimizerType_ type);
+    std::string getOptimizerName(OptimizerType_ type);
+} // namespace NTARS
+
+#endif // NTARS_OPTIMIZER_HPP
@@ -0,0 +1,345 @@
+#include "random.hpp"
+
+#include "tarsmath/linear_algebra/matrix_component.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <numbers>
+
+namespace NTARS
+{
+    static constexpr uint32_t philoxM0 = 0xD2511F53;
+    static constexpr uint32_t philoxM1 = 0xCD9E8D57;
+    static constexpr uint32_t philoxW0 = 0x9E3779B9;
+    static constexpr uint32_t philoxW1 = 0xBB67AE85;
+    static constexpr size_t philoxRounds = 10;
+
+    static constexpr uint64_t defaultSeed = 0x5EED5EED;
+
+    // words = Philox4x32-10(counter = {block, stream}, key = seed)
+    static void philox(uint64_t block, uint64_t stream, uint64_t seed, uint32_t* words)
+    {
+        uint32_t c0 = static_cast<uint32_t>(block);
+        uint32_t c1 = static_cast<uint32_t>(block >> 32);
+        uint32_t c2 = static_cast<uint32_t>(stream);
+        uint32_t c3 = static_cast<uint32_t>(stream >> 32);
+        uint32_t k0 = static_cast<uint32_t>(seed);
+        uint32_t k1 = static_cast<uint32_t>(seed >> 32);
+
+        for (size_t round = 0; round < philoxRounds; ++round)
+        {
+            const uint64_t p0 = static_cast<uint64_t>(philoxM0) * c0;
+            const uint64_t p1 = static_cast<uint64_t>(philoxM1) * c2;
+
+            c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+            c1 = static_cast<uint32_t>(p1);
+            c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+            c3 = static_cast<uint32_t>(p0);
+
+            k0 += philoxW0;
+            k1 += philoxW1;
+        }
+
+        words[0] = c0;
+        words[1] = c1;
+        words[2] = c2;
+        words[3] = c3;
+    }
+
+    #ifdef USE_SIMD
+    static inline void mulHiLo(__m256i a, __m256i m, __m256i& hi, __m256i& lo)
+    {
+        const __m256i even = _mm256_mul_epu32(a, m);
+        const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+
+        lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+        hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+    }
+
+    // Eight consecutive blocks, one per lane, written in the same order as eight philox() calls
+    static void philox8(uint64_t block, uint64_t stream, uint64_t seed, uint32_t* words)
+    {
+        // the low counter word would wrap inside the group
+        if (static_cast<uint32_t>(block) > 0xFFFFFFF8u)
+        {
+            for (size_t b = 0; b < 8; ++b)
+                philox(block + b, stream, seed, words + b * 4);
+            return;
+        }
+
+        __m256i c0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(block)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256i c1 = _mm256_set1_epi32(static_cast<int32_t>(block >> 32));
+        __m256i c2 = _mm256_set1_epi32(static_cast<int32_t>(stream));
+        __m256i c3 = _mm256_set1_epi32(static_cast<int32_t>(stream >> 32));
+        uint32_t k0 = static_cast<uint32_t>(seed);
+        uint32_t k1 = static_cast<uint32_t>(seed >> 32);
+
+        const __m256i m0 = _mm256_set1_epi32(static_cast<int32_t>(philoxM0));
+        const __m256i m1 = _mm256_set1_epi32(static_cast<int32_t>(philoxM1));
+        for (size_t round = 0; round < philoxRounds; ++round)
+        {
+            __m256i hi0, lo0, hi1, lo1;
+            mulHiLo(c0, m0, hi0, lo0);
+            mulHiLo(c2, m1, hi1, lo1);
+
+            c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32(static_cast<int32_t>(k0)));
+            c1 = lo1;
+            c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32(static_cast<int32_t>(k1)));
+            c3 = lo0;
+
+            k0 += philoxW0;
+            k1 += philoxW1;
+        }
+
+        // lanes hold blocks, transpose so each block's four words are contiguous
+        const __m256i t0 = _mm256_unpacklo_epi32(c0, c1);
+        const __m256i t1 = _mm256_unpackhi_epi32(c0, c1);
+        const __m256i t2 = _mm256_unpacklo_epi32(c2, c3);
+        const __m256i t3 = _mm256_unpackhi_epi32(c2, c3);
+        const __m256i b04 = _mm256_unpacklo_epi64(t0, t2);
+        const __m256i b15 = _mm256_unpackhi_epi64(t0, t2);
+        const __m256i b26 = _mm256_unpacklo_epi64(t1, t3);
+        const __m256i b37 = _mm256_unpackhi_epi64(t1, t3);
+
+        __m256i* out = reinterpret_cast<__m256i*>(words);
+        _mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(b04, b15, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(b26, b37, 0x20));
+        _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(b04, b15, 0x31));
+        _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(b26, b37, 0x31));
+    }
+
+    // Natural log for x in (0, 1], Cephes polynomial on the mantissa
+    static inline __m256 logPositive(__m256 x)
+    {
+        const __m256i bits = _mm256_castps_si256(x);
+        __m256 exponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+        // mantissa in [0.5, 1)
+        __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F000000)));
+
+        const __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+        exponent = _mm256_sub_ps(exponent, _mm256_and_ps(_mm256_set1_ps(1.0f), small));
+        m = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(m, small)), _mm256_set1_ps(1.0f));
+
+        const __m256 z = _mm256_mul_ps(m, m);
+        __m256 y = _mm256_set1_ps(7.0376836292e-2f);
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(-1.1514610310e-1f));
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(1.1676998740e-1f));
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(-1.2420140846e-1f));
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(1.4249322787e-1f));
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(-1.6668057665e-1f));
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(2.0000714765e-1f));
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(-2.4999993993e-1f));
+        y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(3.3333331174e-1f));
+        y = _mm256_mul_ps(_mm256_mul_ps(y, m), z);
+
+        y = _mm256_fmadd_ps(exponent, _mm256_set1_ps(-2.12194440e-4f), y);
+        y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+        return _mm256_fmadd_ps(exponent, _mm256_set1_ps(0.693359375f), _mm256_add_ps(m, y));
+    }
+
+    // sin and cos of 2 * pi * t for t in [0, 1), reduced to quarter turns so the polynomials see [-pi/4, pi/4]
+    static inline void sinCosTurns(__m256 t, __m256& sine, __m256& cosine)
+    {
+        const __m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(t, _mm256_set1_ps(4.0f)));
+        const __m256 r = _mm256_fnmadd_ps(_mm256_cvtepi32_ps(quadrant), _mm256_set1_ps(0.25f), t);
+        const __m256 a = _mm256_mul_ps(r, _mm256_set1_ps(2.0f * std::numbers::pi_v<float>));
+        const __m256 a2 = _mm256_mul_ps(a, a);
+
+        __m256 s = _mm256_set1_ps(-1.9515295891e-4f);
+        s = _mm256_fmadd_ps(s, a2, _mm256_set1_ps(8.3321608736e-3f));
+        s = _mm256_fmadd_ps(s, a2, _mm256_set1_ps(-1.6666654611e-1f));
+        s = _mm256_fmadd_ps(_mm256_mul_ps(s, a2), a, a);
+
+        __m256 c = _mm256_set1_ps(2.443315711809948e-5f);
+        c = _mm256_fmadd_ps(c, a2, _mm256_set1_ps(-1.388731625493765e-3f));
+        c = _mm256_fmadd_ps(c, a2, _mm256_set1_ps(4.166664568298827e-2f));
+        c = _mm256_fmadd_ps(_mm256_mul_ps(c, a2), a2, _mm256_fnmadd_ps(a2, _mm256_set1_ps(0.5f), _mm256_set1_ps(1.0f)));
+
+        // odd quadrants swap sin and cos, cos is negative in quadrants 1 and 2, sin in 2 and 3
+        const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+        const __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30));
+        const __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+
+        sine = _mm256_xor_ps(_mm256_blendv_ps(s, c, swap), sinSign);
+        cosine = _mm256_xor_ps(_mm256_blendv_ps(c, s, swap), cosSign);
+    }
+    #endif
+
+    // First draw of the pair lies in (0, 1] so the log is finite, the second in [0, 1)
+    static inline void boxMuller(uint32_t first, uint32_t second, float& z0, float& z1)
+    {
+        const float u1 = static_cast<float>((first >> 8) + 1) * 0x1p-24f;
+        const float u2 = static_cast<float>(second >> 8) * 0x1p-24f;
+        const float radius = std::sqrt(-2.0f * std::log(u1));
+        const float angle = 2.0f * std::numbers::pi_v<float> * u2;
+
+        z0 = radius * std::cos(angle);
+        z1 = radius * std::sin(angle);
+    }
+
+    void Random::generateBlock(uint64_t block, uint32_t* words) const
+    {
+        philox(block, stream, seed, words);
+    }
+
+    void Random::seek(uint64_t draw)
+    {
+        position = draw;
+        hasSpareNormal = false;
+
+        // operator() only refills on block boundaries
+        if ((position & 3) != 0)
+            generateBlock(position >> 2, buffer);
+    }
+
+    float Random::normal(float mean, float stddev)
+    {
+        if (hasSpareNormal)
+        {
+            hasSpareNormal = false;
+            return mean + stddev * spareNormal;
+        }
+
+        const uint32_t first = (*this)();
+        const uint32_t second = (*this)();
+
+        float z0;
+        boxMuller(first, second, z0, spareNormal);
+        hasSpareNormal = true;
+
+        return mean + stddev * z0;
+    }
+
+    void Random::fillBits(uint32_t* output, size_t count)
+    {
+        size_t i = 0;
+        for (; i < count && (position & 3) != 0; ++i)
+            output[i] = (*this)();
+
+        // whole blocks go straight to the output, the buffer is refilled by the next operator()
+        #ifdef USE_SIMD
+        for (; i + 32 <= count; i += 32, position += 32)
+            philox8(position >> 2, stream, seed, output + i);
+        #endif
+        for (; i + 4 <= count; i += 4, position += 4)
+            generateBlock(position >> 2, output + i);
+
+        for (; i < count; ++i)
+            output[i] = (*this)();
+    }
+
+    void Random::fillUniform(float* output, size_t count, float low, float high)
+    {
+        const float scale = (high - low) * 0x1p-24f;
+
+        uint32_t bits[256];
+        while (count > 0)
+        {
+            const size_t chunk = std::min<size_t>(count, 256);
+            fillBits(bits, chunk);
+
+            size_t i = 0;
+            #ifdef USE_SIMD
+            const __m256 vScale = _mm256_set1_ps(scale);
+            const __m256 vLow = _mm256_set1_ps(low);
+            for (; i + 8 <= chunk; i += 8)
+            {
+                const __m256i word = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bits + i));
+                _mm256_storeu_ps(output + i, _mm256_fmadd_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(word, 8)), vScale, vLow));
+            }
+            #endif
+            for (; i < chunk; ++i)
+                output[i] = low + static_cast<float>(bits[i] >> 8) * scale;
+
+            output += chunk;
+            count -= chunk;
+        }
+    }
+
+    void Random::fillNormal(float* output, size_t count, float mean, float stddev)
+    {
+        hasSpareNormal = false;
+
+        // one pair of draws per pair of outputs, an odd count drops the last value of its pair
+        uint32_t bits[256];
+        while (count > 0)
+        {
+            const size_t chunk = std::min<size_t>(count, 256);
+            const size_t words = (chunk + 1) & ~size_t(1);
+            fillBits(bits, words);
+
+            size_t i = 0;
+            #ifdef USE_SIMD
+            const __m256 vMean = _mm256_set1_ps(mean);
+            const __m256 vStddev = _mm256_set1_ps(stddev);
+            const __m256 unit = _mm256_set1_ps(0x1p-24f);
+            for (; i + 16 <= chunk; i += 16)
+            {
+                const __m256i a = _mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bits + i)), 8);
+                const __m256i b = _mm256_srli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bits + i + 8)), 8);
+
+                // even words are the radius draws, odd words the angles, the lane order undoes itself in the unpack below
+                const __m256 first = _mm256_castsi256_ps(a);
+                const __m256 second = _mm256_castsi256_ps(b);
+                const __m256i evens = _mm256_castps_si256(_mm256_shuffle_ps(first, second, 0x88));
+                const __m256i odds = _mm256_castps_si256(_mm256_shuffle_ps(first, second, 0xDD));
+
+                const __m256 u1 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(evens, _mm256_set1_epi32(1))), unit);
+                const __m256 u2 = _mm256_mul_ps(_mm256_cvtepi32_ps(odds), unit);
+                const __m256 radius = _mm256_mul_ps(_mm256_sqrt_ps(_mm256_mul_ps(_mm256_set1_ps(-2.0f), logPositive(u1))), vStddev);
+
+                __m256 sine, cosine;
+                sinCosTurns(u2, sine, cosine);
+                const __m256 z0 = _mm256_fmadd_ps(radius, cosine, vMean);
+                const __m256 z1 = _mm256_fmadd_ps(radius, sine, vMean);
+
+                _mm256_storeu_ps(output + i, _mm256_unpacklo_ps(z0, z1));
+                _mm256_storeu_ps(output + i + 8, _mm256_unpackhi_ps(z0, z1));
+            }
+            #endif
+            for (; i < chunk; i += 2)
+            {
+                float z0, z1;
+                boxMuller(bits[i], bits[i + 1], z0, z1);
+
+                output[i] = mean + stddev * z0;
+                if (i + 1 < chunk)
+                    output[i + 1] = mean + stddev * z1;
+            }
+
+            output += chunk;
+            count -= chunk;
+        }
+    }
+
+    static std::atomic<uint64_t> globalSeed{defaultSeed};
+    static std::atomic<uint64_t> seedGeneration{0};
+    static std::atomic<uint64_t> nextThreadStream{0};
+
+    void setGlobalSeed(uint64_t seed)
+    {
+        globalSeed.store(seed);
+        seedGeneration.fetch_add(1);
+    }
+
+    uint64_t getGlobalSeed()
+    {
+        return globalSeed.load();
+    }
+
+    Random& threadRandom()
+    {
+        thread_local const uint64_t threadStream = nextThreadStream.fetch_add(1);
+        thread_local uint64_t generation = seedGeneration.load();
+        thread_local Random random{globalSeed.load(), threadStream};
+
+        const uint64_t current = seedGeneration.load(std::memory_order_relaxed);
+        if (generation != current)
+        {
+            generation = current;
+            random = Random(globalSeed.load(), threadStream);
+        }
+
+        return random;
+    }
+} // namespace NTARS
@@ -0,0 +1,102 @@
+#ifndef NTARS_RANDOM_HPP
+#define NTARS_RANDOM_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+
+namespace NTARS
+{
+    // Philox4x32-10 counter-based generator. Draw n of a stream is a pure function of (seed, stream, n), so
+    // streams never overlap, discard() is a jump rather than a loop and a position can be stored and resumed.
+    // Satisfies std::uniform_random_bit_generator, the bulk fills produce the same words as repeated operator()
+    class Random
+    {
+    public:
+        using result_type = uint32_t;
+
+        explicit Random(uint64_t seed = 0, uint64_t stream = 0) : seed(seed), stream(stream) {}
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+        inline result_type operator()()
+        {
+            if ((position & 3) == 0)
+                generateBlock(position >> 2, buffer);
+
+            return buffer[position++ & 3];
+        }
+
+        // [0, 1) with 24 random bits, every value is exactly representable
+        inline float uniform() { return static_cast<float>((*this)() >> 8) * 0x1p-24f; }
+        inline float uniform(float low, float high) { return low + (high - low) * uniform(); }
+        inline bool bernoulli(float p) { return uniform() < p; }
+
+        // [0, n) without modulo bias, n has to be at least 1
+        inline uint32_t uniformInt(uint32_t n)
+        {
+            uint64_t product = static_cast<uint64_t>((*this)()) * n;
+            if (static_cast<uint32_t>(product) < n)
+            {
+                const uint32_t threshold = (0u - n) % n;
+                while (static_cast<uint32_t>(product) < threshold)
+                    product = static_cast<uint64_t>((*this)()) * n;
+            }
+
+            return static_cast<uint32_t>(product >> 32);
+        }
+
+        // Box-Muller on two draws, the second value of the pair is kept for the next call
+        float normal(float mean = 0.0f, float stddev = 1.0f);
+
+        template<typename It>
+        void shuffle(It first, It last)
+        {
+            const auto count = std::distance(first, last);
+            for (auto i = count - 1; i > 0; --i)
+                std::iter_swap(first + i, first + uniformInt(static_cast<uint32_t>(i + 1)));
+        }
+
+        void fillBits(uint32_t* output, size_t count);
+        void fillUniform(float* output, size_t count, float low = 0.0f, float high = 1.0f);
+        // Box-Muller on pairs of draws with vectorized log, sin and cos, within a few 1e-6 of normal() on the same draws
+        void fillNormal(float* output, size_t count, float mean = 0.0f, float stddev = 1.0f);
+
+        // Skips count draws in constant time
+        inline void discard(uint64_t count) { seek(position + count); }
+        void seek(uint64_t draw);
+
+        // Draws taken so far, seek() to it to continue the stream from the same place
+        inline uint64_t getPosition() const { return position; }
+        inline uint64_t getSeed() const { return seed; }
+        inline uint64_t getStream() const { return stream; }
+
+        // Independent stream of the same seed, for one thread or one task out of many
+        inline Random split(uint64_t streamId) const { return Random(seed, streamId); }
+
+    private:
+        void generateBlock(uint64_t block, uint32_t* words) const;
+
+        uint64_t seed;
+        uint64_t stream;
+        uint64_t position{0};
+        uint32_t buffer[4]{};
+
+        float spareNormal{0.0f};
+        bool hasSpareNormal{false};
+    };
+
+    // Seed of every threadRandom() stream, fixed by default so runs repeat. Setting it restarts the stream of
+    // each thread the next time that thread draws
+    void setGlobalSeed(uint64_t seed);
+    uint64_t getGlobalSeed();
+
+    // This thread's stream of the global seed. Streams are numbered in the order threads first draw, code that
+    // needs the same numbers from a thread pool on every run should split() a stream per task instead
+    Random& threadRandom();
+} // namespace NTARS
+
+#endif // NTARS_RANDOM_HPP
@@ -0,0 +1,151 @@
+#include "telemetry.hpp"
+
+#include "json/json.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace NTARS
+{
+    TrainingTelemetry::TrainingTelemetry(size_t historySize)
+        : history(std::max<size_t>(1, historySize))
+    {
+    }
+
+    void TrainingTelemetry::record(const StepTelemetry& step)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // copy-assigning into a slot reuses its idle vector once the ring has been around
+        history[next] = step;
+        history[next].step = recorded;
+        next = (next + 1) % history.size();
+        ++recorded;
+
+        totals.step = recorded;
+        totals.samples += step.samples;
+        totals.forwardMs += step.forwardMs;
+        totals.backwardMs += step.backwardMs;
+        totals.reduceMs += step.reduceMs;
+        totals.updateMs += step.updateMs;
+        totals.totalMs += step.totalMs;
+        totals.allocations += step.allocations;
+        totals.samplesPerSecond = totals.totalMs > 0.0 ? totals.samples * 1000.0 / totals.totalMs : 0.0;
+
+        if (totals.threadIdleMs.size() < step.threadIdleMs.size())
+            totals.threadIdleMs.resize(step.threadIdleMs.size());
+        for (size_t t = 0; t < step.threadIdleMs.size(); ++t)
+            totals.threadIdleMs[t] += step.threadIdleMs[t];
+    }
+
+    void TrainingTelemetry::reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        next = 0;
+        recorded = 0;
+        totals = StepTelemetry{};
+    }
+
+    StepTelemetry TrainingTelemetry::getLast() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (recorded == 0)
+            return StepTelemetry{};
+
+        return history[(next + history.size() - 1) % history.size()];
+    }
+
+    StepTelemetry TrainingTelemetry::getTotals() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return totals;
+    }
+
+    std::vector<StepTelemetry> TrainingTelemetry::getHistory() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        const size_t count = std::min(recorded, history.size());
+        std::vector<StepTelemetry> steps;
+        steps.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+            steps.push_back(history[(next + history.size() - count + i) % history.size()]);
+
+        return steps;
+    }
+
+    bool TrainingTelemetry::exportCSV(const std::filesystem::path& file) const
+    {
+        const std::vector<StepTelemetry> steps = getHistory();
+
+        size_t numThreads = 0;
+        for (const auto& step : steps)
+            numThreads = std::max(numThreads, step.threadIdleMs.size());
+
+        std::ofstream out(file);
+        if (!out.is_open())
+        {
+            std::cerr << "Could not open file for writing: " << file << std::endl;
+            return false;
+        }
+
+        out << "step,samples,forward_ms,backward_ms,reduce_ms,update_ms,total_ms,samples_per_second,allocations";
+        for (size_t t = 0; t < numThreads; ++t)
+            out << ",idle_ms_" << t;
+        out << '\n';
+
+        for (const auto& step : steps)
+        {
+            out << step.step << ',' << step.samples << ',' << step.forwardMs << ',' << step.backwardMs << ','
+                << step.reduceMs << ',' << step.updateMs << ',' << step.totalMs << ',' << step.samplesPerSecond << ','
+                << step.allocations;
+            for (size_t t = 0; t < numThreads; ++t)
+                out << ',' << (t < step.threadIdleMs.size() ? step.threadIdleMs[t] : 0.0);
+            out << '\n';
+        }
+
+        return !out.fail();
+    }
+
+    bool TrainingTelemetry::exportJSON(const std::filesystem::path& file) const
+    {
+        const std::vector<StepTelemetry> steps = getHistory();
+
+        nlohmann::json saved;
+        for (const auto& step : steps)
+        {
+            nlohmann::json stepJson;
+            stepJson["step"] = step.step;
+            stepJson["samples"] = step.samples;
+            stepJson["forward_ms"] = step.forwardMs;
+            stepJson["backward_ms"] = step.backwardMs;
+            stepJson["reduce_ms"] = step.reduceMs;
+            stepJson["update_ms"] = step.updateMs;
+            stepJson["total_ms"] = step.totalMs;
+            stepJson["samples_per_second"] = step.samplesPerSecond;
+            stepJson["allocations"] = step.allocations;
+            stepJson["thread_idle_ms"] = step.threadIdleMs;
+            saved["steps"].push_back(stepJson);
+        }
+
+        const StepTelemetry total = getTotals();
+        saved["totals"]["steps"] = total.step;
+        saved["totals"]["samples"] = total.samples;
+        saved["totals"]["total_ms"] = total.totalMs;
+        saved["totals"]["samples_per_second"] = total.samplesPerSecond;
+        saved["totals"]["allocations"] = total.allocations;
+
+        std::ofstream out(file);
+        if (!out.is_open())
+        {
+            std::cerr << "Could not open file for writing: " << file << std::endl;
+            return false;
+        }
+
+        out << saved.dump(4);
+        return !out.fail();
+    }
+} // namespace NTARS
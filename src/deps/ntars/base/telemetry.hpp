@@ -0,0 +1,73 @@
+#ifndef NTARS_TELEMETRY_HPP
+#define NTARS_TELEMETRY_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+namespace NTARS
+{
+    // Heap allocations made by the calling thread so far. They are only counted in builds with
+    // NTARS_COUNT_ALLOCATIONS, which replaces the global operator new, and are always 0 otherwise
+    uint64_t getThreadAllocationCount();
+
+    // Where one trainCPU call spent its time, in milliseconds. Forward and backward are the average busy time
+    // of the threads that computed gradients, idle is how long each of them waited for the slowest one.
+    // Reduce covers folding the per-thread gradients and the all-reduce between ranks
+    struct StepTelemetry
+    {
+        uint64_t step{0};
+        size_t samples{0};
+
+        double forwardMs{0};
+        double backwardMs{0};
+        double reduceMs{0};
+        double updateMs{0};
+        double totalMs{0};
+        double samplesPerSecond{0};
+
+        uint64_t allocations{0};        // on the training threads, during the step, 0 unless counted
+        std::vector<double> threadIdleMs;
+    };
+
+    // Per-step counters kept by a network, recorded by the training thread and read from any other
+    class TrainingTelemetry
+    {
+    public:
+        explicit TrainingTelemetry(size_t historySize = 1024);
+
+        inline void setEnabled(bool enable) { enabled = enable; }
+        inline bool isEnabled() const { return enabled; }
+
+        void record(const StepTelemetry& step);
+        void reset();
+
+        StepTelemetry getLast() const;
+        // Sums over every recorded step, samplesPerSecond is the overall rate
+        StepTelemetry getTotals() const;
+        // Up to historySize most recent steps, oldest first
+        std::vector<StepTelemetry> getHistory() const;
+
+        bool exportCSV(const std::filesystem::path& file) const;
+        bool exportJSON(const std::filesystem::path& file) const;
+
+    private:
+        bool enabled{true};
+
+        mutable std::mutex mutex;
+        std::vector<StepTelemetry> history;     // ring buffer, next is the slot written next
+        size_t next{0};
+        size_t recorded{0};
+        StepTelemetry totals;
+    };
+
+    // Milliseconds since start, for the phase timers
+    inline double elapsedMs(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+} // namespace NTARS
+
+#endif // NTARS_TELEMETRY_HPP
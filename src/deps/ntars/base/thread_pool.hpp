@@ -0,0 +1,141 @@
+#ifndef NTARS_THREAD_POOL_HPP
+#define NTARS_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace NTARS
+{
+    // Persistent workers for the training loop, dispatching a job allocates nothing
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(size_t numThreads = 0)
+        {
+            if (numThreads == 0)
+                numThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+            for (size_t i = 1; i < numThreads; ++i)
+                workers.emplace_back([this]() { workerLoop(); });
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+
+            for (auto& worker : workers)
+                worker.join();
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // The calling thread counts as one of the threads
+        inline size_t size() const { return workers.size() + 1; }
+
+        // Calls fn(index) for every index in [0, count) and blocks until all of them returned
+        template<typename F>
+        void parallelFor(size_t count, F&& fn)
+        {
+            if (count == 0)
+                return;
+
+            std::lock_guard<std::mutex> dispatchLock(dispatchMutex);
+
+            if (workers.empty() || count == 1)
+            {
+                for (size_t i = 0; i < count; ++i)
+                    fn(i);
+                return;
+            }
+
+            using Fn = std::remove_reference_t<F>;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                task = [](void* context, size_t index) { (*static_cast<Fn*>(context))(index); };
+                taskContext = const_cast<void*>(static_cast<const void*>(&fn));
+                taskCount = count;
+                nextIndex.store(0, std::memory_order_relaxed);
+                finishedWorkers = 0;
+                ++generation;
+            }
+            wake.notify_all();
+
+            runTasks(task, taskContext, count);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            // every worker has to check in, otherwise a late one could pick up the next job with this job's task
+            done.wait(lock, [&]() { return finishedWorkers == workers.size(); });
+        }
+
+    private:
+        using Task = void (*)(void*, size_t);
+
+        void runTasks(Task currentTask, void* context, size_t count)
+        {
+            size_t index;
+            while ((index = nextIndex.fetch_add(1, std::memory_order_relaxed)) < count)
+                currentTask(context, index);
+        }
+
+        void workerLoop()
+        {
+            uint64_t seenGeneration = 0;
+
+            while (true)
+            {
+                Task currentTask;
+                void* context;
+                size_t count;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+
+                    if (stopping)
+                        return;
+
+                    seenGeneration = generation;
+                    currentTask = task;
+                    context = taskContext;
+                    count = taskCount;
+                }
+
+                runTasks(currentTask, context, count);
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++finishedWorkers;
+                }
+                done.notify_all();
+            }
+        }
+
+        std::vector<std::thread> workers;
+
+        std::mutex dispatchMutex;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+
+        Task task{nullptr};
+        void* taskContext{nullptr};
+        size_t taskCount{0};
+        uint64_t generation{0};
+        size_t finishedWorkers{0};
+        bool stopping{false};
+
+        std::atomic<size_t> nextIndex{0};
+    };
+} // namespace NTARS
+
+#endif // NTARS_THREAD_POOL_HPP
@@ -0,0 +1,124 @@
+#include "process.hpp"
+
+#include <iostream>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <spawn.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+
+    extern char** environ;
+#endif
+
+namespace NTARS
+{
+    ChildProcess::~ChildProcess()
+    {
+        if (isRunning())
+            wait();
+    }
+
+    ChildProcess::ChildProcess(ChildProcess&& other) noexcept
+        : handle(other.handle)
+    {
+        other.handle = invalidHandle;
+    }
+
+    ChildProcess& ChildProcess::operator=(ChildProcess&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (isRunning())
+                wait();
+
+            handle = other.handle;
+            other.handle = invalidHandle;
+        }
+
+        return *this;
+    }
+
+    bool ChildProcess::start(const std::filesystem::path& executable, const std::vector<std::string>& arguments)
+    {
+        #ifdef _WIN32
+        std::wstring commandLine = L"\"" + executable.wstring() + L"\"";
+        for (const auto& argument : arguments)
+            commandLine += L" \"" + std::filesystem::path(argument).wstring() + L"\"";
+
+        STARTUPINFOW startup{};
+        startup.cb = sizeof(startup);
+        PROCESS_INFORMATION info{};
+
+        if (!CreateProcessW(executable.c_str(), commandLine.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &info))
+        {
+            std::cerr << "Could not start " << executable.string() << std::endl;
+            return false;
+        }
+
+        CloseHandle(info.hThread);
+        handle = reinterpret_cast<intptr_t>(info.hProcess);
+        #else
+        const std::string program = executable.string();
+
+        std::vector<char*> argv;
+        argv.push_back(const_cast<char*>(program.c_str()));
+        for (const auto& argument : arguments)
+            argv.push_back(const_cast<char*>(argument.c_str()));
+        argv.push_back(nullptr);
+
+        pid_t pid;
+        if (posix_spawn(&pid, program.c_str(), nullptr, nullptr, argv.data(), environ) != 0)
+        {
+            std::cerr << "Could not start " << program << std::endl;
+            return false;
+        }
+
+        handle = static_cast<intptr_t>(pid);
+        #endif
+
+        return true;
+    }
+
+    int32_t ChildProcess::wait()
+    {
+        if (!isRunning())
+            return -1;
+
+        int32_t exitCode = -1;
+
+        #ifdef _WIN32
+        HANDLE process = reinterpret_cast<HANDLE>(handle);
+        DWORD code;
+        if (WaitForSingleObject(process, INFINITE) == WAIT_OBJECT_0 && GetExitCodeProcess(process, &code))
+            exitCode = static_cast<int32_t>(code);
+        CloseHandle(process);
+        #else
+        int status;
+        if (waitpid(static_cast<pid_t>(handle), &status, 0) > 0 && WIFEXITED(status))
+            exitCode = WEXITSTATUS(status);
+        #endif
+
+        handle = invalidHandle;
+        return exitCode;
+    }
+
+    std::filesystem::path ChildProcess::currentExecutable()
+    {
+        #ifdef _WIN32
+        std::wstring path(MAX_PATH, L'\0');
+        DWORD length;
+        while ((length = GetModuleFileNameW(nullptr, path.data(), static_cast<DWORD>(path.size()))) == path.size())
+            path.resize(path.size() * 2);
+
+        path.resize(length);
+        return path;
+        #else
+        return std::filesystem::read_symlink("/proc/self/exe");
+        #endif
+    }
+} // namespace NTARS
@@ -0,0 +1,38 @@
+#ifndef NTARS_PROCESS_HPP
+#define NTARS_PROCESS_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace NTARS
+{
+    // Worker process started from an executable, waited on when it goes out of scope
+    class ChildProcess
+    {
+    public:
+        ChildProcess() = default;
+        ~ChildProcess();
+
+        ChildProcess(const ChildProcess&) = delete;
+        ChildProcess& operator=(const ChildProcess&) = delete;
+        ChildProcess(ChildProcess&& other) noexcept;
+        ChildProcess& operator=(ChildProcess&& other) noexcept;
+
+        bool start(const std::filesystem::path& executable, const std::vector<std::string>& arguments);
+
+        // Exit code of the process, -1 if it could not be waited on
+        int32_t wait();
+
+        inline bool isRunning() const { return handle != invalidHandle; }
+
+        static std::filesystem::path currentExecutable();
+
+    private:
+        static constexpr intptr_t invalidHandle = -1;
+        intptr_t handle{invalidHandle};
+    };
+} // namespace NTARS
+
+#endif // NTARS_PROCESS_HPP
@@ -0,0 +1,85 @@
+#include "ring_all_reduce.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace NTARS
+{
+    RingAllReduce::RingAllReduce(std::unique_ptr<Transport> transport, size_t chunkFloats)
+        : transport(std::move(transport)), chunkFloats(std::max<size_t>(1, chunkFloats))
+    {
+        sendBuffer.resize(2 * this->chunkFloats);
+        recvBuffer.resize(2 * this->chunkFloats);
+    }
+
+    bool RingAllReduce::sum(float* data, size_t count)
+    {
+        const int64_t ranks = static_cast<int64_t>(getWorldSize());
+        const int64_t rank = static_cast<int64_t>(getRank());
+        if (ranks == 1 || count == 0)
+            return true;
+
+        const int64_t chunks = static_cast<int64_t>((count + chunkFloats - 1) / chunkFloats);
+        const int64_t lastHop = 2 * ranks - 2;
+
+        auto chunkSize = [&](int64_t chunk) { return std::min(chunkFloats, count - chunk * chunkFloats); };
+        auto valid = [&](int64_t chunk) { return chunk >= 0 && chunk < chunks; };
+
+        // Chunk k leaves rank 0 at step k and takes hop h (rank h - 1 to rank h, modulo the ring) at step k + h - 1.
+        // Hops 1 .. ranks - 1 accumulate, hops ranks .. 2 * ranks - 2 hand the finished sum around.
+        for (int64_t step = 0; step < chunks + lastHop - 1; ++step)
+        {
+            // per step a rank sends at most one accumulating and one finished chunk, both to the next rank
+            const int64_t sendReduce = step - rank;                                       // hop rank + 1
+            const int64_t sendFinal = rank + 1 <= ranks - 2 ? step - ranks - rank : -1;   // hop ranks + rank + 1
+            const int64_t recvReduce = rank >= 1 ? step + 1 - rank : -1;                  // hop rank
+            const int64_t recvFinal = rank <= ranks - 2 ? step + 1 - ranks - rank : -1;   // hop ranks + rank
+
+            size_t sendFloats = 0;
+            for (int64_t chunk : {sendReduce, sendFinal})
+            {
+                if (!valid(chunk))
+                    continue;
+
+                const float* source = data + chunk * chunkFloats;
+                std::copy(source, source + chunkSize(chunk), sendBuffer.begin() + sendFloats);
+                sendFloats += chunkSize(chunk);
+            }
+
+            size_t recvFloats = 0;
+            for (int64_t chunk : {recvReduce, recvFinal})
+            {
+                if (valid(chunk))
+                    recvFloats += chunkSize(chunk);
+            }
+
+            if (!transport->sendRecv(sendBuffer.data(), sendFloats * sizeof(float), recvBuffer.data(), recvFloats * sizeof(float)))
+                return false;
+
+            const float* received = recvBuffer.data();
+            if (valid(recvReduce))
+            {
+                // the partial sum of every earlier rank, this rank's part goes on top
+                float* target = data + recvReduce * chunkFloats;
+                for (size_t i = 0; i < chunkSize(recvReduce); ++i)
+                    target[i] = received[i] + target[i];
+
+                received += chunkSize(recvReduce);
+            }
+
+            if (valid(recvFinal))
+                std::copy(received, received + chunkSize(recvFinal), data + recvFinal * chunkFloats);
+        }
+
+        return true;
+    }
+
+    bool RingAllReduce::broadcast(float* data, size_t count)
+    {
+        // adding zeros leaves rank 0's values untouched
+        if (getRank() != 0)
+            std::fill(data, data + count, 0.0f);
+
+        return sum(data, count);
+    }
+} // namespace NTARS
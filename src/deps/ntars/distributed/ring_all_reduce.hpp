@@ -0,0 +1,39 @@
+#ifndef NTARS_RING_ALL_REDUCE_HPP
+#define NTARS_RING_ALL_REDUCE_HPP
+
+#include "ntars/distributed/transport.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace NTARS
+{
+    // Sums a buffer across every rank of a ring. Chunks are pipelined around the ring: they pick up each
+    // rank's contribution in rank order on the way from rank 0 to the last rank, then travel on as the
+    // finished sum. Every link carries each element about twice, like a reduce-scatter/all-gather ring,
+    // but the additions always happen as ((g0 + g1) + g2) + ..., the same order trainCPU uses to fold its
+    // per-thread gradients, so the result does not depend on how the buffer was chunked.
+    class RingAllReduce
+    {
+    public:
+        RingAllReduce(std::unique_ptr<Transport> transport, size_t chunkFloats = 16384);
+
+        bool sum(float* data, size_t count);
+
+        // Everyone ends up with rank 0's data
+        bool broadcast(float* data, size_t count);
+
+        inline size_t getRank() const { return transport->getRank(); }
+        inline size_t getWorldSize() const { return transport->getWorldSize(); }
+        inline Transport& getTransport() { return *transport; }
+
+    private:
+        std::unique_ptr<Transport> transport;
+        size_t chunkFloats;
+
+        std::vector<float> sendBuffer;
+        std::vector<float> recvBuffer;
+    };
+} // namespace NTARS
+
+#endif // NTARS_RING_ALL_REDUCE_HPP
@@ -0,0 +1,186 @@
+#include "transport.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace NTARS
+{
+    // Single slot mailbox owned by one rank: the owner posts into its slot, the next rank consumes it.
+    // The segment starts zeroed, so every counter starts at 0 without any setup.
+    struct SharedMemoryTransport::Mailbox
+    {
+        alignas(64) std::atomic<uint64_t> posted;
+        std::atomic<uint64_t> postedBytes;
+        alignas(64) std::atomic<uint64_t> consumed;
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared memory counters have to be address free");
+
+    static constexpr size_t mailboxStride = 128;
+
+    SharedMemoryTransport::SharedMemoryTransport(const TransportConfig& config)
+        : Transport(config), slotBytes((config.slotBytes + 63) / 64 * 64)
+    {
+    }
+
+    SharedMemoryTransport::~SharedMemoryTransport()
+    {
+        if (segment == nullptr)
+            return;
+
+        #ifdef _WIN32
+        UnmapViewOfFile(segment);
+        CloseHandle(static_cast<HANDLE>(mappingHandle));
+        #else
+        munmap(segment, segmentBytes);
+
+        // ranks that still have it mapped keep their view, the name just goes away
+        if (rank == 0)
+            shm_unlink(segmentName.c_str());
+        #endif
+    }
+
+    bool SharedMemoryTransport::open(const std::string& session)
+    {
+        static_assert(sizeof(Mailbox) <= mailboxStride, "Mailbox does not fit its stride");
+        segmentBytes = worldSize * (mailboxStride + slotBytes);
+
+        // every rank creates or opens the same segment, whoever comes first sizes it
+        #ifdef _WIN32
+        segmentName = "Local\\tars-" + session;
+        HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            static_cast<DWORD>(static_cast<uint64_t>(segmentBytes) >> 32), static_cast<DWORD>(segmentBytes), segmentName.c_str());
+        if (mapping == nullptr)
+        {
+            std::cerr << "Could not create shared memory segment " << segmentName << std::endl;
+            return false;
+        }
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, segmentBytes);
+        if (view == nullptr)
+        {
+            CloseHandle(mapping);
+            std::cerr << "Could not map shared memory segment " << segmentName << std::endl;
+            return false;
+        }
+
+        mappingHandle = mapping;
+        segment = view;
+        #else
+        segmentName = "/tars-" + session;
+        int fd = shm_open(segmentName.c_str(), O_CREAT | O_RDWR, 0600);
+        if (fd < 0 || ftruncate(fd, static_cast<off_t>(segmentBytes)) != 0)
+        {
+            if (fd >= 0)
+                ::close(fd);
+
+            std::cerr << "Could not create shared memory segment " << segmentName << std::endl;
+            return false;
+        }
+
+        void* view = mmap(nullptr, segmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if (view == MAP_FAILED)
+        {
+            std::cerr << "Could not map shared memory segment " << segmentName << std::endl;
+            return false;
+        }
+
+        segment = view;
+        #endif
+
+        return true;
+    }
+
+    SharedMemoryTransport::Mailbox& SharedMemoryTransport::mailbox(size_t owner) const
+    {
+        return *std::launder(reinterpret_cast<Mailbox*>(static_cast<std::byte*>(segment) + owner * mailboxStride));
+    }
+
+    std::byte* SharedMemoryTransport::slot(size_t owner) const
+    {
+        return static_cast<std::byte*>(segment) + worldSize * mailboxStride + owner * slotBytes;
+    }
+
+    bool SharedMemoryTransport::sendRecv(const void* sendData, size_t sendBytes, void* recvData, size_t recvBytes)
+    {
+        Mailbox& outbox = mailbox(rank);
+        Mailbox& inbox = mailbox(getPrevious());
+
+        const std::byte* source = static_cast<const std::byte*>(sendData);
+        std::byte* destination = static_cast<std::byte*>(recvData);
+
+        size_t sent = 0;
+        size_t received = 0;
+        size_t idleSpins = 0;
+        auto lastProgress = std::chrono::steady_clock::now();
+
+        // messages bigger than a slot go through in pieces, sending and receiving interleaved
+        while (sent < sendBytes || received < recvBytes)
+        {
+            bool progressed = false;
+
+            const uint64_t posted = outbox.posted.load(std::memory_order_relaxed);
+            if (sent < sendBytes && outbox.consumed.load(std::memory_order_acquire) == posted)
+            {
+                const size_t bytes = std::min(slotBytes, sendBytes - sent);
+                std::memcpy(slot(rank), source + sent, bytes);
+                outbox.postedBytes.store(bytes, std::memory_order_relaxed);
+                outbox.posted.store(posted + 1, std::memory_order_release);
+
+                sent += bytes;
+                progressed = true;
+            }
+
+            const uint64_t consumed = inbox.consumed.load(std::memory_order_relaxed);
+            if (received < recvBytes && inbox.posted.load(std::memory_order_acquire) != consumed)
+            {
+                const size_t bytes = inbox.postedBytes.load(std::memory_order_relaxed);
+                if (bytes > recvBytes - received)
+                {
+                    std::cerr << "Shared memory transport received more than expected from rank " << getPrevious() << std::endl;
+                    return false;
+                }
+
+                std::memcpy(destination + received, slot(getPrevious()), bytes);
+                inbox.consumed.store(consumed + 1, std::memory_order_release);
+
+                received += bytes;
+                progressed = true;
+            }
+
+            if (progressed)
+            {
+                idleSpins = 0;
+                lastProgress = std::chrono::steady_clock::now();
+            }
+            else if (++idleSpins > 1000)
+            {
+                std::this_thread::yield();
+
+                if (std::chrono::steady_clock::now() - lastProgress > timeout)
+                {
+                    std::cerr << "Shared memory transport timed out on rank " << rank << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+} // namespace NTARS
@@ -0,0 +1,273 @@
+#include "transport.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #include <afunix.h>
+
+    using NativeSocket = SOCKET;
+    #define pollSockets WSAPoll
+    static constexpr int sendFlags = 0;
+    static void closeSocket(intptr_t handle) { closesocket(static_cast<SOCKET>(handle)); }
+    static bool wouldBlock() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+#else
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+    #include <cerrno>
+
+    using NativeSocket = int;
+    #define pollSockets poll
+    static constexpr int sendFlags = MSG_NOSIGNAL;
+    static void closeSocket(intptr_t handle) { ::close(static_cast<int>(handle)); }
+    static bool wouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+#endif
+
+namespace NTARS
+{
+    static NativeSocket native(intptr_t handle) { return static_cast<NativeSocket>(handle); }
+
+    static void setNonBlocking(intptr_t handle)
+    {
+        #ifdef _WIN32
+        u_long enabled = 1;
+        ioctlsocket(native(handle), FIONBIO, &enabled);
+        #else
+        fcntl(native(handle), F_SETFL, fcntl(native(handle), F_GETFL, 0) | O_NONBLOCK);
+        #endif
+    }
+
+    SocketTransport::SocketTransport(const TransportConfig& config)
+        : Transport(config), type(config.type)
+    {
+        #ifdef _WIN32
+        WSADATA data;
+        WSAStartup(MAKEWORD(2, 2), &data);
+        #endif
+    }
+
+    SocketTransport::~SocketTransport()
+    {
+        for (intptr_t handle : {listener, nextSocket, previousSocket})
+        {
+            if (handle != -1)
+                closeSocket(handle);
+        }
+
+        if (type == TransportType_UnixSocket && listener != -1)
+        {
+            std::error_code error;
+            std::filesystem::remove(socketPath(sessionName, rank), error);
+        }
+
+        #ifdef _WIN32
+        WSACleanup();
+        #endif
+    }
+
+    std::filesystem::path SocketTransport::socketPath(const std::string& session, size_t owner) const
+    {
+        return std::filesystem::temp_directory_path() / ("tars-" + session + "-" + std::to_string(owner) + ".sock");
+    }
+
+    bool SocketTransport::open(const std::string& session, uint16_t basePort)
+    {
+        sessionName = session;
+
+        // listen before connecting, so every connect finds its peer's backlog sooner or later
+        if (!listenOn(session, basePort) || !connectTo(session, basePort) || !acceptFrom())
+            return false;
+
+        setNonBlocking(nextSocket);
+        setNonBlocking(previousSocket);
+        return true;
+    }
+
+    bool SocketTransport::listenOn(const std::string& session, uint16_t basePort)
+    {
+        if (type == TransportType_UnixSocket)
+        {
+            const std::string path = socketPath(session, rank).string();
+
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (path.size() >= sizeof(address.sun_path))
+            {
+                std::cerr << "Socket path is too long: " << path << std::endl;
+                return false;
+            }
+            std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+            std::error_code error;
+            std::filesystem::remove(path, error);
+
+            listener = static_cast<intptr_t>(socket(AF_UNIX, SOCK_STREAM, 0));
+            if (bind(native(listener), reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(native(listener), 1) != 0)
+            {
+                std::cerr << "Could not listen on " << path << std::endl;
+                return false;
+            }
+
+            return true;
+        }
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(static_cast<uint16_t>(basePort + rank));
+
+        listener = static_cast<intptr_t>(socket(AF_INET, SOCK_STREAM, 0));
+
+        int reuse = 1;
+        setsockopt(native(listener), SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+        if (bind(native(listener), reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(native(listener), 1) != 0)
+        {
+            std::cerr << "Could not listen on port " << basePort + rank << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool SocketTransport::connectTo(const std::string& session, uint16_t basePort)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+        // the next rank may not be listening yet
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            int result;
+            if (type == TransportType_UnixSocket)
+            {
+                sockaddr_un address{};
+                address.sun_family = AF_UNIX;
+                std::strncpy(address.sun_path, socketPath(session, getNext()).string().c_str(), sizeof(address.sun_path) - 1);
+
+                nextSocket = static_cast<intptr_t>(socket(AF_UNIX, SOCK_STREAM, 0));
+                result = connect(native(nextSocket), reinterpret_cast<sockaddr*>(&address), sizeof(address));
+            }
+            else
+            {
+                sockaddr_in address{};
+                address.sin_family = AF_INET;
+                address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                address.sin_port = htons(static_cast<uint16_t>(basePort + getNext()));
+
+                nextSocket = static_cast<intptr_t>(socket(AF_INET, SOCK_STREAM, 0));
+                result = connect(native(nextSocket), reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+                int noDelay = 1;
+                setsockopt(native(nextSocket), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+            }
+
+            if (result == 0)
+            {
+                // tell the acceptor who is calling, it only takes its previous rank
+                const uint32_t caller = static_cast<uint32_t>(rank);
+                return send(native(nextSocket), reinterpret_cast<const char*>(&caller), sizeof(caller), sendFlags) == sizeof(caller);
+            }
+
+            closeSocket(nextSocket);
+            nextSocket = -1;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+
+        std::cerr << "Rank " << rank << " could not connect to rank " << getNext() << std::endl;
+        return false;
+    }
+
+    bool SocketTransport::acceptFrom()
+    {
+        previousSocket = static_cast<intptr_t>(accept(native(listener), nullptr, nullptr));
+
+        uint32_t caller = 0;
+        if (previousSocket == -1 || recv(native(previousSocket), reinterpret_cast<char*>(&caller), sizeof(caller), MSG_WAITALL) != sizeof(caller) ||
+            caller != getPrevious())
+        {
+            std::cerr << "Rank " << rank << " expected a connection from rank " << getPrevious() << std::endl;
+            return false;
+        }
+
+        if (type == TransportType_TCP)
+        {
+            int noDelay = 1;
+            setsockopt(native(previousSocket), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+        }
+
+        return true;
+    }
+
+    bool SocketTransport::sendRecv(const void* sendData, size_t sendBytes, void* recvData, size_t recvBytes)
+    {
+        const char* source = static_cast<const char*>(sendData);
+        char* destination = static_cast<char*>(recvData);
+
+        size_t sent = 0;
+        size_t received = 0;
+
+        while (sent < sendBytes || received < recvBytes)
+        {
+            pollfd fds[2]{};
+            int count = 0;
+            int sendIndex = -1;
+            int recvIndex = -1;
+
+            if (sent < sendBytes)
+            {
+                sendIndex = count;
+                fds[count++] = {native(nextSocket), POLLOUT, 0};
+            }
+            if (received < recvBytes)
+            {
+                recvIndex = count;
+                fds[count++] = {native(previousSocket), POLLIN, 0};
+            }
+
+            const int ready = pollSockets(fds, count, static_cast<int>(timeout.count()));
+            if (ready <= 0)
+            {
+                std::cerr << "Socket transport " << (ready == 0 ? "timed out" : "failed") << " on rank " << rank << std::endl;
+                return false;
+            }
+
+            if (sendIndex >= 0 && fds[sendIndex].revents & (POLLOUT | POLLERR | POLLHUP))
+            {
+                const auto result = send(native(nextSocket), source + sent, static_cast<int>(std::min<size_t>(sendBytes - sent, 1 << 30)), sendFlags);
+                if (result > 0)
+                    sent += static_cast<size_t>(result);
+                else if (result < 0 && !wouldBlock())
+                {
+                    std::cerr << "Rank " << rank << " lost its connection to rank " << getNext() << std::endl;
+                    return false;
+                }
+            }
+
+            if (recvIndex >= 0 && fds[recvIndex].revents & (POLLIN | POLLERR | POLLHUP))
+            {
+                const auto result = recv(native(previousSocket), destination + received, static_cast<int>(std::min<size_t>(recvBytes - received, 1 << 30)), 0);
+                if (result > 0)
+                    received += static_cast<size_t>(result);
+                else if (result == 0 || !wouldBlock())
+                {
+                    std::cerr << "Rank " << rank << " lost its connection to rank " << getPrevious() << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+} // namespace NTARS
@@ -0,0 +1,40 @@
+#include "transport.hpp"
+
+#include <iostream>
+
+namespace NTARS
+{
+    std::unique_ptr<Transport> createTransport(const TransportConfig& config)
+    {
+        if (config.worldSize == 0 || config.rank >= config.worldSize)
+        {
+            std::cerr << "Invalid rank " << config.rank << " for a world of " << config.worldSize << std::endl;
+            return nullptr;
+        }
+
+        if (config.type == TransportType_SharedMemory)
+        {
+            auto transport = std::make_unique<SharedMemoryTransport>(config);
+            if (!transport->open(config.session))
+                return nullptr;
+
+            return transport;
+        }
+
+        auto transport = std::make_unique<SocketTransport>(config);
+        if (!transport->open(config.session, config.basePort))
+            return nullptr;
+
+        return transport;
+    }
+
+    std::string getTransportName(TransportType_ type)
+    {
+        switch (type)
+        {
+            case TransportType_UnixSocket: return "Unix Socket";
+            case TransportType_TCP:        return "TCP";
+            default:                       return "Shared Memory";
+        }
+    }
+} // namespace NTARS
@@ -0,0 +1,119 @@
+#ifndef NTARS_TRANSPORT_HPP
+#define NTARS_TRANSPORT_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+namespace NTARS
+{
+    enum TransportType_
+    {
+        TransportType_SharedMemory = 0,
+        TransportType_UnixSocket,
+        TransportType_TCP,
+    };
+
+    struct TransportConfig
+    {
+        TransportType_ type{TransportType_SharedMemory};
+        size_t rank{0};
+        size_t worldSize{1};
+
+        // Has to be unique per run, it names the shared segment and the socket files
+        std::string session{"tars"};
+        uint16_t basePort{29500};           // TCP, rank r listens on basePort + r
+        size_t slotBytes{1 << 20};          // shared memory, largest single copy between two ranks
+        std::chrono::milliseconds timeout{60000};
+    };
+
+    // Point to point link of a ring: every rank sends to rank + 1 and receives from rank - 1
+    class Transport
+    {
+    public:
+        virtual ~Transport() = default;
+
+        virtual TransportType_ getType() const = 0;
+
+        // Sends to the next rank while receiving from the previous one, so a full ring of senders can't deadlock.
+        // Either side may be empty; both ends of a link have to agree on the sizes.
+        virtual bool sendRecv(const void* sendData, size_t sendBytes, void* recvData, size_t recvBytes) = 0;
+
+        inline size_t getRank() const { return rank; }
+        inline size_t getWorldSize() const { return worldSize; }
+        inline size_t getNext() const { return (rank + 1) % worldSize; }
+        inline size_t getPrevious() const { return (rank + worldSize - 1) % worldSize; }
+
+    protected:
+        Transport(const TransportConfig& config)
+            : rank(config.rank), worldSize(config.worldSize), timeout(config.timeout) {}
+
+        size_t rank;
+        size_t worldSize;
+        std::chrono::milliseconds timeout;
+    };
+
+    class SharedMemoryTransport : public Transport
+    {
+    public:
+        SharedMemoryTransport(const TransportConfig& config);
+        ~SharedMemoryTransport() override;
+
+        TransportType_ getType() const override { return TransportType_SharedMemory; }
+        bool sendRecv(const void* sendData, size_t sendBytes, void* recvData, size_t recvBytes) override;
+
+        bool open(const std::string& session);
+
+    private:
+        struct Mailbox;
+
+        Mailbox& mailbox(size_t owner) const;
+        std::byte* slot(size_t owner) const;
+
+        size_t slotBytes;
+        size_t segmentBytes{0};
+        std::string segmentName;
+        void* segment{nullptr};
+
+        #ifdef _WIN32
+        void* mappingHandle{nullptr};
+        #endif
+    };
+
+    class SocketTransport : public Transport
+    {
+    public:
+        SocketTransport(const TransportConfig& config);
+        ~SocketTransport() override;
+
+        TransportType_ getType() const override { return type; }
+        bool sendRecv(const void* sendData, size_t sendBytes, void* recvData, size_t recvBytes) override;
+
+        bool open(const std::string& session, uint16_t basePort);
+
+    private:
+        bool listenOn(const std::string& session, uint16_t basePort);
+        bool connectTo(const std::string& session, uint16_t basePort);
+        bool acceptFrom();
+
+        std::filesystem::path socketPath(const std::string& session, size_t owner) const;
+
+        TransportType_ type;
+        std::string sessionName;
+
+        // native socket handles, -1 when closed
+        intptr_t listener{-1};
+        intptr_t nextSocket{-1};
+        intptr_t previousSocket{-1};
+    };
+
+    // Opens and connects the transport of one rank, prints the reason and returns null on failure
+    std::unique_ptr<Transport> createTransport(const TransportConfig& config);
+
+    std::string getTransportName(TransportType_ type);
+} // namespace NTARS
+
+#endif // NTARS_TRANSPORT_HPP
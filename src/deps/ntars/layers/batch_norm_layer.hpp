@@ -0,0 +1,243 @@
+#ifndef NTARS_BATCH_NORM_LAYER_HPP
+#define NTARS_BATCH_NORM_LAYER_HPP
+
+#include "ntars/layers/layer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace NTARS
+{
+    // Normalizes every channel to zero mean and unit variance, then scales by gamma (the weights, one per channel)
+    // and shifts by beta (the biases) before its own activation. Normalize, affine and activation are one pass
+    // over the data. Training uses the statistics of the whole mini-batch, inference the running estimates.
+    // Placed right after a Linear Dense or Conv2D layer, SequentialNetwork::fold() merges it into that layer
+    class BatchNormLayer : public Layer
+    {
+    public:
+        BatchNormLayer(TensorShape inputShape, NeuralNetworkFlags_ flags = NeuralNetworkFlags_None, float momentum = 0.9f, float epsilon = 1e-5f)
+            : Layer(inputShape, inputShape), _flags(flags), momentum(momentum), epsilon(epsilon), state(2 * inputShape.channels, 0.0f)
+        {
+            std::fill(state.begin() + inputShape.channels, state.end(), 1.0f);
+        }
+
+        LayerType_ getType() const override { return LayerType_BatchNorm; }
+        LayerRecord getRecord() const override { return {LayerType_BatchNorm, static_cast<uint32_t>(getActivation()), static_cast<uint32_t>(channels()), 0, 0, 0, {}}; }
+
+        size_t getWeightRows() const override { return channels(); }
+        size_t getWeightCols() const override { return 1; }
+        // a scale and a shift per channel
+        size_t getScratchSize() const override { return 2 * channels(); }
+        double getForwardFlops() const override { return 2.0 * inputShape.size(); }
+
+        // gamma starts at 1 and beta at 0, so a fresh layer only normalizes
+        void initializeParameters(float* weights, float* biases) const override
+        {
+            std::fill(weights, weights + channels(), 1.0f);
+            std::fill(biases, biases + channels(), 0.0f);
+        }
+
+        void forward(const float* inputs, const float* weights, const float* biases, float* outputs, size_t count, float* scratch) const override
+        {
+            float* scale = scratch;
+            float* shift = scratch + channels();
+            for (size_t c = 0; c < channels(); ++c)
+            {
+                scale[c] = weights[c] / std::sqrt(runningVariance()[c] + epsilon);
+                shift[c] = biases[c] - runningMean()[c] * scale[c];
+            }
+
+            normalize(inputs, outputs, count, scale, shift);
+        }
+
+        // sum and sum of squares of every channel, then the number of values per channel
+        size_t getStatisticsSize() const override { return 2 * channels() + 1; }
+
+        void addStatistics(const float* inputs, size_t count, float* statistics) const override
+        {
+            for (size_t c = 0; c < channels(); ++c)
+            {
+                double sum = 0.0;
+                double squares = 0.0;
+                for (size_t s = 0; s < count; ++s)
+                {
+                    const float* channel = inputs + s * inputShape.size() + c * positions();
+                    for (size_t p = 0; p < positions(); ++p)
+                    {
+                        sum += channel[p];
+                        squares += double(channel[p]) * channel[p];
+                    }
+                }
+
+                statistics[c] += static_cast<float>(sum);
+                statistics[channels() + c] += static_cast<float>(squares);
+            }
+            statistics[2 * channels()] += static_cast<float>(count * positions());
+        }
+
+        void forwardTraining(const float* inputs, const float* weights, const float* biases, float* outputs, size_t count, float* scratch, const float* statistics) const override
+        {
+            float* scale = scratch;
+            float* shift = scratch + channels();
+            for (size_t c = 0; c < channels(); ++c)
+            {
+                float mean, variance;
+                moments(statistics, c, mean, variance);
+                scale[c] = weights[c] / std::sqrt(variance + epsilon);
+                shift[c] = biases[c] - mean * scale[c];
+            }
+
+            normalize(inputs, outputs, count, scale, shift);
+        }
+
+        // the descent direction of the pre-activations summed per channel, then its sum weighted by the normalized inputs
+        size_t getDeltaStatisticsSize() const override { return 2 * channels(); }
+
+        void addDeltaStatistics(const float* inputs, const float* outputs, const float* outputDelta, size_t count,
+            const float* statistics, float* deltaStatistics) const override
+        {
+            const NeuralNetworkFlags_ activation = getActivation();
+            for (size_t c = 0; c < channels(); ++c)
+            {
+                float mean, variance;
+                moments(statistics, c, mean, variance);
+                const float invStd = 1.0f / std::sqrt(variance + epsilon);
+
+                double deltaSum = 0.0;
+                double deltaNormalizedSum = 0.0;
+                for (size_t s = 0; s < count; ++s)
+                {
+                    const size_t offset = s * inputShape.size() + c * positions();
+                    for (size_t p = 0; p < positions(); ++p)
+                    {
+                        const float d = outputDelta[offset + p] * activationDerivative(outputs[offset + p], activation);
+                        deltaSum += d;
+                        deltaNormalizedSum += d * (inputs[offset + p] - mean) * invStd;
+                    }
+                }
+
+                deltaStatistics[c] += static_cast<float>(deltaSum);
+                deltaStatistics[channels() + c] += static_cast<float>(deltaNormalizedSum);
+            }
+        }
+
+        void backwardTraining(const float* inputs, const float* outputs, float* outputDelta, const float* weights,
+            float* weightGradient, float* biasGradient, float* inputDelta, size_t count, float*, const float* statistics, const float* deltaStatistics) const override
+        {
+            applyActivationDerivative(outputDelta, outputs, count * inputShape.size(), getActivation());
+
+            const float values = statistics[2 * channels()];
+            for (size_t c = 0; c < channels(); ++c)
+            {
+                float mean, variance;
+                moments(statistics, c, mean, variance);
+                const float invStd = 1.0f / std::sqrt(variance + epsilon);
+
+                // this thread's share of the gamma and beta gradients, the network adds the shares of every thread
+                double deltaSum = 0.0;
+                double deltaNormalizedSum = 0.0;
+                for (size_t s = 0; s < count; ++s)
+                {
+                    const size_t offset = s * inputShape.size() + c * positions();
+                    for (size_t p = 0; p < positions(); ++p)
+                    {
+                        const float d = outputDelta[offset + p];
+                        deltaSum += d;
+                        deltaNormalizedSum += d * (inputs[offset + p] - mean) * invStd;
+                    }
+                }
+
+                weightGradient[c] += static_cast<float>(deltaNormalizedSum);
+                biasGradient[c] += static_cast<float>(deltaSum);
+
+                if (!inputDelta)
+                    continue;
+
+                // the batch mean and variance depend on every input of the mini-batch, hence the two correction terms
+                const float meanDelta = deltaStatistics[c] / values;
+                const float meanDeltaNormalized = deltaStatistics[channels() + c] / values;
+                const float factor = weights[c] * invStd;
+                for (size_t s = 0; s < count; ++s)
+                {
+                    const size_t offset = s * inputShape.size() + c * positions();
+                    for (size_t p = 0; p < positions(); ++p)
+                    {
+                        const float normalized = (inputs[offset + p] - mean) * invStd;
+                        inputDelta[offset + p] = factor * (outputDelta[offset + p] - meanDelta - normalized * meanDeltaNormalized);
+                    }
+                }
+            }
+        }
+
+        // The count samples as a batch of their own
+        void backward(const float* inputs, const float* outputs, float* outputDelta, const float* weights,
+            float* weightGradient, float* biasGradient, float* inputDelta, size_t count, float* scratch) const override
+        {
+            std::vector<float> statistics(getStatisticsSize(), 0.0f);
+            std::vector<float> deltaStatistics(getDeltaStatisticsSize(), 0.0f);
+            addStatistics(inputs, count, statistics.data());
+            addDeltaStatistics(inputs, outputs, outputDelta, count, statistics.data(), deltaStatistics.data());
+            backwardTraining(inputs, outputs, outputDelta, weights, weightGradient, biasGradient, inputDelta, count, scratch,
+                statistics.data(), deltaStatistics.data());
+        }
+
+        void updateState(const float* statistics) override
+        {
+            if (statistics[2 * channels()] == 0.0f)
+                return;
+
+            float* runningMean = state.data();
+            float* runningVariance = state.data() + channels();
+            for (size_t c = 0; c < channels(); ++c)
+            {
+                float mean, variance;
+                moments(statistics, c, mean, variance);
+                runningMean[c] = momentum * runningMean[c] + (1.0f - momentum) * mean;
+                runningVariance[c] = momentum * runningVariance[c] + (1.0f - momentum) * variance;
+            }
+        }
+
+        // running means of every channel, then running variances
+        size_t getStateSize() const override { return state.size(); }
+        float* getState() override { return state.data(); }
+
+        inline NeuralNetworkFlags_ getActivation() const { return Layer::getActivation(_flags); }
+        inline float getEpsilon() const { return epsilon; }
+        inline const float* runningMean() const { return state.data(); }
+        inline const float* runningVariance() const { return state.data() + channels(); }
+
+    private:
+        inline size_t channels() const { return inputShape.channels; }
+        inline size_t positions() const { return inputShape.height * inputShape.width; }
+
+        inline void moments(const float* statistics, size_t c, float& mean, float& variance) const
+        {
+            const double values = statistics[2 * channels()];
+            const double channelMean = statistics[c] / values;
+            mean = static_cast<float>(channelMean);
+            variance = static_cast<float>(std::max(0.0, statistics[channels() + c] / values - channelMean * channelMean));
+        }
+
+        void normalize(const float* inputs, float* outputs, size_t count, const float* scale, const float* shift) const
+        {
+            const NeuralNetworkFlags_ activation = getActivation();
+            for (size_t s = 0; s < count; ++s)
+            {
+                for (size_t c = 0; c < channels(); ++c)
+                {
+                    const size_t offset = s * inputShape.size() + c * positions();
+                    for (size_t p = 0; p < positions(); ++p)
+                        outputs[offset + p] = activate(inputs[offset + p] * scale[c] + shift[c], activation);
+                }
+            }
+        }
+
+        NeuralNetworkFlags_ _flags;
+        float momentum;
+        float epsilon;
+        std::vector<float> state;
+    };
+} // namespace NTARS
+
+#endif // NTARS_BATCH_NORM_LAYER_HPP
@@ -0,0 +1,196 @@
+#ifndef NTARS_CONV2D_LAYER_HPP
+#define NTARS_CONV2D_LAYER_HPP
+
+#include "ntars/layers/layer.hpp"
+#include "tarsmath/linear_algebra/simd_kernels.hpp"
+
+#include <algorithm>
+
+namespace NTARS
+{
+    // Square kernel convolution over a channels x height x width input, one bias per filter.
+    // Weights are [filters x channels * kernel * kernel]. Both passes go through im2col: every output position
+    // becomes a column of its receptive field, so the convolution is one GEMM per sample and the
+    // weight gradient and input delta are the two transposed products
+    class Conv2DLayer : public Layer
+    {
+    public:
+        Conv2DLayer(TensorShape inputShape, size_t filters, size_t kernel, size_t stride = 1, size_t padding = 0, NeuralNetworkFlags_ flags = NeuralNetworkFlags_ReLU)
+            : Layer(inputShape, {filters, (inputShape.height + 2 * padding - kernel) / stride + 1, (inputShape.width + 2 * padding - kernel) / stride + 1}),
+              filters(filters), kernel(kernel), stride(stride), padding(padding), _flags(flags)
+        {
+        }
+
+        LayerType_ getType() const override { return LayerType_Conv2D; }
+
+        LayerRecord getRecord() const override
+        {
+            return {LayerType_Conv2D, static_cast<uint32_t>(getActivation()),
+                static_cast<uint32_t>(filters), static_cast<uint32_t>(kernel), static_cast<uint32_t>(stride), static_cast<uint32_t>(padding), {}};
+        }
+
+        size_t getWeightRows() const override { return filters; }
+        size_t getWeightCols() const override { return patchSize(); }
+        // the columns of one sample and their gradient
+        size_t getScratchSize() const override { return 2 * patchSize() * positions(); }
+        double getForwardFlops() const override { return 2.0 * filters * patchSize() * positions(); }
+
+        void forward(const float* inputs, const float* weights, const float* biases, float* outputs, size_t count, float* scratch) const override
+        {
+            const size_t inputSize = inputShape.size();
+            const size_t outputSize = outputShape.size();
+
+            for (size_t s = 0; s < count; ++s)
+            {
+                const float* columns = pointwise() ? inputs + s * inputSize : im2col(inputs + s * inputSize, scratch);
+                float* sampleOutputs = outputs + s * outputSize;
+
+                for (size_t f = 0; f < filters; ++f)
+                    std::fill(sampleOutputs + f * positions(), sampleOutputs + (f + 1) * positions(), biases[f]);
+
+                TMATH::gemm(weights, columns, sampleOutputs, filters, positions(), patchSize());
+                activate(sampleOutputs, outputSize, getActivation());
+            }
+        }
+
+        void backward(const float* inputs, const float* outputs, float* outputDelta, const float* weights,
+            float* weightGradient, float* biasGradient, float* inputDelta, size_t count, float* scratch) const override
+        {
+            const size_t inputSize = inputShape.size();
+            const size_t outputSize = outputShape.size();
+            float* columnDelta = scratch + patchSize() * positions();
+
+            applyActivationDerivative(outputDelta, outputs, count * outputSize, getActivation());
+
+            for (size_t s = 0; s < count; ++s)
+            {
+                const float* sampleDelta = outputDelta + s * outputSize;
+                const float* columns = pointwise() ? inputs + s * inputSize : im2col(inputs + s * inputSize, scratch);
+
+                // dW += delta * columns^T, db += sum of delta over the positions
+                TMATH::gemmTransB(sampleDelta, columns, weightGradient, filters, patchSize(), positions());
+                for (size_t f = 0; f < filters; ++f)
+                {
+                    const float* filterDelta = sampleDelta + f * positions();
+                    for (size_t p = 0; p < positions(); ++p)
+                        biasGradient[f] += filterDelta[p];
+                }
+
+                if (!inputDelta)
+                    continue;
+
+                // dColumns = W^T * delta, then every column adds back onto the inputs it was gathered from
+                float* sampleInputDelta = inputDelta + s * inputSize;
+                if (pointwise())
+                {
+                    std::fill(sampleInputDelta, sampleInputDelta + inputSize, 0.0f);
+                    TMATH::gemmTransA(weights, sampleDelta, sampleInputDelta, patchSize(), positions(), filters);
+                    continue;
+                }
+
+                std::fill(columnDelta, columnDelta + patchSize() * positions(), 0.0f);
+                TMATH::gemmTransA(weights, sampleDelta, columnDelta, patchSize(), positions(), filters);
+                col2im(columnDelta, sampleInputDelta);
+            }
+        }
+
+        inline bool usesReLU() const { return getActivation() == NeuralNetworkFlags_ReLU; }
+        inline NeuralNetworkFlags_ getActivation() const { return Layer::getActivation(_flags); }
+        inline size_t getFilters() const { return filters; }
+        inline size_t getKernel() const { return kernel; }
+        inline size_t getStride() const { return stride; }
+        inline size_t getPadding() const { return padding; }
+
+    private:
+        inline size_t patchSize() const { return inputShape.channels * kernel * kernel; }
+        inline size_t positions() const { return outputShape.height * outputShape.width; }
+        // a 1x1 kernel with stride 1 reads the input as its own column matrix
+        inline bool pointwise() const { return kernel == 1 && stride == 1 && padding == 0; }
+
+        // columns[(c * kernel + ky) * kernel + kx][oy * outWidth + ox], zero where the window hangs over the padding
+        const float* im2col(const float* input, float* columns) const
+        {
+            const size_t height = inputShape.height;
+            const size_t width = inputShape.width;
+            const size_t outHeight = outputShape.height;
+            const size_t outWidth = outputShape.width;
+
+            for (size_t c = 0; c < inputShape.channels; ++c)
+            {
+                const float* channel = input + c * height * width;
+                for (size_t ky = 0; ky < kernel; ++ky)
+                {
+                    for (size_t kx = 0; kx < kernel; ++kx)
+                    {
+                        float* row = columns + ((c * kernel + ky) * kernel + kx) * positions();
+                        for (size_t oy = 0; oy < outHeight; ++oy)
+                        {
+                            const int64_t y = static_cast<int64_t>(oy * stride + ky) - static_cast<int64_t>(padding);
+                            float* rowOut = row + oy * outWidth;
+                            if (y < 0 || y >= static_cast<int64_t>(height))
+                            {
+                                std::fill(rowOut, rowOut + outWidth, 0.0f);
+                                continue;
+                            }
+
+                            const float* inputRow = channel + y * width;
+                            for (size_t ox = 0; ox < outWidth; ++ox)
+                            {
+                                const int64_t x = static_cast<int64_t>(ox * stride + kx) - static_cast<int64_t>(padding);
+                                rowOut[ox] = (x < 0 || x >= static_cast<int64_t>(width)) ? 0.0f : inputRow[x];
+                            }
+                        }
+                    }
+                }
+            }
+
+            return columns;
+        }
+
+        // The adjoint of im2col, overwrites input
+        void col2im(const float* columns, float* input) const
+        {
+            const size_t height = inputShape.height;
+            const size_t width = inputShape.width;
+            const size_t outHeight = outputShape.height;
+            const size_t outWidth = outputShape.width;
+
+            std::fill(input, input + inputShape.size(), 0.0f);
+            for (size_t c = 0; c < inputShape.channels; ++c)
+            {
+                float* channel = input + c * height * width;
+                for (size_t ky = 0; ky < kernel; ++ky)
+                {
+                    for (size_t kx = 0; kx < kernel; ++kx)
+                    {
+                        const float* row = columns + ((c * kernel + ky) * kernel + kx) * positions();
+                        for (size_t oy = 0; oy < outHeight; ++oy)
+                        {
+                            const int64_t y = static_cast<int64_t>(oy * stride + ky) - static_cast<int64_t>(padding);
+                            if (y < 0 || y >= static_cast<int64_t>(height))
+                                continue;
+
+                            float* inputRow = channel + y * width;
+                            const float* rowIn = row + oy * outWidth;
+                            for (size_t ox = 0; ox < outWidth; ++ox)
+                            {
+                                const int64_t x = static_cast<int64_t>(ox * stride + kx) - static_cast<int64_t>(padding);
+                                if (x >= 0 && x < static_cast<int64_t>(width))
+                                    inputRow[x] += rowIn[ox];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        size_t filters;
+        size_t kernel;
+        size_t stride;
+        size_t padding;
+
+        NeuralNetworkFlags_ _flags;
+    };
+} // namespace NTARS
+
+#endif // NTARS_CONV2D_LAYER_HPP
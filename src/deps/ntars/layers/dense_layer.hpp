@@ -3,16 +3,19 @@
 
 #include <vector>
 #include "tarsmath/linear_algebra/matrix_component.hpp"
+#include "tarsmath/linear_algebra/simd_kernels.hpp"
 #include "ntars/base/neuron.hpp"
+#include "ntars/layers/layer.hpp"
+#include "ntars/layers/dropout_layer.hpp"
 #include "json/json.hpp"
 
 namespace NTARS
 {
-    class DenseLayer
+    class DenseLayer : public Layer
     {
     public:
         DenseLayer(size_t numNeurons, size_t numInputs, NeuralNetworkFlags_ flags = NeuralNetworkFlags_None)
-            : numNeurons(numNeurons), numInputs(numInputs), _flags(flags)
+            : Layer({numInputs, 1, 1}, {numNeurons, 1, 1}), numNeurons(numNeurons), numInputs(numInputs), _flags(flags)
         {
             _activations.resize(numNeurons);
             for (size_t i = 0; i < numNeurons; ++i)
@@ -39,6 +42,91 @@ namespace NTARS
             return activations;
         }
         
+        // Reentrant forward pass, writes numNeurons activations to outputs and leaves the layer untouched
+        void forward(const float* inputs, const float* weights, const float* biases, float* outputs) const
+        {
+            const NeuralNetworkFlags_ activation = getActivation();
+
+            for (size_t i = 0; i < numNeurons; ++i)
+            {
+                const float sum = TMATH::dot(inputs, weights + i * numInputs, numInputs) + biases[i];
+                outputs[i] = activate(sum, activation);
+            }
+        }
+
+        // Batched forward pass over count samples stored row after row, each weight row is loaded once per batch.
+        // Pre-activations are kept for backprop when preActivations is not null. With a dropout mask the outputs it
+        // drops are zeroed and the rest scaled by dropScale as they are activated
+        void forwardBatch(const float* inputs, const float* weights, const float* biases, float* preActivations, float* outputs, size_t count,
+            const uint32_t* dropMask = nullptr, float dropScale = 1.0f) const
+        {
+            const NeuralNetworkFlags_ activation = getActivation();
+
+            for (size_t i = 0; i < numNeurons; ++i)
+            {
+                const float* weightRow = weights + i * numInputs;
+
+                for (size_t s = 0; s < count; ++s)
+                {
+                    const float sum = TMATH::dot(inputs + s * numInputs, weightRow, numInputs) + biases[i];
+                    if (preActivations)
+                        preActivations[s * numNeurons + i] = sum;
+
+                    const float value = activate(sum, activation);
+                    if (dropMask)
+                        outputs[s * numNeurons + i] = DropoutLayer::isKept(dropMask, s * numNeurons + i) ? value * dropScale : 0.0f;
+                    else
+                        outputs[s * numNeurons + i] = value;
+                }
+            }
+        }
+
+        LayerType_ getType() const override { return LayerType_Dense; }
+
+        LayerRecord getRecord() const override
+        {
+            return {LayerType_Dense, static_cast<uint32_t>(getActivation()),
+                static_cast<uint32_t>(numNeurons), 0, 0, 0, {}};
+        }
+
+        size_t getWeightRows() const override { return numNeurons; }
+        size_t getWeightCols() const override { return numInputs; }
+        double getForwardFlops() const override { return 2.0 * numNeurons * numInputs; }
+
+        void forward(const float* inputs, const float* weights, const float* biases, float* outputs, size_t count, float*) const override
+        {
+            forwardBatch(inputs, weights, biases, nullptr, outputs, count);
+        }
+
+        void backward(const float* inputs, const float* outputs, float* outputDelta, const float* weights,
+            float* weightGradient, float* biasGradient, float* inputDelta, size_t count, float*) const override
+        {
+            applyActivationDerivative(outputDelta, outputs, count * numNeurons, getActivation());
+
+            for (size_t o = 0; o < numNeurons; ++o)
+            {
+                float* gradRow = weightGradient + o * numInputs;
+                for (size_t s = 0; s < count; ++s)
+                {
+                    const float d = outputDelta[s * numNeurons + o];
+                    TMATH::axpy(d, inputs + s * numInputs, gradRow, numInputs);
+                    biasGradient[o] += d;
+                }
+            }
+
+            if (!inputDelta)
+                return;
+
+            std::fill(inputDelta, inputDelta + count * numInputs, 0.0f);
+            for (size_t s = 0; s < count; ++s)
+            {
+                for (size_t o = 0; o < numNeurons; ++o)
+                    TMATH::axpy(outputDelta[s * numNeurons + o], weights + o * numInputs, inputDelta + s * numInputs, numInputs);
+            }
+        }
+
+        inline bool usesReLU() const { return getActivation() == NeuralNetworkFlags_ReLU; }
+        inline NeuralNetworkFlags_ getActivation() const { return Layer::getActivation(_flags); }
         inline size_t getNumInputs() const { return numInputs; }
         inline size_t getNumOutputs() const { return numNeurons; }
         inline Neuron& getNeuron(size_t index) { return _neurons.at(index); }
@@ -0,0 +1,90 @@
+#ifndef NTARS_DROPOUT_LAYER_HPP
+#define NTARS_DROPOUT_LAYER_HPP
+
+#include "tarsmath/linear_algebra/matrix_component.hpp"
+#include "ntars/base/random.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace NTARS
+{
+    // Inverted dropout on the outputs of a dense layer while training. The mask is one bit per output of every
+    // sample and is drawn for the whole batch at once; the layer's own activation kernels apply it and scale the
+    // kept outputs by 1 / (1 - rate) in the same pass, so inference runs the plain layer and never sees dropout.
+    // Like the graph layers it keeps no per-call state, the caller holds the mask from forward to backward
+    class DropoutLayer
+    {
+    public:
+        static constexpr float maxRate = 0.95f;
+
+        explicit DropoutLayer(size_t numInputs = 0, float rate = 0.0f)
+            : numInputs(numInputs), rate(std::clamp(rate, 0.0f, maxRate))
+        {
+            scale = 1.0f / (1.0f - this->rate);
+            threshold = static_cast<uint32_t>(std::min<double>(this->rate * 4294967296.0, 4294967295.0));
+        }
+
+        // Mask words for count samples
+        inline size_t getMaskWords(size_t count) const { return (count * numInputs + 31) / 32; }
+
+        // Bit s * numInputs + i keeps output i of sample s, set with probability 1 - rate
+        void generateMask(Random& random, uint32_t* mask, size_t count) const
+        {
+            const size_t words = getMaskWords(count);
+            if (threshold == 0)
+            {
+                std::fill(mask, mask + words, ~0u);
+                return;
+            }
+
+            // 32 draws per mask word, taken from the generator 256 at a time
+            uint32_t draws[256];
+            for (size_t w = 0; w < words; w += 8)
+            {
+                const size_t chunk = std::min<size_t>(8, words - w);
+                random.fillBits(draws, chunk * 32);
+
+                for (size_t k = 0; k < chunk; ++k)
+                    mask[w + k] = keepBits(draws + k * 32);
+            }
+        }
+
+        static inline bool isKept(const uint32_t* mask, size_t index) { return (mask[index >> 5] >> (index & 31)) & 1u; }
+
+        inline float getRate() const { return rate; }
+        inline float getScale() const { return scale; }
+        inline bool isActive() const { return rate > 0.0f; }
+        inline size_t getNumInputs() const { return numInputs; }
+
+    private:
+        inline uint32_t keepBits(const uint32_t* draws) const
+        {
+            uint32_t bits = 0;
+
+            #ifdef USE_SIMD
+            // unsigned draw >= threshold as a signed compare with both sides offset by 2^31
+            const __m256i offset = _mm256_set1_epi32(INT32_MIN);
+            const __m256i limit = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int32_t>(threshold - 1)), offset);
+            for (size_t g = 0; g < 4; ++g)
+            {
+                const __m256i draw = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(draws + g * 8)), offset);
+                const int kept = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(draw, limit)));
+                bits |= static_cast<uint32_t>(kept) << (g * 8);
+            }
+            #else
+            for (size_t j = 0; j < 32; ++j)
+                bits |= static_cast<uint32_t>(draws[j] >= threshold) << j;
+            #endif
+
+            return bits;
+        }
+
+        size_t numInputs;
+        float rate;
+        float scale;
+        uint32_t threshold;     // draws below it drop the output
+    };
+} // namespace NTARS
+
+#endif // NTARS_DROPOUT_LAYER_HPP
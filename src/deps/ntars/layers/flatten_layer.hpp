@@ -0,0 +1,36 @@
+#ifndef NTARS_FLATTEN_LAYER_HPP
+#define NTARS_FLATTEN_LAYER_HPP
+
+#include "ntars/layers/layer.hpp"
+
+#include <algorithm>
+
+namespace NTARS
+{
+    // Reinterprets a channels x height x width sample as a flat vector for the dense layers after it
+    class FlattenLayer : public Layer
+    {
+    public:
+        explicit FlattenLayer(TensorShape inputShape)
+            : Layer(inputShape, {inputShape.size(), 1, 1})
+        {
+        }
+
+        LayerType_ getType() const override { return LayerType_Flatten; }
+        LayerRecord getRecord() const override { return {LayerType_Flatten, 0, static_cast<uint32_t>(inputShape.size()), 0, 0, 0, {}}; }
+
+        void forward(const float* inputs, const float*, const float*, float* outputs, size_t count, float*) const override
+        {
+            std::copy_n(inputs, count * inputShape.size(), outputs);
+        }
+
+        void backward(const float*, const float*, float* outputDelta, const float*,
+            float*, float*, float* inputDelta, size_t count, float*) const override
+        {
+            if (inputDelta)
+                std::copy_n(outputDelta, count * inputShape.size(), inputDelta);
+        }
+    };
+} // namespace NTARS
+
+#endif // NTARS_FLATTEN_LAYER_HPP
@@ -0,0 +1,158 @@
+#ifndef NTARS_LAYER_HPP
+#define NTARS_LAYER_HPP
+
+#include "tarsmath/calculus/relu.hpp"
+#include "tarsmath/calculus/sigmoid.hpp"
+#include "ntars/base/neuron.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace NTARS
+{
+    enum LayerType_ : uint32_t
+    {
+        LayerType_Dense = 0,
+        LayerType_Conv2D,
+        LayerType_MaxPool2D,
+        LayerType_Flatten,
+        LayerType_BatchNorm,
+    };
+
+    // Channels x height x width, a sample is stored channel after channel. Flat vectors are {size, 1, 1}
+    struct TensorShape
+    {
+        size_t channels{0};
+        size_t height{1};
+        size_t width{1};
+
+        inline size_t size() const { return channels * height * width; }
+        bool operator==(const TensorShape& other) const = default;
+    };
+
+    // Everything a model file needs to rebuild a layer once its input shape is known
+    struct LayerRecord
+    {
+        uint32_t type;          // LayerType_
+        uint32_t flags;         // NeuralNetworkFlags_, picks the activation
+        uint32_t outputs;       // neurons or filters
+        uint32_t kernel;
+        uint32_t stride;
+        uint32_t padding;
+        uint32_t reserved[2];
+    };
+
+    // Node of a SequentialNetwork. A layer knows its shapes and settings but owns no trainable parameters and keeps
+    // no per-call state: the network passes weights, gradients and scratch in, so one layer serves every thread.
+    // Batched calls take count samples stored one after another.
+    class Layer
+    {
+    public:
+        Layer(TensorShape inputShape, TensorShape outputShape)
+            : inputShape(inputShape), outputShape(outputShape) {}
+
+        virtual ~Layer() = default;
+
+        virtual LayerType_ getType() const = 0;
+        virtual LayerRecord getRecord() const = 0;
+
+        // Weights are a rows x cols matrix with one bias per row, layers without parameters have 0 rows
+        virtual size_t getWeightRows() const { return 0; }
+        virtual size_t getWeightCols() const { return 0; }
+        // Floats of scratch one forward or backward call needs, independent of the batch size
+        virtual size_t getScratchSize() const { return 0; }
+        // Per sample, a multiply-add counts as two
+        virtual double getForwardFlops() const { return 0.0; }
+
+        // Overrides the network's random initialization for layers that need fixed starting values
+        virtual void initializeParameters(float*, float*) const {}
+
+        virtual void forward(const float* inputs, const float* weights, const float* biases, float* outputs, size_t count, float* scratch) const = 0;
+
+        // Layers with batch statistics normalize by those of the whole mini-batch, however it is split between
+        // threads. Every thread adds its samples to its own getStatisticsSize() floats with addStatistics, the
+        // network sums them and passes the sums to forwardTraining on every thread, and to updateState() once
+        // per step. The backward pass does the same with addDeltaStatistics and backwardTraining
+        virtual size_t getStatisticsSize() const { return 0; }
+        virtual void addStatistics(const float*, size_t, float*) const {}
+        virtual void updateState(const float*) {}
+
+        // Forward pass while training, statistics is null for layers without any
+        virtual void forwardTraining(const float* inputs, const float* weights, const float* biases, float* outputs, size_t count, float* scratch, const float*) const
+        {
+            forward(inputs, weights, biases, outputs, count, scratch);
+        }
+
+        virtual size_t getDeltaStatisticsSize() const { return 0; }
+        virtual void addDeltaStatistics(const float*, const float*, const float*, size_t, const float*, float*) const {}
+
+        // Values that are saved with the model but not trained, such as running statistics
+        virtual size_t getStateSize() const { return 0; }
+        virtual float* getState() { return nullptr; }
+
+        // outputDelta holds the descent direction of the outputs (expected - output at the last layer) and is turned
+        // into that of the pre-activations in place. Adds to the parameter gradients and, unless inputDelta is null,
+        // overwrites it with the descent direction of the inputs
+        virtual void backward(const float* inputs, const float* outputs, float* outputDelta, const float* weights,
+            float* weightGradient, float* biasGradient, float* inputDelta, size_t count, float* scratch) const = 0;
+
+        // Backward pass while training, with the summed statistics of the forward and backward pass
+        virtual void backwardTraining(const float* inputs, const float* outputs, float* outputDelta, const float* weights,
+            float* weightGradient, float* biasGradient, float* inputDelta, size_t count, float* scratch, const float*, const float*) const
+        {
+            backward(inputs, outputs, outputDelta, weights, weightGradient, biasGradient, inputDelta, count, scratch);
+        }
+
+        inline const TensorShape& getInputShape() const { return inputShape; }
+        inline const TensorShape& getOutputShape() const { return outputShape; }
+        inline size_t getParameterCount() const { return getWeightRows() * (getWeightCols() + 1); }
+
+        // The activation bit of a layer's flags: Linear, ReLU or sigmoid (None)
+        static NeuralNetworkFlags_ getActivation(NeuralNetworkFlags_ flags)
+        {
+            if (flags & NeuralNetworkFlags_Linear)
+                return NeuralNetworkFlags_Linear;
+            return flags & NeuralNetworkFlags_ReLU ? NeuralNetworkFlags_ReLU : NeuralNetworkFlags_None;
+        }
+
+        static float activate(float x, NeuralNetworkFlags_ activation)
+        {
+            if (activation == NeuralNetworkFlags_ReLU)
+                return TMATH::relu(x);
+            return activation == NeuralNetworkFlags_Linear ? x : TMATH::sigmoid(x);
+        }
+
+    protected:
+        static void activate(float* values, size_t size, NeuralNetworkFlags_ activation)
+        {
+            if (activation == NeuralNetworkFlags_Linear)
+                return;
+
+            for (size_t i = 0; i < size; ++i)
+                values[i] = activate(values[i], activation);
+        }
+
+        // every derivative follows from the activation itself, a ReLU output is positive exactly when its input is
+        static float activationDerivative(float output, NeuralNetworkFlags_ activation)
+        {
+            if (activation == NeuralNetworkFlags_Linear)
+                return 1.0f;
+            return activation == NeuralNetworkFlags_ReLU ? (output > 0.0f ? 1.0f : 0.0f) : output * (1.0f - output);
+        }
+
+        static void applyActivationDerivative(float* delta, const float* outputs, size_t size, NeuralNetworkFlags_ activation)
+        {
+            if (activation == NeuralNetworkFlags_Linear)
+                return;
+
+            const bool relu = activation == NeuralNetworkFlags_ReLU;
+            for (size_t i = 0; i < size; ++i)
+                delta[i] *= relu ? (outputs[i] > 0.0f ? 1.0f : 0.0f) : outputs[i] * (1.0f - outputs[i]);
+        }
+
+        TensorShape inputShape;
+        TensorShape outputShape;
+    };
+} // namespace NTARS
+
+#endif // NTARS_LAYER_HPP
@@ -0,0 +1,96 @@
+#ifndef NTARS_POOLING_LAYER_HPP
+#define NTARS_POOLING_LAYER_HPP
+
+#include "ntars/layers/layer.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace NTARS
+{
+    // Maximum over size x size windows of every channel, stride defaults to the window size
+    class MaxPool2DLayer : public Layer
+    {
+    public:
+        MaxPool2DLayer(TensorShape inputShape, size_t size, size_t stride = 0)
+            : Layer(inputShape, {inputShape.channels, (inputShape.height - size) / (stride ? stride : size) + 1, (inputShape.width - size) / (stride ? stride : size) + 1}),
+              size(size), stride(stride ? stride : size)
+        {
+        }
+
+        LayerType_ getType() const override { return LayerType_MaxPool2D; }
+
+        LayerRecord getRecord() const override
+        {
+            return {LayerType_MaxPool2D, 0, static_cast<uint32_t>(inputShape.channels), static_cast<uint32_t>(size), static_cast<uint32_t>(stride), 0, {}};
+        }
+
+        void forward(const float* inputs, const float*, const float*, float* outputs, size_t count, float*) const override
+        {
+            for (size_t s = 0; s < count; ++s)
+            {
+                for (size_t c = 0; c < inputShape.channels; ++c)
+                {
+                    const float* channel = inputs + s * inputShape.size() + c * inputShape.height * inputShape.width;
+                    float* channelOut = outputs + s * outputShape.size() + c * outputShape.height * outputShape.width;
+
+                    for (size_t oy = 0; oy < outputShape.height; ++oy)
+                        for (size_t ox = 0; ox < outputShape.width; ++ox)
+                            channelOut[oy * outputShape.width + ox] = channel[argmax(channel, oy, ox)];
+                }
+            }
+        }
+
+        // The gradient goes to the first maximum of each window, found again from the inputs instead of stored
+        void backward(const float* inputs, const float*, float* outputDelta, const float*,
+            float*, float*, float* inputDelta, size_t count, float*) const override
+        {
+            if (!inputDelta)
+                return;
+
+            std::fill(inputDelta, inputDelta + count * inputShape.size(), 0.0f);
+            for (size_t s = 0; s < count; ++s)
+            {
+                for (size_t c = 0; c < inputShape.channels; ++c)
+                {
+                    const size_t inputOffset = s * inputShape.size() + c * inputShape.height * inputShape.width;
+                    const float* channelDelta = outputDelta + s * outputShape.size() + c * outputShape.height * outputShape.width;
+
+                    for (size_t oy = 0; oy < outputShape.height; ++oy)
+                        for (size_t ox = 0; ox < outputShape.width; ++ox)
+                            inputDelta[inputOffset + argmax(inputs + inputOffset, oy, ox)] += channelDelta[oy * outputShape.width + ox];
+                }
+            }
+        }
+
+        inline size_t getSize() const { return size; }
+        inline size_t getStride() const { return stride; }
+
+    private:
+        size_t argmax(const float* channel, size_t oy, size_t ox) const
+        {
+            size_t best = oy * stride * inputShape.width + ox * stride;
+            float bestValue = -std::numeric_limits<float>::infinity();
+
+            for (size_t ky = 0; ky < size; ++ky)
+            {
+                const size_t row = (oy * stride + ky) * inputShape.width + ox * stride;
+                for (size_t kx = 0; kx < size; ++kx)
+                {
+                    if (channel[row + kx] > bestValue)
+                    {
+                        bestValue = channel[row + kx];
+                        best = row + kx;
+                    }
+                }
+            }
+
+            return best;
+        }
+
+        size_t size;
+        size_t stride;
+    };
+} // namespace NTARS
+
+#endif // NTARS_POOLING_LAYER_HPP
@@ -0,0 +1,58 @@
+#ifndef NTARS_SPARSE_DENSE_LAYER_HPP
+#define NTARS_SPARSE_DENSE_LAYER_HPP
+
+#include "ntars/layers/layer.hpp"
+#include "tarsmath/linear_algebra/simd_kernels.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace NTARS
+{
+    // Dense layer over one-hot inputs given as the indices of the features that are set, such as piece type x square.
+    // Weights are stored by column, [inputs x outputs], so every active feature adds one contiguous column to the
+    // biases and the inactive ones cost nothing. Like the graph layers it owns no parameters
+    class SparseDenseLayer
+    {
+    public:
+        SparseDenseLayer(size_t numNeurons, size_t numInputs, NeuralNetworkFlags_ flags = NeuralNetworkFlags_None)
+            : numNeurons(numNeurons), numInputs(numInputs), _flags(flags)
+        {
+        }
+
+        // Row-major [outputs x inputs] weights, as DenseLayer keeps them, into numInputs columns
+        void packColumns(const float* weights, float* columns) const
+        {
+            for (size_t o = 0; o < numNeurons; ++o)
+                for (size_t i = 0; i < numInputs; ++i)
+                    columns[i * numNeurons + o] = weights[o * numInputs + i];
+        }
+
+        // features are indices below numInputs, a feature listed twice counts twice
+        void forward(const uint32_t* features, size_t numFeatures, const float* columns, const float* biases, float* outputs) const
+        {
+            std::copy_n(biases, numNeurons, outputs);
+            for (size_t f = 0; f < numFeatures; ++f)
+                TMATH::add(columns + features[f] * numNeurons, outputs, numNeurons);
+
+            const NeuralNetworkFlags_ activation = getActivation();
+            if (activation == NeuralNetworkFlags_Linear)
+                return;
+
+            for (size_t o = 0; o < numNeurons; ++o)
+                outputs[o] = Layer::activate(outputs[o], activation);
+        }
+
+        inline NeuralNetworkFlags_ getActivation() const { return Layer::getActivation(_flags); }
+        inline size_t getNumInputs() const { return numInputs; }
+        inline size_t getNumOutputs() const { return numNeurons; }
+
+    private:
+        size_t numNeurons;
+        size_t numInputs;
+
+        NeuralNetworkFlags_ _flags;
+    };
+} // namespace NTARS
+
+#endif // NTARS_SPARSE_DENSE_LAYER_HPP
@@ -11,14 +11,16 @@ constexpr bool debug =
 
 #include <iostream>
 #include <filesystem>
+#include <cstring>
 #include <fstream>
-#include <random>
 
 #include <future>
 #include <mutex>
 #include <thread>
 
 #include "json/json.hpp"
+#include "ntars/base/model_format.hpp"
+#include "ntars/base/random.hpp"
 
 namespace NTARS
 {
@@ -27,15 +29,43 @@ namespace NTARS
     {
         initializeWeightsAndBiases(structure);
         createLayers(structure);
+        bindParameterViews();
         initializeTrainingBuffers();
+        publish();
     }
 
     DenseNeuralNetwork::DenseNeuralNetwork(const std::string &file)
     {
-        nlohmann::json loaded;
+        std::filesystem::path inputPath = std::filesystem::current_path() / "networks" / file;
+
+        if (inputPath.extension() == ".tars")
+        {
+            // a network only ever exported as JSON is imported once and then loads from its binary file
+            std::filesystem::path jsonPath = std::filesystem::path(inputPath).replace_extension(".json");
+            if (!std::filesystem::exists(inputPath) && std::filesystem::exists(jsonPath))
+            {
+                std::cout << "No binary model found, importing " << jsonPath.string() << std::endl;
+                if (loadJSON(jsonPath))
+                    save();
+            }
+            else
+            {
+                loadBinary(inputPath);
+            }
+        }
+        else
+        {
+            loadJSON(inputPath);
+        }
 
-        std::filesystem::path outputPath = std::filesystem::current_path() / "networks" / file;
-        std::ifstream inFile(outputPath);
+        initializeTrainingBuffers();
+        publish();
+    }
+
+    bool DenseNeuralNetwork::loadJSON(const std::filesystem::path &inputPath)
+    {
+        nlohmann::json loaded;
+        std::ifstream inFile(inputPath);
 
         try
         {
@@ -48,7 +78,7 @@ namespace NTARS
                     !loaded.contains("name") ||
                     !loaded.contains("structure"))
                 {
-                    throw std::runtime_error("JSON file '" + file + "' doesn't contain required keys: 'weights', 'biases', 'name', or 'structure'");
+                    throw std::runtime_error("JSON file '" + inputPath.string() + "' doesn't contain required keys: 'weights', 'biases', 'name', or 'structure'");
                 }
 
                 name.clear();
@@ -73,12 +103,14 @@ namespace NTARS
 
                 _structure = loaded["structure"].get<std::vector<size_t>>();
                 createLayers(_structure);
+                bindParameterViews();
 
-                std::cout << "Network loaded successfully: " << outputPath.string() << std::endl;
+                std::cout << "Network loaded successfully: " << inputPath.string() << std::endl;
+                return true;
             }
             else
             {
-                std::cerr << "Could not open file for loading: " << outputPath.string() << std::endl;
+                std::cerr << "Could not open file for loading: " << inputPath.string() << std::endl;
             }
         }
         catch (std::exception e)
@@ -86,7 +118,93 @@ namespace NTARS
             std::cerr << e.what() << std::endl;
         }
 
-        initializeTrainingBuffers();
+        return false;
+    }
+
+    bool DenseNeuralNetwork::loadBinary(const std::filesystem::path &inputPath)
+    {
+        auto reader = std::make_shared<FORMAT::ModelReader>();
+
+        if (!reader->open(inputPath))
+        {
+            std::cerr << reader->getError() << std::endl;
+            return false;
+        }
+
+        if (reader->findTensor(FORMAT::TensorKind_LayerGraph, 0))
+        {
+            std::cerr << "Model has non-dense layers, load it with SequentialNetwork: " << inputPath.string() << std::endl;
+            return false;
+        }
+
+        const std::vector<size_t> &structure = reader->getStructure();
+        for (uint32_t l = 0; l + 1 < structure.size(); ++l)
+        {
+            const FORMAT::TensorEntry *weightEntry = reader->findTensor(FORMAT::TensorKind_Weights, l);
+            const FORMAT::TensorEntry *biasEntry = reader->findTensor(FORMAT::TensorKind_Biases, l);
+
+            if (!weightEntry || !biasEntry ||
+                weightEntry->rows != structure[l + 1] || weightEntry->cols != structure[l] ||
+                biasEntry->rows != structure[l + 1])
+            {
+                std::cerr << "Model file has missing or mismatched tensors for layer " << l << ": " << inputPath.string() << std::endl;
+                return false;
+            }
+        }
+
+        name = reader->getName();
+        flags = static_cast<NeuralNetworkFlags_>(reader->getHeader().flags);
+        _structure = structure;
+
+        weights.clear();
+        biases.clear();
+        mappedModel = std::move(reader);
+
+        createLayers(_structure);
+        bindParameterViews();
+
+        std::cout << "Network mapped successfully: " << inputPath.string() << std::endl;
+        return true;
+    }
+
+    void DenseNeuralNetwork::bindParameterViews()
+    {
+        weightViews.resize(_layers.size());
+        biasViews.resize(_layers.size());
+
+        for (uint32_t l = 0; l < _layers.size(); ++l)
+        {
+            if (mappedModel)
+            {
+                weightViews[l] = mappedModel->tensorData(*mappedModel->findTensor(FORMAT::TensorKind_Weights, l));
+                biasViews[l] = mappedModel->tensorData(*mappedModel->findTensor(FORMAT::TensorKind_Biases, l));
+            }
+            else
+            {
+                weightViews[l] = weights[l].data();
+                biasViews[l] = biases[l].data();
+            }
+        }
+    }
+
+    void DenseNeuralNetwork::materialize()
+    {
+        if (!mappedModel)
+            return;
+
+        weights.clear();
+        biases.clear();
+        for (size_t l = 0; l < _layers.size(); ++l)
+        {
+            const size_t rows = _structure[l + 1];
+            const size_t cols = _structure[l];
+
+            weights.emplace_back(std::vector<float>(weightViews[l], weightViews[l] + rows * cols), rows, cols);
+            biases.emplace_back(std::vector<float>(biasViews[l], biasViews[l] + rows), rows, 1);
+        }
+
+        mappedModel.reset();
+        bindParameterViews();
     }
 
     DenseNeuralNetwork::~DenseNeuralNetwork()
@@ -99,16 +217,99 @@ namespace NTARS
         biasGradients.clear();
         for (size_t l = 0; l < _layers.size(); ++l)
         {
-            weightGradients.emplace_back(TMATH::Matrix_t<float>(weights[l].rows(), weights[l].cols()));
-            biasGradients.emplace_back(TMATH::Matrix_t<float>(biases[l].rows(), 1));
+            weightGradients.emplace_back(TMATH::Matrix_t<float>(_structure[l + 1], _structure[l]));
+            biasGradients.emplace_back(TMATH::Matrix_t<float>(_structure[l + 1], 1));
+        }
+
+        initializeOptimizerState();
+        _predictWorkspace = createWorkspace();
+    }
+
+    void DenseNeuralNetwork::initializeOptimizerState()
+    {
+        const size_t stateCount = optimizer->getStateCount();
+
+        weightOptimizerState.assign(_layers.size(), {});
+        biasOptimizerState.assign(_layers.size(), {});
+        for (size_t l = 0; l < _layers.size(); ++l)
+        {
+            for (size_t s = 0; s < stateCount; ++s)
+            {
+                weightOptimizerState[l].emplace_back(_structure[l + 1], _structure[l]);
+                biasOptimizerState[l].emplace_back(_structure[l + 1], 1);
+            }
+        }
+    }
+
+    void DenseNeuralNetwork::setOptimizer(std::unique_ptr<Optimizer> newOptimizer)
+    {
+        optimizer = newOptimizer ? std::move(newOptimizer) : std::make_unique<SGDOptimizer>();
+        initializeOptimizerState();
+    }
+
+    bool DenseNeuralNetwork::setDropout(size_t layer, float rate)
+    {
+        // the output layer's values are the prediction itself
+        if (layer + 1 >= _layers.size() || rate < 0.0f || rate > DropoutLayer::maxRate)
+        {
+            std::cerr << "Dropout needs a hidden layer and a rate between 0 and " << DropoutLayer::maxRate << std::endl;
+            return false;
+        }
+
+        if (dropouts.empty())
+        {
+            for (size_t l = 0; l < _layers.size(); ++l)
+                dropouts.emplace_back(_layers[l].getNumOutputs());
+
+            Random& random = threadRandom();
+            dropoutSeed = (static_cast<uint64_t>(random()) << 32) | random();
+        }
+
+        dropouts[layer] = DropoutLayer(_layers[layer].getNumOutputs(), rate);
+        return true;
+    }
+
+    void DenseNeuralNetwork::drawDropoutMasks(size_t thread, size_t count)
+    {
+        for (size_t l = 0; l < dropouts.size(); ++l)
+        {
+            if (dropouts[l].isActive())
+                dropouts[l].generateMask(dropoutStreams[thread], dropoutMasks[thread].data() + dropoutMaskOffsets[l], count);
+        }
+    }
+
+    const uint32_t *DenseNeuralNetwork::dropoutMask(size_t thread, size_t l) const
+    {
+        if (l >= dropouts.size() || !dropouts[l].isActive())
+            return nullptr;
+
+        return dropoutMasks[thread].data() + dropoutMaskOffsets[l];
+    }
+
+    void DenseNeuralNetwork::applyOptimizer(float learningRate, float batchSize)
+    {
+        optimizer->beginStep();
+
+        const size_t stateCount = optimizer->getStateCount();
+        std::array<float*, 2> weightState{};
+        std::array<float*, 2> biasState{};
+
+        for (size_t l = 0; l < _layers.size(); ++l)
+        {
+            for (size_t s = 0; s < stateCount; ++s)
+            {
+                weightState[s] = weightOptimizerState[l][s].data();
+                biasState[s] = biasOptimizerState[l][s].data();
+            }
+
+            optimizer->update(weights[l].data(), weightGradients[l].data(), weightState.data(), weights[l].size(), learningRate, 1.0f / batchSize, true);
+            optimizer->update(biases[l].data(), biasGradients[l].data(), biasState.data(), biases[l].size(), learningRate, 1.0f / batchSize, false);
         }
     }
 
     void DenseNeuralNetwork::initializeWeightsAndBiases(const std::vector<size_t> &structure)
     {
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        std::normal_distribution<float> dist(0.0, 1.0);
+        Random& random = threadRandom();
 
         weights.clear();
         biases.clear();
@@ -121,13 +322,7 @@ namespace NTARS
             float scale = std::sqrt(2.0 / (numInputs + numOutputs));
 
             TMATH::Matrix_t<float> weightMatrix(numOutputs, numInputs);
-            for (size_t j = 0; j < numOutputs; ++j)
-            {
-                for (size_t k = 0; k < numInputs; ++k)
-                {
-                    weightMatrix.at(j, k) = dist(gen) * scale;
-                }
-            }
+            random.fillNormal(weightMatrix.data(), weightMatrix.size(), 0.0f, scale);
 
             TMATH::Matrix_t<float> biasMatrix(numOutputs, 1);
             for (size_t j = 0; j < numOutputs; ++j)
@@ -155,6 +350,8 @@ namespace NTARS
 
     ForwardResult DenseNeuralNetwork::run(const std::vector<float> &inputs)
     {
+        materialize();
+
         std::vector<float> currentInputs = inputs;
         std::vector<std::vector<float>> activations(_layers.size());
 
@@ -167,162 +364,1392 @@ namespace NTARS
         return ForwardResult{currentInputs, activations};
     }
 
-    void DenseNeuralNetwork::save()
+    ForwardContext DenseNeuralNetwork::createContext() const
     {
-        nlohmann::json saved;
+        ForwardContext context;
+        context.activations.reserve(_layers.size());
 
-        saved["structure"] = _structure;
-        saved["name"] = name;
-        saved["flags"] = flags;
+        for (const auto &layer : _layers)
+            context.activations.emplace_back(layer.getNumOutputs());
 
-        for (const auto &weightMatrix : weights)
+        return context;
+    }
+
+    const std::vector<float> &DenseNeuralNetwork::run(const std::vector<float> &inputs, ForwardContext &context) const
+    {
+        return runWith(inputs, context, weightViews.data(), biasViews.data());
+    }
+
+    const std::vector<float> &DenseNeuralNetwork::run(const std::vector<float> &inputs, ForwardContext &context, const WeightSnapshot &snapshot) const
+    {
+        return runWith(inputs, context, snapshot.weights.data(), snapshot.biases.data());
+    }
+
+    const std::vector<float> &DenseNeuralNetwork::runWith(const std::vector<float> &inputs, ForwardContext &context, const float *const *weightData, const float *const *biasData) const
+    {
+        assert(inputs.size() == _structure.front() && "Input size does not match the network structure");
+
+        if (context.activations.size() != _layers.size())
+            context = createContext();
+
+        const float *currentInputs = inputs.data();
+        for (size_t l = 0; l < _layers.size(); ++l)
         {
-            nlohmann::json weightJson;
-            weightJson["data"] = weightMatrix.getElementsRaw();
-            weightJson["rows"] = weightMatrix.rows();
-            weightJson["cols"] = weightMatrix.cols();
-            saved["weights"].push_back(weightJson);
+            float *outputs = context.activations[l].data();
+            _layers[l].forward(currentInputs, weightData[l], biasData[l], outputs);
+            currentInputs = outputs;
         }
 
-        for (auto &biasMatrix : biases)
+        return context.output();
+    }
+
+    std::vector<std::vector<float>> DenseNeuralNetwork::runBatch(const std::vector<std::vector<float>> &inputs, size_t numThreads) const
+    {
+        std::vector<std::vector<float>> outputs(inputs.size());
+        if (inputs.empty())
+            return outputs;
+
+        if (numThreads == 0)
+            numThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        numThreads = std::min(numThreads, inputs.size());
+
+        const size_t chunkSize = inputs.size() / numThreads;
+
+        std::vector<std::future<void>> futures;
+        for (size_t t = 0; t < numThreads; ++t)
         {
-            saved["biases"].push_back(biasMatrix.getElementsRaw());
+            futures.emplace_back(std::async(std::launch::async, [&, t]()
+            {
+                size_t start = t * chunkSize;
+                size_t end = (t == numThreads - 1) ? inputs.size() : (t + 1) * chunkSize;
+
+                ForwardContext context = createContext();
+                for (size_t i = start; i < end; ++i)
+                    outputs[i] = run(inputs[i], context);
+            }));
         }
 
-        std::filesystem::path outputPath = std::filesystem::current_path() / "networks";
+        for (auto &fut : futures)
+            fut.get();
 
-        if (!std::filesystem::exists(outputPath))
+        return outputs;
+    }
+
+    PredictWorkspace DenseNeuralNetwork::createWorkspace() const
+    {
+        const size_t widest = _structure.empty() ? 0 : *std::max_element(_structure.begin(), _structure.end());
+        return PredictWorkspace{std::vector<float>(widest), std::vector<float>(widest), {}};
+    }
+
+    std::span<const float> DenseNeuralNetwork::predict(const float *inputs, PredictWorkspace &workspace) const
+    {
+        return predictWith(inputs, workspace, weightViews.data(), biasViews.data());
+    }
+
+    std::span<const float> DenseNeuralNetwork::predict(const float *inputs, PredictWorkspace &workspace, const WeightSnapshot &snapshot) const
+    {
+        return predictWith(inputs, workspace, snapshot.weights.data(), snapshot.biases.data());
+    }
+
+    std::span<const float> DenseNeuralNetwork::predictWith(const float *inputs, PredictWorkspace &workspace, const float *const *weightData, const float *const *biasData) const
+    {
+        const size_t widest = *std::max_element(_structure.begin(), _structure.end());
+        if (workspace.front.size() < widest || workspace.back.size() < widest)
+            workspace = createWorkspace();
+
+        const float *currentInputs = inputs;
+        float *outputs = workspace.front.data();
+        float *spare = workspace.back.data();
+
+        for (size_t l = 0; l < _layers.size(); ++l)
         {
-            std::filesystem::create_directory(outputPath);
+            _layers[l].forward(currentInputs, weightData[l], biasData[l], outputs);
+            currentInputs = outputs;
+            std::swap(outputs, spare);
         }
 
-        std::ofstream outFile(outputPath / std::string(name + ".json"));
+        return std::span<const float>(currentInputs, _layers.back().getNumOutputs());
+    }
 
-        if (outFile.is_open())
+    void DenseNeuralNetwork::predictBatch(const float *inputs, size_t count, float *outputs, PredictWorkspace &workspace) const
+    {
+        predictBatchWith(inputs, count, outputs, workspace, weightViews.data(), biasViews.data());
+    }
+
+    void DenseNeuralNetwork::predictBatch(const float *inputs, size_t count, float *outputs, PredictWorkspace &workspace, const WeightSnapshot &snapshot) const
+    {
+        predictBatchWith(inputs, count, outputs, workspace, snapshot.weights.data(), snapshot.biases.data());
+    }
+
+    void DenseNeuralNetwork::predictBatchWith(const float *inputs, size_t count, float *outputs, PredictWorkspace &workspace, const float *const *weightData, const float *const *biasData) const
+    {
+        const size_t widest = *std::max_element(_structure.begin(), _structure.end());
+        if (workspace.front.size() < widest * count)
+            workspace.front.resize(widest * count);
+        if (workspace.back.size() < widest * count)
+            workspace.back.resize(widest * count);
+
+        const float *currentInputs = inputs;
+        float *current = workspace.front.data();
+        float *spare = workspace.back.data();
+
+        for (size_t l = 0; l < _layers.size(); ++l)
         {
-            outFile << saved.dump();
-            outFile.close();
-            std::cout << "Network saved successfully: " << outputPath << std::endl;
+            float *layerOutputs = (l == _layers.size() - 1) ? outputs : current;
+            _layers[l].forwardBatch(currentInputs, weightData[l], biasData[l], nullptr, layerOutputs, count);
+            currentInputs = layerOutputs;
+            std::swap(current, spare);
+        }
+    }
+
+    std::span<const float> DenseNeuralNetwork::predict(const std::vector<float> &inputs)
+    {
+        assert(inputs.size() == _structure.front() && "Input size does not match the network structure");
+        return predict(inputs.data(), _predictWorkspace);
+    }
+
+    uint64_t DenseNeuralNetwork::publish()
+    {
+        std::lock_guard<std::mutex> lock(publishMutex);
+
+        // the snapshot replaced last time is no longer reachable, once no reader holds it its memory is reused
+        std::shared_ptr<WeightSnapshot> snapshot;
+        if (retiredSnapshot && retiredSnapshot.use_count() == 1)
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            snapshot = std::move(retiredSnapshot);
         }
         else
         {
-            std::cerr << "Could not open file for writing: " << outputPath << std::endl;
+            snapshot = std::make_shared<WeightSnapshot>();
+        }
+
+        snapshot->version = ++snapshotVersion;
+        snapshot->weights.resize(_layers.size());
+        snapshot->biases.resize(_layers.size());
+
+        if (mappedModel)
+        {
+            // the mapping is read-only, readers can share it without a copy
+            snapshot->mapping = mappedModel;
+            snapshot->storage.clear();
+            std::copy(weightViews.begin(), weightViews.end(), snapshot->weights.begin());
+            std::copy(biasViews.begin(), biasViews.end(), snapshot->biases.begin());
+        }
+        else
+        {
+            snapshot->mapping.reset();
+
+            size_t total = 0;
+            for (size_t l = 0; l < _layers.size(); ++l)
+                total += weights[l].size() + biases[l].size();
+            snapshot->storage.resize(total);
+
+            float *cursor = snapshot->storage.data();
+            for (size_t l = 0; l < _layers.size(); ++l)
+            {
+                snapshot->weights[l] = cursor;
+                cursor = std::copy(weightViews[l], weightViews[l] + weights[l].size(), cursor);
+                snapshot->biases[l] = cursor;
+                cursor = std::copy(biasViews[l], biasViews[l] + biases[l].size(), cursor);
+            }
         }
+
+        std::shared_ptr<const WeightSnapshot> previous = publishedSnapshot.exchange(snapshot, std::memory_order_acq_rel);
+        retiredSnapshot = std::const_pointer_cast<WeightSnapshot>(previous);
+
+        return snapshot->version;
     }
 
-    void DenseNeuralNetwork::train(std::vector<NTARS::DATA::TrainingData<std::vector<float>>> &miniBatch, float learningRate)
+    void DenseNeuralNetwork::releaseMapping()
     {
+        materialize();
+
+        const std::shared_ptr<const WeightSnapshot> current = getSnapshot();
+        if (current && current->mapping)
+            publish();
+
+        std::lock_guard<std::mutex> lock(publishMutex);
+        if (retiredSnapshot && retiredSnapshot->mapping)
+            retiredSnapshot.reset();
     }
 
-    void DenseNeuralNetwork::calcGradient(
-        const NTARS::DATA::TrainingData<std::vector<float>> &data,
-        std::vector<TMATH::Matrix_t<float>>& localWGradient,
-        std::vector<TMATH::Matrix_t<float>>& localBGradient,
-        int32_t &numCorrect,
-        int32_t &numWrong)
+    void DenseNeuralNetwork::save()
     {
-        ForwardResult fwdResult = run(data.data);
-        const std::vector<float> &expected = data.label;
+        std::filesystem::path outputPath = std::filesystem::current_path() / "networks";
 
-        int expectedLabel = std::distance(expected.begin(), std::find(expected.begin(), expected.end(), 1));
+        if (!std::filesystem::exists(outputPath))
+        {
+            std::filesystem::create_directory(outputPath);
+        }
 
-        std::vector<TMATH::Matrix_t<float>> deltas;
-        deltas.reserve(_layers.size());
+        // POSIX keeps a replaced file alive for whoever still maps it, Windows refuses to replace a mapped file at
+        // all. This network's own mapping is dropped first, a snapshot a reader still holds can keep the rename
+        // failing there
+        releaseMapping();
 
-        for (const auto &layer : _layers)
+        FORMAT::ModelWriter writer;
+        for (uint32_t l = 0; l < _layers.size(); ++l)
         {
-            deltas.emplace_back(TMATH::Matrix_t<float>(layer.getNumOutputs(), 1));
+            writer.addTensor(FORMAT::TensorKind_Weights, l, 0, _structure[l + 1], _structure[l], weightViews[l]);
+            writer.addTensor(FORMAT::TensorKind_Biases, l, 0, _structure[l + 1], 1, biasViews[l]);
         }
 
-        TMATH::Matrix_t<float> outputDelta(fwdResult.output.size(), 1);
-        for (size_t i = 0; i < fwdResult.output.size(); ++i)
-            outputDelta.at(i, 0) = expected[i] - fwdResult.output[i];
+        // written next to the target and swapped in, so a failed save leaves the old file as it was
+        std::filesystem::path filePath = outputPath / std::string(name + ".tars");
+        std::filesystem::path tempPath = outputPath / std::string(name + ".tars.tmp");
 
-        deltas.back() = outputDelta;
+        std::error_code error;
+        if (!writer.write(tempPath, _structure, name, flags))
+        {
+            std::filesystem::remove(tempPath, error);
+            std::cerr << "Could not open file for writing: " << tempPath << std::endl;
+            return;
+        }
 
-        for (int64_t l = _layers.size() - 1; l >= 0; --l)
+        std::filesystem::rename(tempPath, filePath, error);
+        if (error)
         {
-            if (l != 0)
-            {
-                auto errorTerm = deltas[l].transpose() * weights[l];
-                auto deriv = (flags & NeuralNetworkFlags_ReLU || flags & NeuralNetworkFlags_ReLU_Internal) 
-                    ? TMATH::relu_derivative_matrix(fwdResult.activations[l - 1]) : TMATH::sigmoid_derivative_matrix(fwdResult.activations[l - 1]);
+            std::filesystem::remove(tempPath, error);
+            std::cerr << "Could not replace " << filePath << ", it may still be mapped by another network" << std::endl;
+            return;
+        }
 
-                deltas[l - 1] = deriv.elementWiseMultiplication(errorTerm.transpose());
-            }
+        std::cout << "Network saved successfully: " << filePath << std::endl;
+    }
+
+    void DenseNeuralNetwork::checkpoint(Checkpointer& checkpointer, const TrainingProgress& progress) const
+    {
+        CheckpointSnapshot& snapshot = checkpointer.beginSnapshot();
+
+        snapshot.structure = _structure;
+        snapshot.name = name;
+        snapshot.flags = flags;
+        snapshot.record.optimizerType = optimizer->getType();
+        snapshot.record.optimizerStep = optimizer->getStep();
+        snapshot.record.progress = progress;
 
-            auto prevActivations = (l == 0)
-                                       ? TMATH::Matrix_t<float>(data.data, data.data.size(), 1)
-                                       : TMATH::Matrix_t<float>(fwdResult.activations[l - 1], fwdResult.activations[l - 1].size(), 1);
+        for (uint32_t l = 0; l < _layers.size(); ++l)
+        {
+            snapshot.addTensor(FORMAT::TensorKind_Weights, l, 0, _structure[l + 1], _structure[l], weightViews[l]);
+            snapshot.addTensor(FORMAT::TensorKind_Biases, l, 0, _structure[l + 1], 1, biasViews[l]);
 
-            localWGradient[l] += deltas[l] * prevActivations.transpose();
-            localBGradient[l] += deltas[l];                          
+            for (uint32_t s = 0; s < weightOptimizerState[l].size(); ++s)
+            {
+                snapshot.addTensor(FORMAT::TensorKind_WeightOptimizerState, l, s, _structure[l + 1], _structure[l], weightOptimizerState[l][s].data());
+                snapshot.addTensor(FORMAT::TensorKind_BiasOptimizerState, l, s, _structure[l + 1], 1, biasOptimizerState[l][s].data());
+            }
         }
 
-        (getMostActive(fwdResult.output) == expectedLabel) ? ++numCorrect : ++numWrong;
+        // a resumed run draws the same dropout masks and scales the loss the same way as one that never stopped
+        CheckpointStepState stepState{};
+        stepState.lossScale = lossScale;
+        stepState.dynamicLossScale = dynamicLossScale;
+        stepState.cleanSteps = cleanSteps;
+        stepState.skippedSteps = skippedSteps;
+        stepState.dropoutSeed = dropoutSeed;
+        stepState.numDropoutStreams = dropoutStreams.size();
+
+        std::vector<uint64_t> stepBytes((sizeof(stepState) + dropoutStreams.size() * sizeof(uint64_t)) / sizeof(uint64_t));
+        std::memcpy(stepBytes.data(), &stepState, sizeof(stepState));
+        for (size_t t = 0; t < dropoutStreams.size(); ++t)
+            stepBytes[sizeof(stepState) / sizeof(uint64_t) + t] = dropoutStreams[t].getPosition();
+        snapshot.addBlob(FORMAT::TensorKind_TrainingState, 1, stepBytes.data(), stepBytes.size() * sizeof(uint64_t));
+
+        checkpointer.commit();
     }
 
-    float DenseNeuralNetwork::trainCPU(std::vector<NTARS::DATA::TrainingData<std::vector<float>>> &miniBatch, float learningRate)
+    bool DenseNeuralNetwork::resume(const std::filesystem::path& file, TrainingProgress& progress)
     {
-        int32_t numCorrect = 0;
-        int32_t numWrong = 0;
+        FORMAT::ModelReader reader;
 
-        for (size_t l = 0; l < _layers.size(); ++l)
+        // a checkpoint is only trusted whole
+        if (!reader.open(file, true))
         {
-            weightGradients[l] = TMATH::Matrix_t<float>(weights[l].rows(), weights[l].cols());
-            biasGradients[l] = TMATH::Matrix_t<float>(biases[l].rows(), 1);
+            std::cerr << reader.getError() << std::endl;
+            return false;
         }
 
-        const size_t numThreads = std::thread::hardware_concurrency();
-        const size_t chunkSize = miniBatch.size() / numThreads;
-
-        std::vector<std::future<std::tuple<
-            std::vector<TMATH::Matrix_t<float>>, // weight grads
-            std::vector<TMATH::Matrix_t<float>>, // bias grads
-            int32_t, int32_t                     // correct/wrong
-        >>> futures;
+        if (reader.getStructure() != _structure || reader.getHeader().flags != static_cast<uint32_t>(flags))
+        {
+            std::cerr << "Checkpoint was taken from a different network: " << file.string() << std::endl;
+            return false;
+        }
 
-        for (size_t t = 0; t < numThreads; ++t)
+        const FORMAT::TensorEntry* recordEntry = reader.findTensor(FORMAT::TensorKind_TrainingState, 0);
+        if (!recordEntry || recordEntry->cols * sizeof(float) != sizeof(CheckpointRecord))
         {
-            futures.emplace_back(std::async(std::launch::async, [&, t]()
-            {
-                size_t start = t * chunkSize;
-                size_t end = (t == numThreads - 1) ? miniBatch.size() : (t + 1) * chunkSize;
+            std::cerr << "Checkpoint has no training state: " << file.string() << std::endl;
+            return false;
+        }
 
-                std::vector<TMATH::Matrix_t<float>> localWGrads, localBGrads;
-                for (size_t l = 0; l < _layers.size(); ++l) {
-                    localWGrads.emplace_back(weights[l].rows(), weights[l].cols());
-                    localBGrads.emplace_back(biases[l].rows(), 1);
-                }
+        CheckpointRecord record;
+        std::memcpy(&record, reader.blobData(*recordEntry), sizeof(record));
 
-                int32_t localCorrect = 0, localWrong = 0;
+        // checkpoints from before the step state was saved leave loss scaling and dropout as they are
+        const FORMAT::TensorEntry* stepEntry = reader.findTensor(FORMAT::TensorKind_TrainingState, 1);
+        CheckpointStepState stepState{};
+        std::vector<uint64_t> streamPositions;
+        if (stepEntry)
+        {
+            const size_t stepBytes = stepEntry->cols * sizeof(float);
+            if (stepBytes >= sizeof(stepState))
+                std::memcpy(&stepState, reader.blobData(*stepEntry), sizeof(stepState));
 
-                for (size_t i = start; i < end; ++i)
-                    calcGradient(miniBatch[i], localWGrads, localBGrads, localCorrect, localWrong);
+            if (stepBytes < sizeof(stepState) || stepState.numDropoutStreams != (stepBytes - sizeof(stepState)) / sizeof(uint64_t))
+            {
+                std::cerr << "Checkpoint has a damaged training step state: " << file.string() << std::endl;
+                return false;
+            }
 
-                return std::make_tuple(localWGrads, localBGrads, localCorrect, localWrong); 
-            }));
+            streamPositions.resize(stepState.numDropoutStreams);
+            std::memcpy(streamPositions.data(), reader.blobData(*stepEntry) + sizeof(stepState), streamPositions.size() * sizeof(uint64_t));
         }
 
-        for (auto& fut : futures) {
-            auto [localWGrads, localBGrads, correct, wrong] = fut.get();
-            numCorrect += correct;
-            numWrong += wrong;
+        std::unique_ptr<Optimizer> restored = optimizer->getType() == record.optimizerType
+            ? nullptr : createOptimizer(static_cast<OptimizerType_>(record.optimizerType));
+        const size_t stateCount = restored ? restored->getStateCount() : optimizer->getStateCount();
+
+        // validate everything before touching the network, so a bad file leaves it as it was
+        for (uint32_t l = 0; l < _layers.size(); ++l)
+        {
+            if (!reader.findTensor(FORMAT::TensorKind_Weights, l) || !reader.findTensor(FORMAT::TensorKind_Biases, l))
+            {
+                std::cerr << "Checkpoint is missing parameters for layer " << l << ": " << file.string() << std::endl;
+                return false;
+            }
 
-            for (size_t l = 0; l < _layers.size(); ++l) {
-                weightGradients[l] += localWGrads[l];
-                biasGradients[l] += localBGrads[l];
+            for (uint32_t s = 0; s < stateCount; ++s)
+            {
+                if (!reader.findTensor(FORMAT::TensorKind_WeightOptimizerState, l, s) || !reader.findTensor(FORMAT::TensorKind_BiasOptimizerState, l, s))
+                {
+                    std::cerr << "Checkpoint is missing optimizer state for layer " << l << ": " << file.string() << std::endl;
+                    return false;
+                }
             }
         }
 
+        materialize();
+        if (restored)
+            setOptimizer(std::move(restored));
+
+        for (uint32_t l = 0; l < _layers.size(); ++l)
+        {
+            const float* weightData = reader.tensorData(*reader.findTensor(FORMAT::TensorKind_Weights, l));
+            const float* biasData = reader.tensorData(*reader.findTensor(FORMAT::TensorKind_Biases, l));
+            std::copy(weightData, weightData + weights[l].size(), weights[l].data());
+            std::copy(biasData, biasData + biases[l].size(), biases[l].data());
+
+            for (uint32_t s = 0; s < stateCount; ++s)
+            {
+                const float* weightState = reader.tensorData(*reader.findTensor(FORMAT::TensorKind_WeightOptimizerState, l, s));
+                const float* biasState = reader.tensorData(*reader.findTensor(FORMAT::TensorKind_BiasOptimizerState, l, s));
+                std::copy(weightState, weightState + weightOptimizerState[l][s].size(), weightOptimizerState[l][s].data());
+                std::copy(biasState, biasState + biasOptimizerState[l][s].size(), biasOptimizerState[l][s].data());
+            }
+        }
+
+        optimizer->setStep(record.optimizerStep);
+        progress = record.progress;
+
+        if (stepEntry)
+        {
+            lossScale = stepState.lossScale;
+            dynamicLossScale = stepState.dynamicLossScale != 0;
+            cleanSteps = stepState.cleanSteps;
+            skippedSteps = stepState.skippedSteps;
+
+            dropoutSeed = stepState.dropoutSeed;
+            dropoutStreams.clear();
+            for (size_t t = 0; t < streamPositions.size(); ++t)
+            {
+                dropoutStreams.emplace_back(dropoutSeed, t);
+                dropoutStreams.back().seek(streamPositions[t]);
+            }
+        }
+
+        publish();
+
+        std::cout << "Resumed from checkpoint: " << file.string() << " (epoch " << progress.epoch << ", batch " << progress.batch << ")" << std::endl;
+        return true;
+    }
+
+    void DenseNeuralNetwork::saveJSON()
+    {
+        materialize();
+
+        nlohmann::json saved;
+
+        saved["structure"] = _structure;
+        saved["name"] = name;
+        saved["flags"] = flags;
+
+        for (const auto &weightMatrix : weights)
+        {
+            nlohmann::json weightJson;
+            weightJson["data"] = weightMatrix.getElementsRaw();
+            weightJson["rows"] = weightMatrix.rows();
+            weightJson["cols"] = weightMatrix.cols();
+            saved["weights"].push_back(weightJson);
+        }
+
+        for (auto &biasMatrix : biases)
+        {
+            saved["biases"].push_back(biasMatrix.getElementsRaw());
+        }
+
+        std::filesystem::path outputPath = std::filesystem::current_path() / "networks";
+
+        if (!std::filesystem::exists(outputPath))
+        {
+            std::filesystem::create_directory(outputPath);
+        }
+
+        std::ofstream outFile(outputPath / std::string(name + ".json"));
+
+        if (outFile.is_open())
+        {
+            outFile << saved.dump();
+            outFile.close();
+            std::cout << "Network saved successfully: " << outputPath << std::endl;
+        }
+        else
+        {
+            std::cerr << "Could not open file for writing: " << outputPath << std::endl;
+        }
+    }
+
+    void DenseNeuralNetwork::train(std::vector<NTARS::DATA::TrainingData<std::vector<float>>> &miniBatch, float learningRate)
+    {
+    }
+
+    void DenseNeuralNetwork::calcGradient(
+        const NTARS::DATA::TrainingData<std::vector<float>> *samples,
+        size_t count,
+        size_t thread,
+        int32_t &numCorrect,
+        int32_t &numWrong)
+    {
+        TrainingArena &arena = arenas[thread];
+        if (arena.getCheckpointInterval() != 0)
+            return calcGradientCheckpointed(samples, count, thread, numCorrect, numWrong);
+
+        const size_t numLayers = _layers.size();
+        const size_t numInputs = _structure.front();
+        const size_t numOutputs = _structure.back();
+        const auto forwardStart = std::chrono::steady_clock::now();
+
+        float *input = arena.input();
+        for (size_t s = 0; s < count; ++s)
+            std::copy(samples[s].data.begin(), samples[s].data.end(), input + s * numInputs);
+
+        drawDropoutMasks(thread, count);
+
+        const float *currentInputs = input;
+        for (size_t l = 0; l < numLayers; ++l)
+        {
+            _layers[l].forwardBatch(currentInputs, weights[l].data(), biases[l].data(), arena.preActivations(l), arena.activations(l), count,
+                dropoutMask(thread, l), dropoutScale(l));
+            currentInputs = arena.activations(l);
+        }
+
+        const float *output = arena.activations(numLayers - 1);
+        float *outputDelta = arena.deltas(numLayers - 1);
+        for (size_t s = 0; s < count; ++s)
+        {
+            const std::vector<float> &expected = samples[s].label;
+            const float *sampleOutput = output + s * numOutputs;
+
+            for (size_t i = 0; i < numOutputs; ++i)
+                outputDelta[s * numOutputs + i] = expected[i] - sampleOutput[i];
+
+            const size_t expectedLabel = std::distance(expected.begin(), std::find(expected.begin(), expected.end(), 1));
+            const size_t guess = std::distance(sampleOutput, std::max_element(sampleOutput, sampleOutput + numOutputs));
+            (guess == expectedLabel) ? ++numCorrect : ++numWrong;
+        }
+
+        const auto backwardStart = std::chrono::steady_clock::now();
+        threadPhaseMs[thread][0] += std::chrono::duration<double, std::milli>(backwardStart - forwardStart).count();
+
+        for (int64_t l = numLayers - 1; l >= 0; --l)
+        {
+            const float *prevActivations = (l == 0) ? input : arena.activations(l - 1);
+            const float *prevPre = (l == 0) ? nullptr : arena.preActivations(l - 1);
+            float *prevDelta = (l == 0) ? nullptr : arena.deltas(l - 1);
+            const uint32_t *prevMask = (l == 0) ? nullptr : dropoutMask(thread, l - 1);
+            backpropagateLayer(l, arena.deltas(l), prevActivations, prevPre, prevDelta, count, thread, prevMask);
+        }
+
+        threadPhaseMs[thread][1] += elapsedMs(backwardStart);
+    }
+
+    void DenseNeuralNetwork::calcGradientCheckpointed(
+        const NTARS::DATA::TrainingData<std::vector<float>> *samples,
+        size_t count,
+        size_t thread,
+        int32_t &numCorrect,
+        int32_t &numWrong)
+    {
+        TrainingArena &arena = arenas[thread];
+
+        const size_t numLayers = _layers.size();
+        const size_t numInputs = _structure.front();
+        const size_t numOutputs = _structure.back();
+        const size_t interval = arena.getCheckpointInterval();
+        const size_t numSegments = (numLayers + interval - 1) / interval;
+        const auto forwardStart = std::chrono::steady_clock::now();
+
+        float *input = arena.input();
+        for (size_t s = 0; s < count; ++s)
+            std::copy(samples[s].data.begin(), samples[s].data.end(), input + s * numInputs);
+
+        auto layerInput = [&](size_t l) { return l == 0 ? input : arena.layerOutput(l - 1); };
+
+        // the full forward pass leaves the checkpoints and the whole last segment behind, recomputed layers reuse its masks
+        drawDropoutMasks(thread, count);
+        for (size_t l = 0; l < numLayers; ++l)
+        {
+            _layers[l].forwardBatch(layerInput(l), weights[l].data(), biases[l].data(), nullptr, arena.layerOutput(l), count,
+                dropoutMask(thread, l), dropoutScale(l));
+        }
+
+        const float *output = arena.layerOutput(numLayers - 1);
+        float *delta = arena.deltas(0);
+        float *prevDelta = arena.deltas(1);
+        for (size_t s = 0; s < count; ++s)
+        {
+            const std::vector<float> &expected = samples[s].label;
+            const float *sampleOutput = output + s * numOutputs;
+
+            for (size_t i = 0; i < numOutputs; ++i)
+                delta[s * numOutputs + i] = expected[i] - sampleOutput[i];
+
+            const size_t expectedLabel = std::distance(expected.begin(), std::find(expected.begin(), expected.end(), 1));
+            const size_t guess = std::distance(sampleOutput, std::max_element(sampleOutput, sampleOutput + numOutputs));
+            (guess == expectedLabel) ? ++numCorrect : ++numWrong;
+        }
+
+        threadPhaseMs[thread][0] += elapsedMs(forwardStart);
+
+        for (int64_t segment = numSegments - 1; segment >= 0; --segment)
+        {
+            const size_t segmentStart = segment * interval;
+            const size_t segmentEnd = std::min(numLayers, segmentStart + interval);
+
+            // refill the segment from the checkpoint before it, its own last output is a checkpoint already
+            if (segment != static_cast<int64_t>(numSegments) - 1)
+            {
+                const auto recomputeStart = std::chrono::steady_clock::now();
+                for (size_t l = segmentStart; l + 1 < segmentEnd; ++l)
+                {
+                    _layers[l].forwardBatch(layerInput(l), weights[l].data(), biases[l].data(), nullptr, arena.layerOutput(l), count,
+                        dropoutMask(thread, l), dropoutScale(l));
+                }
+                threadPhaseMs[thread][0] += elapsedMs(recomputeStart);
+            }
+
+            const auto backwardStart = std::chrono::steady_clock::now();
+            for (int64_t l = segmentEnd - 1; l >= static_cast<int64_t>(segmentStart); --l)
+            {
+                backpropagateLayer(l, delta, layerInput(l), nullptr, l == 0 ? nullptr : prevDelta, count, thread,
+                    l == 0 ? nullptr : dropoutMask(thread, l - 1));
+                std::swap(delta, prevDelta);
+            }
+            threadPhaseMs[thread][1] += elapsedMs(backwardStart);
+        }
+    }
+
+    void DenseNeuralNetwork::backpropagateLayer(size_t l, const float *delta, const float *prevActivations, const float *prevPre,
+        float *prevDelta, size_t count, size_t thread, const uint32_t *prevMask)
+    {
+        const size_t layerInputs = _layers[l].getNumInputs();
+        const size_t layerOutputs = _layers[l].getNumOutputs();
+
+        float *wGrad = threadWeightGradients[thread][l].data();
+        float *bGrad = threadBiasGradients[thread][l].data();
+        for (size_t o = 0; o < layerOutputs; ++o)
+        {
+            float *gradRow = wGrad + o * layerInputs;
+            for (size_t s = 0; s < count; ++s)
+            {
+                const float d = delta[s * layerOutputs + o];
+                TMATH::axpy(d, prevActivations + s * layerInputs, gradRow, layerInputs);
+                bGrad[o] += d;
+            }
+        }
+
+        if (l == 0)
+            return;
+
+        // propagate through the weights, then through the previous layer's activation function
+        const float *weightData = weights[l].data();
+        const bool relu = _layers[l - 1].usesReLU();
+
+        std::fill(prevDelta, prevDelta + count * layerInputs, 0.0f);
+        for (size_t s = 0; s < count; ++s)
+        {
+            float *sampleDelta = prevDelta + s * layerInputs;
+            for (size_t o = 0; o < layerOutputs; ++o)
+                TMATH::axpy(delta[s * layerOutputs + o], weightData + o * layerInputs, sampleDelta, layerInputs);
+
+            // a ReLU output is positive exactly when its pre-activation is
+            const float *sampleActivations = prevActivations + s * layerInputs;
+            const float *samplePre = prevPre ? prevPre + s * layerInputs : sampleActivations;
+            if (!prevMask)
+            {
+                for (size_t i = 0; i < layerInputs; ++i)
+                    sampleDelta[i] *= relu ? (samplePre[i] > 0.0f ? 1.0f : 0.0f) : sampleActivations[i] * (1.0f - sampleActivations[i]);
+                continue;
+            }
+
+            // dropped outputs pass nothing back, kept ones were scaled after the activation
+            const float scale = dropoutScale(l - 1);
+            const float keep = 1.0f / scale;
+            for (size_t i = 0; i < layerInputs; ++i)
+            {
+                if (!DropoutLayer::isKept(prevMask, s * layerInputs + i))
+                {
+                    sampleDelta[i] = 0.0f;
+                    continue;
+                }
+
+                const float activation = sampleActivations[i] * keep;
+                sampleDelta[i] *= scale * (relu ? (samplePre[i] > 0.0f ? 1.0f : 0.0f) : activation * (1.0f - activation));
+            }
+        }
+    }
+
+    void DenseNeuralNetwork::setThreadCount(size_t numThreads)
+    {
+        threadPool = std::make_unique<ThreadPool>(numThreads);
+        arenas.clear();
+        threadWeightGradients.clear();
+        threadBiasGradients.clear();
+    }
+
+    void DenseNeuralNetwork::prepareThreadBuffers(size_t numThreads, size_t batchSize)
+    {
+        if (arenas.size() < numThreads)
+            arenas.resize(numThreads);
+
+        if (threadResults.size() < numThreads)
+            threadResults.resize(numThreads);
+
+        if (threadPhaseMs.size() < numThreads)
+            threadPhaseMs.resize(numThreads);
+
+        for (auto &arena : arenas)
+            arena.plan(_structure, batchSize, checkpointInterval);
+
+        if (!dropouts.empty())
+        {
+            // sized for the planned batch, no chunk of a step is larger
+            size_t maskWords = 0;
+            dropoutMaskOffsets.clear();
+            for (const DropoutLayer &dropout : dropouts)
+            {
+                dropoutMaskOffsets.push_back(maskWords);
+                if (dropout.isActive())
+                    maskWords += dropout.getMaskWords(batchSize);
+            }
+
+            if (dropoutMasks.size() < numThreads)
+                dropoutMasks.resize(numThreads);
+            for (auto &masks : dropoutMasks)
+                masks.resize(maskWords);
+
+            while (dropoutStreams.size() < numThreads)
+                dropoutStreams.emplace_back(dropoutSeed, dropoutStreams.size());
+        }
+
+        while (threadWeightGradients.size() < numThreads)
+        {
+            std::vector<TMATH::Matrix_t<float>> localWGrads, localBGrads;
+            for (size_t l = 0; l < _layers.size(); ++l)
+            {
+                localWGrads.emplace_back(_structure[l + 1], _structure[l]);
+                localBGrads.emplace_back(_structure[l + 1], 1);
+            }
+
+            threadWeightGradients.push_back(std::move(localWGrads));
+            threadBiasGradients.push_back(std::move(localBGrads));
+        }
+    }
+
+    template<typename F>
+    void DenseNeuralNetwork::timedParallelFor(size_t count, F &&fn)
+    {
+        if (!telemetry.isEnabled())
+        {
+            threadPool->parallelFor(count, fn);
+            return;
+        }
+
+        if (taskFinishMs.size() < count)
+        {
+            taskFinishMs.resize(count);
+            taskAllocations.resize(count);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const std::thread::id caller = std::this_thread::get_id();
+        threadPool->parallelFor(count, [&](size_t t)
+        {
+            const uint64_t allocations = getThreadAllocationCount();
+            fn(t);
+            taskFinishMs[t] = elapsedMs(start);
+
+            // the calling thread's allocations are counted once for the whole step
+            taskAllocations[t] = std::this_thread::get_id() == caller ? 0 : getThreadAllocationCount() - allocations;
+        });
+
+        const double wallMs = elapsedMs(start);
+        if (currentStep.threadIdleMs.size() < count)
+            currentStep.threadIdleMs.resize(count, 0.0);
+
+        for (size_t t = 0; t < count; ++t)
+        {
+            currentStep.threadIdleMs[t] += wallMs - taskFinishMs[t];
+            currentStep.allocations += taskAllocations[t];
+        }
+    }
+
+    size_t DenseNeuralNetwork::getTrainingMemoryBytes() const
+    {
+        size_t bytes = mixedArena.getBytes();
+        for (const auto &arena : arenas)
+            bytes += arena.getBytes();
+
+        for (size_t t = 0; t < threadWeightGradients.size(); ++t)
+        {
+            for (size_t l = 0; l < threadWeightGradients[t].size(); ++l)
+                bytes += (threadWeightGradients[t][l].size() + threadBiasGradients[t][l].size()) * sizeof(float);
+        }
+
+        for (const auto &masks : dropoutMasks)
+            bytes += masks.size() * sizeof(uint32_t);
+
+        return bytes;
+    }
+
+    std::vector<LayerProfile> DenseNeuralNetwork::profile(size_t iterations, size_t batchSize)
+    {
+        materialize();
+
+        iterations = std::max<size_t>(1, iterations);
+        batchSize = std::max<size_t>(1, batchSize);
+
+        // thread 0's arena and gradients, planned without checkpointing so every layer keeps its buffers
+        prepareThreadBuffers(1, batchSize);
+        TrainingArena &arena = arenas[0];
+        arena.plan(_structure, batchSize);
+
+        Random random{1234};
+        random.fillUniform(arena.input(), batchSize * _structure.front());
+
+        const float *currentInputs = arena.input();
+        for (size_t l = 0; l < _layers.size(); ++l)
+        {
+            _layers[l].forwardBatch(currentInputs, weights[l].data(), biases[l].data(), arena.preActivations(l), arena.activations(l), batchSize);
+            currentInputs = arena.activations(l);
+
+            float *delta = arena.deltas(l);
+            random.fillUniform(delta, batchSize * _structure[l + 1], -0.5f, 0.5f);
+        }
+
+        std::vector<LayerProfile> profiles;
+        for (size_t l = 0; l < _layers.size(); ++l)
+        {
+            const double n = static_cast<double>(_structure[l]);
+            const double m = static_cast<double>(_structure[l + 1]);
+            const double b = static_cast<double>(batchSize);
+            const double word = sizeof(float);
+
+            LayerProfile layer{};
+            layer.layer = l;
+            layer.inputs = _structure[l];
+            layer.outputs = _structure[l + 1];
+
+            // W x + b and the activation; weights, biases and inputs in, pre-activations and activations out
+            layer.forwardFlops = 2.0 * n * m * b + 2.0 * m * b;
+            layer.forwardBytes = word * (n * m + m + b * n + 2.0 * b * m);
+
+            // the weight and bias gradient, then W^T delta and the activation derivative below the first layer;
+            // gradients are read and written, deltas and activations read, the lower delta written
+            layer.backwardFlops = 2.0 * n * m * b + m * b;
+            layer.backwardBytes = word * (2.0 * (n * m + m) + b * m + b * n);
+            if (l > 0)
+            {
+                layer.backwardFlops += 2.0 * n * m * b + 3.0 * n * b;
+                layer.backwardBytes += word * (n * m + 2.0 * b * n);
+            }
+
+            const float *layerInputs = l == 0 ? arena.input() : arena.activations(l - 1);
+            const float *prevPre = l == 0 ? nullptr : arena.preActivations(l - 1);
+
+            // the lower delta goes to scratch so the next layer down still profiles on the original deltas
+            std::vector<float> prevDelta(l == 0 ? 0 : batchSize * _structure[l]);
+
+            // one untimed pass warms the caches
+            _layers[l].forwardBatch(layerInputs, weights[l].data(), biases[l].data(), arena.preActivations(l), arena.activations(l), batchSize);
+            const auto forwardStart = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < iterations; ++i)
+                _layers[l].forwardBatch(layerInputs, weights[l].data(), biases[l].data(), arena.preActivations(l), arena.activations(l), batchSize);
+            layer.forwardMs = elapsedMs(forwardStart) / iterations;
+
+            backpropagateLayer(l, arena.deltas(l), layerInputs, prevPre, l == 0 ? nullptr : prevDelta.data(), batchSize, 0);
+            const auto backwardStart = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < iterations; ++i)
+                backpropagateLayer(l, arena.deltas(l), layerInputs, prevPre, l == 0 ? nullptr : prevDelta.data(), batchSize, 0);
+            layer.backwardMs = elapsedMs(backwardStart) / iterations;
+
+            layer.forwardGFlops = layer.forwardMs > 0.0 ? layer.forwardFlops / (layer.forwardMs * 1e6) : 0.0;
+            layer.backwardGFlops = layer.backwardMs > 0.0 ? layer.backwardFlops / (layer.backwardMs * 1e6) : 0.0;
+            layer.forwardIntensity = layer.forwardFlops / layer.forwardBytes;
+            layer.backwardIntensity = layer.backwardFlops / layer.backwardBytes;
+
+            profiles.push_back(layer);
+        }
+
+        // the runs summed into thread 0's gradients, which every training step zeroes before use
+        return profiles;
+    }
+
+    void DenseNeuralNetwork::setGradientCheckpointing(size_t interval)
+    {
+        checkpointInterval = interval < 2 ? 0 : interval;
+    }
+
+    ActivationMemoryReport DenseNeuralNetwork::getActivationMemoryReport(size_t interval, size_t batchSize) const
+    {
+        const size_t numLayers = _layers.size();
+
+        ActivationMemoryReport report{};
+        report.checkpointInterval = interval < 2 ? 0 : interval;
+        report.batchSize = batchSize;
+        report.bytes = TrainingArena::requiredBytes(_structure, batchSize, report.checkpointInterval);
+        report.fullBytes = TrainingArena::requiredBytes(_structure, batchSize);
+
+        if (report.checkpointInterval == 0)
+        {
+            report.storedLayers = numLayers;
+            return report;
+        }
+
+        // every segment but the last keeps one output and recomputes the rest
+        const size_t numSegments = (numLayers + report.checkpointInterval - 1) / report.checkpointInterval;
+        const size_t lastSegment = numLayers - (numSegments - 1) * report.checkpointInterval;
+        report.storedLayers = (numSegments - 1) + lastSegment;
+        report.recomputedLayers = (numSegments - 1) * (report.checkpointInterval - 1);
+        return report;
+    }
+
+    void DenseNeuralNetwork::setTrainingPrecision(TrainingPrecision_ newPrecision)
+    {
+        if (newPrecision == precision)
+            return;
+
+        precision = newPrecision;
+        if (precision == TrainingPrecision_BF16)
+        {
+            arenas.clear();
+            threadWeightGradients.clear();
+            threadBiasGradients.clear();
+        }
+        else
+        {
+            mixedArena = MixedPrecisionArena{};
+        }
+    }
+
+    void DenseNeuralNetwork::setLossScaling(float initialScale, bool dynamic)
+    {
+        lossScale = initialScale > 0.0f ? initialScale : 1.0f;
+        dynamicLossScale = dynamic;
+        cleanSteps = 0;
+    }
+
+    float DenseNeuralNetwork::trainCPU(std::span<const NTARS::DATA::TrainingData<std::vector<float>>> miniBatch, float learningRate)
+    {
+        // an empty shard still has to take part in the all-reduce
+        if (miniBatch.empty() && !collective)
+            return 0.0f;
+
+        const auto stepStart = std::chrono::steady_clock::now();
+        const uint64_t stepAllocations = getThreadAllocationCount();
+        currentStep.forwardMs = currentStep.backwardMs = currentStep.reduceMs = currentStep.updateMs = 0.0;
+        currentStep.allocations = 0;
+        std::fill(currentStep.threadIdleMs.begin(), currentStep.threadIdleMs.end(), 0.0);
+
+        materialize();
+
+        int32_t numCorrect = 0;
+        int32_t numWrong = 0;
+        const bool mixed = precision == TrainingPrecision_BF16;
+        const float stepScale = mixed ? lossScale : 1.0f;
+        if (mixed)
+            accumulateGradientsBF16(miniBatch, numCorrect, numWrong);
+        else
+            accumulateGradients(miniBatch, numCorrect, numWrong);
+
         float batchSize = static_cast<float>(miniBatch.size());
-        for (int64_t l = _layers.size() - 1; l >= 0; --l)
+        if (collective)
+        {
+            const auto reduceStart = std::chrono::steady_clock::now();
+            const bool reduced = reduceAcrossRanks(numCorrect, numWrong, batchSize);
+            currentStep.reduceMs += elapsedMs(reduceStart);
+
+            if (!reduced)
+                return 0.0f;
+        }
+
+        if (batchSize == 0.0f)
+            return 0.0f;
+
+        const float accuracy = static_cast<float>(numCorrect) / (numCorrect + numWrong);
+
+        // the check runs on the reduced gradients, so every rank skips and rescales together
+        bool update = true;
+        if (mixed && dynamicLossScale)
+        {
+            if (!gradientsFinite())
+            {
+                lossScale *= 0.5f;
+                cleanSteps = 0;
+                ++skippedSteps;
+                update = false;
+            }
+            else if (++cleanSteps == lossScaleGrowthInterval)
+            {
+                lossScale *= 2.0f;
+                cleanSteps = 0;
+            }
+        }
+
+        if (update)
+        {
+            const auto updateStart = std::chrono::steady_clock::now();
+            applyOptimizer(learningRate, batchSize * stepScale);
+            publish();
+            currentStep.updateMs = elapsedMs(updateStart);
+        }
+
+        if (telemetry.isEnabled())
+        {
+            currentStep.samples = miniBatch.size();
+            currentStep.totalMs = elapsedMs(stepStart);
+            currentStep.samplesPerSecond = currentStep.totalMs > 0.0 ? currentStep.samples * 1000.0 / currentStep.totalMs : 0.0;
+            currentStep.allocations += getThreadAllocationCount() - stepAllocations;
+            telemetry.record(currentStep);
+        }
+
+        return accuracy;
+    }
+
+    void DenseNeuralNetwork::accumulateGradients(std::span<const NTARS::DATA::TrainingData<std::vector<float>>> miniBatch, int32_t &numCorrect, int32_t &numWrong)
+    {
+        if (miniBatch.empty())
+        {
+            for (size_t l = 0; l < _layers.size(); ++l)
+            {
+                weightGradients[l].zero();
+                biasGradients[l].zero();
+            }
+
+            return;
+        }
+
+        if (!threadPool)
+            threadPool = std::make_unique<ThreadPool>();
+
+        const size_t numThreads = std::min(threadPool->size(), miniBatch.size());
+        const size_t chunkSize = miniBatch.size() / numThreads;
+        const size_t arenaBatch = std::min(maxArenaBatch, chunkSize + miniBatch.size() % numThreads);
+
+        prepareThreadBuffers(numThreads, arenaBatch);
+
+        timedParallelFor(numThreads, [&](size_t t)
+        {
+            threadPhaseMs[t] = {0.0, 0.0};
+            for (size_t l = 0; l < _layers.size(); ++l)
+            {
+                threadWeightGradients[t][l].zero();
+                threadBiasGradients[t][l].zero();
+            }
+
+            size_t start = t * chunkSize;
+            size_t end = (t == numThreads - 1) ? miniBatch.size() : (t + 1) * chunkSize;
+
+            int32_t localCorrect = 0, localWrong = 0;
+            for (size_t i = start; i < end; i += arenaBatch)
+                calcGradient(miniBatch.data() + i, std::min(arenaBatch, end - i), t, localCorrect, localWrong);
+
+            threadResults[t] = {localCorrect, localWrong};
+        });
+
+        for (size_t t = 0; t < numThreads; ++t)
+        {
+            currentStep.forwardMs += threadPhaseMs[t][0] / numThreads;
+            currentStep.backwardMs += threadPhaseMs[t][1] / numThreads;
+        }
+
+        // every thread reduces its own slice of rows across all per-thread gradients
+        const auto reduceStart = std::chrono::steady_clock::now();
+        timedParallelFor(numThreads, [&](size_t t)
+        {
+            for (size_t l = 0; l < _layers.size(); ++l)
+            {
+                const size_t rows = weights[l].rows();
+                const size_t cols = weights[l].cols();
+                const size_t rowStart = rows * t / numThreads;
+                const size_t rowEnd = rows * (t + 1) / numThreads;
+
+                float *wDst = weightGradients[l].data() + rowStart * cols;
+                float *bDst = biasGradients[l].data() + rowStart;
+                std::copy_n(threadWeightGradients[0][l].data() + rowStart * cols, (rowEnd - rowStart) * cols, wDst);
+                std::copy_n(threadBiasGradients[0][l].data() + rowStart, rowEnd - rowStart, bDst);
+
+                for (size_t src = 1; src < numThreads; ++src)
+                {
+                    TMATH::add(threadWeightGradients[src][l].data() + rowStart * cols, wDst, (rowEnd - rowStart) * cols);
+                    TMATH::add(threadBiasGradients[src][l].data() + rowStart, bDst, rowEnd - rowStart);
+                }
+            }
+        });
+        currentStep.reduceMs += elapsedMs(reduceStart);
+
+        for (size_t t = 0; t < numThreads; ++t)
+        {
+            numCorrect += threadResults[t][0];
+            numWrong += threadResults[t][1];
+        }
+    }
+
+    // y += sum of coefficients[k * stride] * rows[k], four rows at a time and skipping zero coefficients
+    // (inactive ReLUs). Returns the sum of the coefficients
+    static float accumulateRowsBF16(const TMATH::bf16_t *coefficients, size_t stride, const TMATH::bf16_t *rows, size_t width, size_t count, float *y)
+    {
+        float total = 0.0f;
+        float pending[4];
+        const TMATH::bf16_t *pendingRows[4];
+        size_t numPending = 0;
+
+        for (size_t k = 0; k < count; ++k)
+        {
+            const float c = TMATH::fromBF16(coefficients[k * stride]);
+            if (c == 0.0f)
+                continue;
+
+            total += c;
+            pending[numPending] = c;
+            pendingRows[numPending] = rows + k * width;
+            if (++numPending == 4)
+            {
+                TMATH::axpy4(pending, pendingRows, y, width);
+                numPending = 0;
+            }
+        }
+
+        for (size_t k = 0; k < numPending; ++k)
+            TMATH::axpy(pending[k], pendingRows[k], y, width);
+
+        return total;
+    }
+
+    void DenseNeuralNetwork::calcDeltasBF16(
+        const NTARS::DATA::TrainingData<std::vector<float>> *samples,
+        size_t first,
+        size_t count,
+        size_t thread,
+        int32_t &numCorrect,
+        int32_t &numWrong)
+    {
+        const size_t numLayers = _layers.size();
+        const size_t numInputs = _structure.front();
+        const size_t numOutputs = _structure.back();
+        const auto forwardStart = std::chrono::steady_clock::now();
+
+        for (size_t s = 0; s < count; ++s)
+            TMATH::toBF16(samples[s].data.data(), mixedArena.activations(0) + (first + s) * numInputs, numInputs);
+
+        // FP32 results of one layer, rounded once they are complete
+        float *outputs = mixedArena.preActivations(thread);
+        for (size_t l = 0; l < numLayers; ++l)
+        {
+            const size_t layerInputs = _structure[l];
+            const size_t layerOutputs = _structure[l + 1];
+
+            const TMATH::bf16_t *inputs = mixedArena.activations(l) + first * layerInputs;
+            const TMATH::bf16_t *weightData = mixedArena.weights(l);
+            const float *biasData = biases[l].data();
+            const bool relu = _layers[l].usesReLU();
+
+            for (size_t i = 0; i < layerOutputs; ++i)
+            {
+                const TMATH::bf16_t *weightRow = weightData + i * layerInputs;
+
+                // four samples share every widened weight chunk
+                size_t s = 0;
+                for (; s + 4 <= count; s += 4)
+                {
+                    const TMATH::bf16_t *rows[4] = {inputs + s * layerInputs, inputs + (s + 1) * layerInputs,
+                        inputs + (s + 2) * layerInputs, inputs + (s + 3) * layerInputs};
+                    float sums[4];
+                    TMATH::dot4(rows, weightRow, layerInputs, sums);
+
+                    for (size_t j = 0; j < 4; ++j)
+                    {
+                        const float sum = sums[j] + biasData[i];
+                        outputs[(s + j) * layerOutputs + i] = relu ? TMATH::relu(sum) : TMATH::sigmoid(sum);
+                    }
+                }
+
+                for (; s < count; ++s)
+                {
+                    const float sum = TMATH::dot(inputs + s * layerInputs, weightRow, layerInputs) + biasData[i];
+                    outputs[s * layerOutputs + i] = relu ? TMATH::relu(sum) : TMATH::sigmoid(sum);
+                }
+            }
+
+            TMATH::toBF16(outputs, mixedArena.activations(l + 1) + first * layerOutputs, count * layerOutputs);
+        }
+
+        // the output error comes from the FP32 outputs, it only gets rounded after scaling
+        TMATH::bf16_t *outputDelta = mixedArena.deltas(numLayers - 1) + first * numOutputs;
+        for (size_t s = 0; s < count; ++s)
+        {
+            const std::vector<float> &expected = samples[s].label;
+            const float *sampleOutput = outputs + s * numOutputs;
+
+            for (size_t i = 0; i < numOutputs; ++i)
+                outputDelta[s * numOutputs + i] = TMATH::toBF16((expected[i] - sampleOutput[i]) * lossScale);
+
+            const size_t expectedLabel = std::distance(expected.begin(), std::find(expected.begin(), expected.end(), 1));
+            const size_t guess = std::distance(sampleOutput, std::max_element(sampleOutput, sampleOutput + numOutputs));
+            (guess == expectedLabel) ? ++numCorrect : ++numWrong;
+        }
+
+        const auto backwardStart = std::chrono::steady_clock::now();
+        threadPhaseMs[thread][0] += std::chrono::duration<double, std::milli>(backwardStart - forwardStart).count();
+
+        float *deltaRow = mixedArena.deltaRow(thread);
+        for (size_t l = numLayers - 1; l > 0; --l)
+        {
+            const size_t layerInputs = _structure[l];
+            const size_t layerOutputs = _structure[l + 1];
+
+            const TMATH::bf16_t *delta = mixedArena.deltas(l) + first * layerOutputs;
+            const TMATH::bf16_t *weightData = mixedArena.weights(l);
+            const TMATH::bf16_t *prevActivations = mixedArena.activations(l) + first * layerInputs;
+            TMATH::bf16_t *prevDelta = mixedArena.deltas(l - 1) + first * layerInputs;
+            const bool relu = _layers[l - 1].usesReLU();
+
+            for (size_t s = 0; s < count; ++s)
+            {
+                std::fill(deltaRow, deltaRow + layerInputs, 0.0f);
+                accumulateRowsBF16(delta + s * layerOutputs, 1, weightData, layerInputs, layerOutputs, deltaRow);
+
+                // a ReLU output is positive exactly when its pre-activation was, so no pre-activations are kept
+                const TMATH::bf16_t *sampleActivations = prevActivations + s * layerInputs;
+                for (size_t i = 0; i < layerInputs; ++i)
+                {
+                    const float a = TMATH::fromBF16(sampleActivations[i]);
+                    deltaRow[i] *= relu ? (a > 0.0f ? 1.0f : 0.0f) : a * (1.0f - a);
+                }
+
+                TMATH::toBF16(deltaRow, prevDelta + s * layerInputs, layerInputs);
+            }
+        }
+
+        threadPhaseMs[thread][1] += elapsedMs(backwardStart);
+    }
+
+    void DenseNeuralNetwork::calcWeightGradientsBF16(size_t batchSize, size_t slice, size_t numSlices)
+    {
+        // samples are walked in blocks so their activations stay in cache across the rows of the slice
+        constexpr size_t sampleBlock = 64;
+
+        for (size_t l = 0; l < _layers.size(); ++l)
+        {
+            const size_t layerInputs = _structure[l];
+            const size_t layerOutputs = _structure[l + 1];
+            const size_t rowStart = layerOutputs * slice / numSlices;
+            const size_t rowEnd = layerOutputs * (slice + 1) / numSlices;
+
+            const TMATH::bf16_t *delta = mixedArena.deltas(l);
+            const TMATH::bf16_t *prevActivations = mixedArena.activations(l);
+
+            float *wGrad = weightGradients[l].data();
+            float *bGrad = biasGradients[l].data();
+            std::fill(wGrad + rowStart * layerInputs, wGrad + rowEnd * layerInputs, 0.0f);
+            std::fill(bGrad + rowStart, bGrad + rowEnd, 0.0f);
+
+            for (size_t blockStart = 0; blockStart < batchSize; blockStart += sampleBlock)
+            {
+                const size_t blockEnd = std::min(batchSize, blockStart + sampleBlock);
+                for (size_t o = rowStart; o < rowEnd; ++o)
+                {
+                    const TMATH::bf16_t *deltaColumn = delta + blockStart * layerOutputs + o;
+                    const TMATH::bf16_t *blockActivations = prevActivations + blockStart * layerInputs;
+                    bGrad[o] += accumulateRowsBF16(deltaColumn, layerOutputs, blockActivations, layerInputs, blockEnd - blockStart, wGrad + o * layerInputs);
+                }
+            }
+        }
+    }
+
+    void DenseNeuralNetwork::accumulateGradientsBF16(std::span<const NTARS::DATA::TrainingData<std::vector<float>>> miniBatch, int32_t &numCorrect, int32_t &numWrong)
+    {
+        if (miniBatch.empty())
+        {
+            for (size_t l = 0; l < _layers.size(); ++l)
+            {
+                weightGradients[l].zero();
+                biasGradients[l].zero();
+            }
+
+            return;
+        }
+
+        if (!threadPool)
+            threadPool = std::make_unique<ThreadPool>();
+
+        const size_t numSlices = threadPool->size();
+        const size_t numThreads = std::min(threadPool->size(), miniBatch.size());
+        const size_t chunkSize = miniBatch.size() / numThreads;
+
+        mixedArena.plan(_structure, miniBatch.size(), numThreads, maxArenaBatch);
+        if (threadResults.size() < numThreads)
+            threadResults.resize(numThreads);
+        if (threadPhaseMs.size() < numThreads)
+            threadPhaseMs.resize(numThreads);
+
+        // BF16 copies of the master weights, rounded once per step
+        const auto convertStart = std::chrono::steady_clock::now();
+        timedParallelFor(numSlices, [&](size_t t)
+        {
+            for (size_t l = 0; l < _layers.size(); ++l)
+            {
+                const size_t cols = weights[l].cols();
+                const size_t rowStart = weights[l].rows() * t / numSlices;
+                const size_t rowEnd = weights[l].rows() * (t + 1) / numSlices;
+                TMATH::toBF16(weights[l].data() + rowStart * cols, mixedArena.weights(l) + rowStart * cols, (rowEnd - rowStart) * cols);
+            }
+        });
+        currentStep.forwardMs += elapsedMs(convertStart);
+
+        timedParallelFor(numThreads, [&](size_t t)
+        {
+            threadPhaseMs[t] = {0.0, 0.0};
+            size_t start = t * chunkSize;
+            size_t end = (t == numThreads - 1) ? miniBatch.size() : (t + 1) * chunkSize;
+
+            int32_t localCorrect = 0, localWrong = 0;
+            for (size_t i = start; i < end; i += maxArenaBatch)
+                calcDeltasBF16(miniBatch.data() + i, i, std::min(maxArenaBatch, end - i), t, localCorrect, localWrong);
+
+            threadResults[t] = {localCorrect, localWrong};
+        });
+
+        for (size_t t = 0; t < numThreads; ++t)
+        {
+            currentStep.forwardMs += threadPhaseMs[t][0] / numThreads;
+            currentStep.backwardMs += threadPhaseMs[t][1] / numThreads;
+        }
+
+        // every slice owns its rows of the gradients, so there is nothing to reduce and the sum order is fixed
+        const auto gradientStart = std::chrono::steady_clock::now();
+        timedParallelFor(numSlices, [&](size_t t)
+        {
+            calcWeightGradientsBF16(miniBatch.size(), t, numSlices);
+        });
+        currentStep.backwardMs += elapsedMs(gradientStart);
+
+        for (size_t t = 0; t < numThreads; ++t)
+        {
+            numCorrect += threadResults[t][0];
+            numWrong += threadResults[t][1];
+        }
+    }
+
+    bool DenseNeuralNetwork::gradientsFinite() const
+    {
+        for (size_t l = 0; l < _layers.size(); ++l)
+        {
+            // any inf or NaN makes the sum non-finite
+            float sum = 0.0f;
+            for (size_t i = 0; i < weightGradients[l].size(); ++i)
+                sum += weightGradients[l].data()[i] * 0.0f;
+            for (size_t i = 0; i < biasGradients[l].size(); ++i)
+                sum += biasGradients[l].data()[i] * 0.0f;
+
+            if (!std::isfinite(sum))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool DenseNeuralNetwork::setCollective(std::unique_ptr<RingAllReduce> newCollective)
+    {
+        collective = std::move(newCollective);
+        if (!collective)
+            return true;
+
+        materialize();
+
+        // every replica has to start from the same parameters
+        for (size_t l = 0; l < _layers.size(); ++l)
+        {
+            if (!collective->broadcast(weights[l].data(), weights[l].size()) || !collective->broadcast(biases[l].data(), biases[l].size()))
+            {
+                std::cerr << "Could not synchronize parameters with the other ranks" << std::endl;
+                collective.reset();
+                return false;
+            }
+        }
+
+        publish();
+        return true;
+    }
+
+    bool DenseNeuralNetwork::reduceAcrossRanks(int32_t &numCorrect, int32_t &numWrong, float &batchSize)
+    {
+        size_t total = 3;
+        for (size_t l = 0; l < _layers.size(); ++l)
+            total += weightGradients[l].size() + biasGradients[l].size();
+        reduceBuffer.resize(total);
+
+        float *cursor = reduceBuffer.data();
+        for (size_t l = 0; l < _layers.size(); ++l)
+        {
+            cursor = std::copy_n(weightGradients[l].data(), weightGradients[l].size(), cursor);
+            cursor = std::copy_n(biasGradients[l].data(), biasGradients[l].size(), cursor);
+        }
+
+        // counts stay exact in a float well past any batch size
+        cursor[0] = static_cast<float>(numCorrect);
+        cursor[1] = static_cast<float>(numWrong);
+        cursor[2] = batchSize;
+
+        if (!collective->sum(reduceBuffer.data(), reduceBuffer.size()))
+        {
+            std::cerr << "Gradient all-reduce failed on rank " << collective->getRank() << std::endl;
+            return false;
+        }
+
+        const float *source = reduceBuffer.data();
+        for (size_t l = 0; l < _layers.size(); ++l)
         {
-            weights[l] += weightGradients[l] * (learningRate / batchSize);
-            biases[l] += biasGradients[l] * (learningRate / batchSize);
+            std::copy_n(source, weightGradients[l].size(), weightGradients[l].data());
+            source += weightGradients[l].size();
+            std::copy_n(source, biasGradients[l].size(), biasGradients[l].data());
+            source += biasGradients[l].size();
         }
 
-        return static_cast<float>(numCorrect) / (numCorrect + numWrong);
+        numCorrect = static_cast<int32_t>(source[0]);
+        numWrong = static_cast<int32_t>(source[1]);
+        batchSize = source[2];
+        return true;
     }
 
 } // namespace NTARS
@@ -6,10 +6,21 @@
 #include "ntars/layers/dense_layer.hpp"
 #include "ntars/base/data.hpp"
 #include "ntars/base/utils.hpp"
+#include "ntars/base/optimizer.hpp"
+#include "ntars/base/arena.hpp"
+#include "ntars/base/thread_pool.hpp"
+#include "ntars/base/model_format.hpp"
+#include "ntars/base/checkpoint.hpp"
+#include "ntars/base/telemetry.hpp"
+#include "ntars/distributed/ring_all_reduce.hpp"
 #include <numeric>
 #include <imgui/imgui/imgui.h>
 
+#include <atomic>
+#include <filesystem>
+#include <memory>
 #include <mutex>
+#include <span>
 
 namespace NTARS
 {
@@ -19,6 +30,72 @@ namespace NTARS
         std::vector<std::vector<float>> activations;
     };
 
+    // Caller-owned scratch space for the const inference path, one per concurrent caller
+    struct ForwardContext
+    {
+        std::vector<std::vector<float>> activations;
+
+        inline const std::vector<float>& output() const { return activations.back(); }
+    };
+
+    // Ping-pong buffers sized to the widest layer, predict() only ever keeps two layers alive
+    struct PredictWorkspace
+    {
+        std::vector<float> front;
+        std::vector<float> back;
+        std::vector<float> scratch;     // layer scratch such as im2col columns, dense layers need none
+    };
+
+    enum TrainingPrecision_
+    {
+        TrainingPrecision_FP32 = 0,
+        TrainingPrecision_BF16,     // BF16 weights, activations and deltas into the products, FP32 accumulation and master weights
+    };
+
+    // Activation memory one training thread holds per pass over its samples
+    struct ActivationMemoryReport
+    {
+        size_t checkpointInterval{0};
+        size_t batchSize{0};
+        size_t storedLayers{0};         // layer outputs kept from the forward pass until backward
+        size_t recomputedLayers{0};     // extra layer forwards per pass
+        size_t bytes{0};
+        size_t fullBytes{0};            // the same pass without checkpointing
+    };
+
+    // Cost model and measurement of one layer over a batch. FLOPs count a multiply-add as two, bytes are the
+    // compulsory FP32 traffic (every operand read once, every result written once), so the intensity is an
+    // upper bound the kernels can only approach when their operands stay in cache
+    struct LayerProfile
+    {
+        size_t layer{0};
+        size_t inputs{0};
+        size_t outputs{0};
+
+        double forwardFlops{0};
+        double backwardFlops{0};
+        double forwardBytes{0};
+        double backwardBytes{0};
+
+        double forwardMs{0};            // mean over the measured iterations
+        double backwardMs{0};
+        double forwardGFlops{0};
+        double backwardGFlops{0};
+        double forwardIntensity{0};     // FLOPs per byte
+        double backwardIntensity{0};
+    };
+
+    // Immutable parameter set published by a trainer, freed or recycled once its last reader drops it
+    struct WeightSnapshot
+    {
+        uint64_t version{0};
+        std::vector<const float*> weights;
+        std::vector<const float*> biases;
+
+        std::vector<float> storage;
+        std::shared_ptr<const FORMAT::ModelReader> mapping; // keeps a mapped model alive while the views point into it
+    };
+
     // Neural Network which uses dense layers
     class DenseNeuralNetwork 
     {
@@ -29,21 +106,131 @@ namespace NTARS
         ~DenseNeuralNetwork();
 
         ForwardResult run(const std::vector<float>& inputs);
-        float trainCPU(std::vector<NTARS::DATA::TrainingData<std::vector<float>>>& miniBatch, float learningRate = 1);
+
+        // Thread-safe inference, only writes to the given context
+        ForwardContext createContext() const;
+        const std::vector<float>& run(const std::vector<float>& inputs, ForwardContext& context) const;
+        std::vector<std::vector<float>> runBatch(const std::vector<std::vector<float>>& inputs, size_t numThreads = 0) const;
+
+        // Output-only inference, no intermediate activations and no allocation once the workspace is sized
+        PredictWorkspace createWorkspace() const;
+        std::span<const float> predict(const float* inputs, PredictWorkspace& workspace) const;
+        std::span<const float> predict(const std::vector<float>& inputs);
+
+        // Batched output-only inference, inputs and outputs hold count samples row after row
+        void predictBatch(const float* inputs, size_t count, float* outputs, PredictWorkspace& workspace) const;
+
+        // Snapshot inference, safe while another thread trains and publishes this network
+        const std::vector<float>& run(const std::vector<float>& inputs, ForwardContext& context, const WeightSnapshot& snapshot) const;
+        std::span<const float> predict(const float* inputs, PredictWorkspace& workspace, const WeightSnapshot& snapshot) const;
+        void predictBatch(const float* inputs, size_t count, float* outputs, PredictWorkspace& workspace, const WeightSnapshot& snapshot) const;
+
+        // Copies the current parameters into a new snapshot and swaps it in for readers, returns its version
+        uint64_t publish();
+        // Never waits for training, only for the pointer swap in publish(): std::atomic<std::shared_ptr> guards it
+        // with a short internal lock on libstdc++ and MSVC. The snapshot stays valid for as long as the caller holds it
+        inline std::shared_ptr<const WeightSnapshot> getSnapshot() const { return publishedSnapshot.load(std::memory_order_acquire); }
+
+        // One step on a contiguous run of samples, which can be a window into a larger shared dataset. The updated
+        // parameters are published before it returns
+        float trainCPU(std::span<const NTARS::DATA::TrainingData<std::vector<float>>> miniBatch, float learningRate = 1);
         void train(std::vector<NTARS::DATA::TrainingData<std::vector<float>>>& miniBatch, float learningRate = 1);
 
+        // Binary .tars model, mmap loaded by the file constructor
         void save();
+        // Text export read by the file constructor for any non .tars path
+        void saveJSON();
+
+        // Copies parameters, optimizer state, loss scaling, the dropout streams and progress into a free checkpoint
+        // buffer, the write happens on the checkpointer's thread
+        void checkpoint(Checkpointer& checkpointer, const TrainingProgress& progress) const;
+        // Restores all of it from a checkpoint of this structure and returns where training stopped. Dropout rates
+        // are set before resuming, like the structure they are part of the network's setup rather than its state
+        bool resume(const std::filesystem::path& file, TrainingProgress& progress);
+
+        // Data-parallel training: every trainCPU call sums gradients and accuracy with the other ranks before the
+        // update, so each rank passes its own shard of the global batch. Rank 0's parameters are broadcast on join.
+        // N ranks with one thread each end bit-identical to one process training the whole batch on N threads;
+        // ranks with more threads fold their shard in another order and only agree to rounding
+        bool setCollective(std::unique_ptr<RingAllReduce> newCollective);
+        inline RingAllReduce* getCollective() { return collective.get(); }
+
+        // FP32 training keeps only every interval-th layer's activations and recomputes the layers in between
+        // during backward, trading about one extra forward pass for memory. An interval near sqrt(layers) keeps
+        // the fewest buffers, 0 or 1 stores everything
+        void setGradientCheckpointing(size_t interval);
+        inline size_t getGradientCheckpointing() const { return checkpointInterval; }
+        ActivationMemoryReport getActivationMemoryReport(size_t interval, size_t batchSize = maxArenaBatch) const;
+
+        // Switching precision frees the buffers of the other mode, parameters and optimizer state are untouched
+        void setTrainingPrecision(TrainingPrecision_ newPrecision);
+        inline TrainingPrecision_ getTrainingPrecision() const { return precision; }
+
+        // BF16 training multiplies the output deltas by the scale before rounding them and divides it back out of the
+        // update. Dynamic scaling skips steps with non-finite gradients and halves the scale, then doubles it again
+        // after lossScaleGrowthInterval clean steps. A scale of 1 without dynamic scaling turns it off
+        void setLossScaling(float initialScale, bool dynamic);
+        inline float getLossScale() const { return lossScale; }
+        inline size_t getSkippedSteps() const { return skippedSteps; }
+
+        // Phase times, throughput, allocations and idle time of every trainCPU call, safe to read while training
+        inline TrainingTelemetry& getTelemetry() { return telemetry; }
+        inline const TrainingTelemetry& getTelemetry() const { return telemetry; }
+
+        // Runs each layer's training kernels on one thread over random data, iterations times per layer, and
+        // reports them next to their theoretical cost. Uses the training buffers but leaves the parameters alone
+        std::vector<LayerProfile> profile(size_t iterations = 100, size_t batchSize = maxArenaBatch);
+
+        // Resizes the training thread pool, 0 uses every hardware thread
+        void setThreadCount(size_t numThreads);
+        inline size_t getThreadCount() const { return threadPool ? threadPool->size() : std::max<size_t>(1, std::thread::hardware_concurrency()); }
+
+        // Arena, per-thread gradient and BF16 buffer memory held for training, in bytes
+        size_t getTrainingMemoryBytes() const;
+
+        // Inverted dropout on the outputs of a hidden layer during FP32 training, a rate of 0 turns it off. Each training
+        // thread draws its masks from its own stream, inference, saved models and BF16 steps never apply it
+        bool setDropout(size_t layer, float rate);
+        inline float getDropout(size_t layer) const { return layer < dropouts.size() ? dropouts[layer].getRate() : 0.0f; }
+
+        // Replaces the update rule and reallocates its state buffers; SGD is used by default
+        void setOptimizer(std::unique_ptr<Optimizer> newOptimizer);
+        inline Optimizer& getOptimizer() { return *optimizer; }
 
         inline std::vector<size_t> getStructure() const { return _structure; }
+        inline const std::string& getName() const { return name; }
+        inline NeuralNetworkFlags_ getFlags() const { return flags; }
         inline std::vector<DenseLayer>& getLayers() { return _layers; }
+        inline const std::vector<DenseLayer>& getLayers() const { return _layers; }
+
+        // Copies a mapped model into owned matrices first
+        inline std::vector<TMATH::Matrix_t<float>>& getWeights() { materialize(); return weights; }
+        inline std::vector<TMATH::Matrix_t<float>>& getBiases() { materialize(); return biases; }
+
+        inline bool isMapped() const { return mappedModel != nullptr; }
 
-        inline std::vector<TMATH::Matrix_t<float>>& getWeights() { return weights; }
-        inline std::vector<TMATH::Matrix_t<float>>& getBiases() { return biases; }
+        // The parameters run() and predict() read, owned or mapped
+        inline const float* getWeightData(size_t layer) const { return weightViews[layer]; }
+        inline const float* getBiasData(size_t layer) const { return biasViews[layer]; }
 
         void drawNetwork(bool partial);
     private:
+        bool loadJSON(const std::filesystem::path& inputPath);
+        bool loadBinary(const std::filesystem::path& inputPath);
+
+        const std::vector<float>& runWith(const std::vector<float>& inputs, ForwardContext& context, const float* const* weightData, const float* const* biasData) const;
+        std::span<const float> predictWith(const float* inputs, PredictWorkspace& workspace, const float* const* weightData, const float* const* biasData) const;
+        void predictBatchWith(const float* inputs, size_t count, float* outputs, PredictWorkspace& workspace, const float* const* weightData, const float* const* biasData) const;
+
+        void bindParameterViews();
+        void materialize();
+        // materialize() and also drop the mapping from the published and retired snapshots
+        void releaseMapping();
+
         void initializeWeightsAndBiases(const std::vector<size_t>& structure);
         void initializeTrainingBuffers();
+        void initializeOptimizerState();
+        void applyOptimizer(float learningRate, float batchSize);
         void createLayers(const std::vector<size_t>& structure);
 
         constexpr uint32_t getMostActive(const std::vector<float>& outputs) const
@@ -56,14 +243,48 @@ namespace NTARS
             return meanSquaredError(results.data(), expected.data(), results.size());
         }
 
-        void calcGradient(const NTARS::DATA::TrainingData<std::vector<float>>& data,        
-            std::vector<TMATH::Matrix_t<float>>& localWGradient,
-            std::vector<TMATH::Matrix_t<float>>& localBGradient, 
+        // Accumulates the gradient of count samples into the given thread's buffers, using its arena
+        void calcGradient(const NTARS::DATA::TrainingData<std::vector<float>>* samples, size_t count, size_t thread,
             int32_t& numCorrect, int32_t& numWrong);
+        void calcGradientCheckpointed(const NTARS::DATA::TrainingData<std::vector<float>>* samples, size_t count, size_t thread,
+            int32_t& numCorrect, int32_t& numWrong);
+        // Adds layer l's gradient and, past the first layer, writes the delta of layer l - 1. The activation derivative
+        // comes from the pre-activations when given, otherwise from the activations. prevMask is the dropout mask
+        // layer l - 1 was run with, if any
+        void backpropagateLayer(size_t l, const float* delta, const float* prevActivations, const float* prevPreActivations,
+            float* prevDelta, size_t count, size_t thread, const uint32_t* prevMask = nullptr);
+        // Draws the thread's masks for its next count samples, dropoutMask() is null for layers without dropout
+        void drawDropoutMasks(size_t thread, size_t count);
+        const uint32_t* dropoutMask(size_t thread, size_t l) const;
+        inline float dropoutScale(size_t l) const { return l < dropouts.size() ? dropouts[l].getScale() : 1.0f; }
+        void prepareThreadBuffers(size_t numThreads, size_t batchSize);
+        // parallelFor that adds each task's wait for the slowest one and its allocations to the current step
+        template<typename F>
+        void timedParallelFor(size_t count, F&& fn);
+        void accumulateGradients(std::span<const NTARS::DATA::TrainingData<std::vector<float>>> miniBatch, int32_t& numCorrect, int32_t& numWrong);
+        bool reduceAcrossRanks(int32_t& numCorrect, int32_t& numWrong, float& batchSize);
+
+        // BF16 step: forward and backward per thread over its samples, then the weight gradients per slice of rows
+        void calcDeltasBF16(const NTARS::DATA::TrainingData<std::vector<float>>* samples, size_t first, size_t count, size_t thread,
+            int32_t& numCorrect, int32_t& numWrong);
+        void calcWeightGradientsBF16(size_t batchSize, size_t slice, size_t numSlices);
+        void accumulateGradientsBF16(std::span<const NTARS::DATA::TrainingData<std::vector<float>>> miniBatch, int32_t& numCorrect, int32_t& numWrong);
+        bool gradientsFinite() const;
 
         std::vector<TMATH::Matrix_t<float>> weights;
         std::vector<TMATH::Matrix_t<float>> biases;
 
+        // What inference reads, either the matrices above or tensors inside the mapped model file
+        std::shared_ptr<FORMAT::ModelReader> mappedModel;
+        std::vector<const float*> weightViews;
+        std::vector<const float*> biasViews;
+
+        // RCU style publication: readers copy the pointer out and read their copy unguarded, publish() swaps in a fresh one
+        std::atomic<std::shared_ptr<const WeightSnapshot>> publishedSnapshot;
+        std::shared_ptr<WeightSnapshot> retiredSnapshot;
+        std::mutex publishMutex;
+        uint64_t snapshotVersion{0};
+
         std::string name;
 
         std::vector<DenseLayer> _layers;
@@ -74,6 +295,51 @@ namespace NTARS
         // Training Buffers
         std::vector<TMATH::Matrix_t<float>> weightGradients;
         std::vector<TMATH::Matrix_t<float>> biasGradients;
+
+        PredictWorkspace _predictWorkspace;
+
+        // Per-thread training state, planned once and reused by every step
+        static constexpr size_t maxArenaBatch = 64;
+        size_t checkpointInterval{0};
+
+        std::unique_ptr<ThreadPool> threadPool;
+        std::vector<TrainingArena> arenas;
+        std::vector<std::vector<TMATH::Matrix_t<float>>> threadWeightGradients;
+        std::vector<std::vector<TMATH::Matrix_t<float>>> threadBiasGradients;
+        std::vector<std::array<int32_t, 2>> threadResults; // correct/wrong
+
+        // Dropout per layer, empty until setDropout. Masks are [thread], every layer's back to back at the offsets
+        std::vector<DropoutLayer> dropouts;
+        uint64_t dropoutSeed{0};
+        std::vector<Random> dropoutStreams;
+        std::vector<std::vector<uint32_t>> dropoutMasks;
+        std::vector<size_t> dropoutMaskOffsets;
+
+        // Mixed precision training state
+        static constexpr size_t lossScaleGrowthInterval = 1000;
+
+        TrainingPrecision_ precision{TrainingPrecision_FP32};
+        MixedPrecisionArena mixedArena;
+        float lossScale{1.0f};
+        bool dynamicLossScale{false};
+        size_t cleanSteps{0};
+        size_t skippedSteps{0};
+
+        // Counters of the step in progress, forward/backward busy time per task
+        TrainingTelemetry telemetry;
+        StepTelemetry currentStep;
+        std::vector<std::array<double, 2>> threadPhaseMs;
+        std::vector<double> taskFinishMs;
+        std::vector<uint64_t> taskAllocations;
+
+        // Gradients and counters packed into one buffer for a single all-reduce per step
+        std::unique_ptr<RingAllReduce> collective;
+        std::vector<float> reduceBuffer;
+
+        // Optimizer state, [layer][slot] with slot < optimizer->getStateCount()
+        std::unique_ptr<Optimizer> optimizer{std::make_unique<SGDOptimizer>()};
+        std::vector<std::vector<TMATH::Matrix_t<float>>> weightOptimizerState;
+        std::vector<std::vector<TMATH::Matrix_t<float>>> biasOptimizerState;
     };
     
 } // namespace NTARS
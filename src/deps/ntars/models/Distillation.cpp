@@ -0,0 +1,312 @@
+#include "Distillation.hpp"
+
+#include "ntars/base/random.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+
+namespace NTARS
+{
+    // TeacherCacheHeader | float outputs[numSamples][numOutputs]
+    struct TeacherCacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t key;            // checksum of the teacher's structure, parameters and the training inputs
+        uint64_t numSamples;
+        uint64_t numOutputs;
+    };
+
+    static constexpr char teacherCacheMagic[4] = {'T', 'D', 'S', 'T'};
+    static constexpr uint32_t teacherCacheVersion = 1;
+
+    static std::string describeStructure(const std::vector<size_t>& structure)
+    {
+        std::string text;
+        for (size_t i = 0; i < structure.size(); ++i)
+            text += (i == 0 ? "" : "-") + std::to_string(structure[i]);
+
+        return text;
+    }
+
+    static size_t argmax(std::span<const float> values)
+    {
+        return std::distance(values.begin(), std::max_element(values.begin(), values.end()));
+    }
+
+    DistillationTrainer::DistillationTrainer(const DenseNeuralNetwork& teacher, std::span<const Sample> trainingSet, std::span<const Sample> validationSet,
+        const DistillationOptions& options)
+        : teacher(teacher), trainingSet(trainingSet), validationSet(validationSet), options(options)
+    {
+        this->options.teacherWeight = std::clamp(options.teacherWeight, 0.0f, 1.0f);
+        this->options.batchSize = std::max<size_t>(1, options.batchSize);
+
+        const std::vector<size_t> structure = teacher.getStructure();
+        numOutputs = structure.empty() ? 0 : structure.back();
+    }
+
+    uint64_t DistillationTrainer::computeCacheKey() const
+    {
+        FORMAT::Checksum sum;
+
+        const std::vector<size_t> structure = teacher.getStructure();
+        const uint32_t flags = static_cast<uint32_t>(teacher.getFlags());
+        sum.update(structure.data(), structure.size() * sizeof(size_t));
+        sum.update(&flags, sizeof(flags));
+
+        // the parameters computeTeacherOutputs runs on, a published snapshot can lag behind them
+        for (size_t l = 0; l + 1 < structure.size(); ++l)
+        {
+            sum.update(teacher.getWeightData(l), structure[l] * structure[l + 1] * sizeof(float));
+            sum.update(teacher.getBiasData(l), structure[l + 1] * sizeof(float));
+        }
+
+        for (const Sample& sample : trainingSet)
+            sum.update(sample.data.data(), sample.data.size() * sizeof(float));
+
+        return sum.value();
+    }
+
+    bool DistillationTrainer::prepareTeacherOutputs(const std::filesystem::path& cacheFile)
+    {
+        if (numOutputs == 0 || trainingSet.empty() || teacher.getStructure().size() < 2)
+        {
+            std::cerr << "Distillation needs a teacher network and training samples" << std::endl;
+            return false;
+        }
+
+        const uint64_t key = computeCacheKey();
+        if (readCache(cacheFile, key))
+        {
+            std::cout << "Teacher outputs loaded from " << cacheFile.string() << std::endl;
+        }
+        else
+        {
+            const auto start = std::chrono::steady_clock::now();
+            computeTeacherOutputs();
+            std::cout << "Teacher outputs computed in " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+                      << " s" << std::endl;
+
+            writeCache(cacheFile, key);
+        }
+
+        PredictWorkspace workspace = teacher.createWorkspace();
+        teacherValidationGuesses.clear();
+        for (const Sample& sample : validationSet)
+            teacherValidationGuesses.push_back(argmax(teacher.predict(sample.data.data(), workspace)));
+
+        return true;
+    }
+
+    void DistillationTrainer::computeTeacherOutputs()
+    {
+        teacherOutputs.resize(trainingSet.size() * numOutputs);
+
+        PredictWorkspace workspace = teacher.createWorkspace();
+        for (size_t i = 0; i < trainingSet.size(); ++i)
+        {
+            std::span<const float> output = teacher.predict(trainingSet[i].data.data(), workspace);
+            std::copy(output.begin(), output.end(), teacherOutputs.begin() + i * numOutputs);
+        }
+    }
+
+    bool DistillationTrainer::readCache(const std::filesystem::path& cacheFile, uint64_t key)
+    {
+        std::ifstream in(cacheFile, std::ios::binary);
+        if (!in.is_open())
+            return false;
+
+        TeacherCacheHeader header;
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, teacherCacheMagic, sizeof(header.magic)) != 0 ||
+            header.version != teacherCacheVersion || header.key != key || header.numSamples != trainingSet.size() || header.numOutputs != numOutputs)
+        {
+            return false;
+        }
+
+        teacherOutputs.resize(trainingSet.size() * numOutputs);
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(teacherOutputs.data()), teacherOutputs.size() * sizeof(float)));
+    }
+
+    void DistillationTrainer::writeCache(const std::filesystem::path& cacheFile, uint64_t key) const
+    {
+        if (cacheFile.has_parent_path())
+        {
+            std::error_code error;
+            std::filesystem::create_directories(cacheFile.parent_path(), error);
+        }
+
+        TeacherCacheHeader header{};
+        std::memcpy(header.magic, teacherCacheMagic, sizeof(header.magic));
+        header.version = teacherCacheVersion;
+        header.key = key;
+        header.numSamples = trainingSet.size();
+        header.numOutputs = numOutputs;
+
+        // written next to the cache and renamed, a crash never leaves a truncated cache that looks valid
+        std::filesystem::path tempPath = cacheFile;
+        tempPath += ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(teacherOutputs.data()), teacherOutputs.size() * sizeof(float));
+            if (!out.good())
+            {
+                std::cerr << "Could not open file for writing: " << tempPath << std::endl;
+                return;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, cacheFile, error);
+        if (error)
+            std::cerr << "Could not open file for writing: " << cacheFile << std::endl;
+    }
+
+    const std::vector<DistillationResult>& DistillationTrainer::run(const std::vector<std::vector<size_t>>& structures, NeuralNetworkFlags_ flags)
+    {
+        results.clear();
+        students.clear();
+        if (teacherOutputs.size() != trainingSet.size() * numOutputs || trainingSet.empty())
+        {
+            std::cerr << "Teacher outputs are not prepared, call prepareTeacherOutputs() first" << std::endl;
+            return results;
+        }
+
+        results.push_back(measure(teacher));
+        results.back().teacher = true;
+        students.emplace_back();
+
+        const float teacherWeight = options.teacherWeight;
+        const size_t batchSize = options.batchSize;
+        const size_t numBatches = (trainingSet.size() + batchSize - 1) / batchSize;
+
+        std::vector<Sample> batch(batchSize);
+        for (const std::vector<size_t>& structure : structures)
+        {
+            if (structure.size() < 2 || structure.front() != trainingSet.front().data.size() || structure.back() != numOutputs)
+            {
+                std::cerr << "Student " << describeStructure(structure) << " does not match the teacher's inputs and outputs" << std::endl;
+                continue;
+            }
+
+            auto student = std::make_unique<DenseNeuralNetwork>(structure, "Student_" + describeStructure(structure), flags);
+            student->setOptimizer(createOptimizer(options.optimizer));
+            student->getTelemetry().setEnabled(false);
+            if (options.numThreads != 0)
+                student->setThreadCount(options.numThreads);
+
+            Random shuffler{options.seed};
+            std::vector<size_t> order(trainingSet.size());
+            std::iota(order.begin(), order.end(), 0);
+
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t epoch = 0; epoch < options.epochs; ++epoch)
+            {
+                shuffler.shuffle(order.begin(), order.end());
+
+                for (size_t b = 0; b < numBatches; ++b)
+                {
+                    // targets are blended per batch into reused buffers, the dataset itself is never duplicated
+                    const size_t first = b * batchSize;
+                    const size_t count = std::min(batchSize, trainingSet.size() - first);
+                    for (size_t k = 0; k < count; ++k)
+                    {
+                        const size_t index = order[first + k];
+                        const float* soft = teacherOutputs.data() + index * numOutputs;
+
+                        batch[k].data = trainingSet[index].data;
+                        batch[k].label.resize(numOutputs);
+                        for (size_t o = 0; o < numOutputs; ++o)
+                            batch[k].label[o] = teacherWeight * soft[o] + (1.0f - teacherWeight) * trainingSet[index].label[o];
+                    }
+
+                    student->trainCPU(std::span<const Sample>(batch.data(), count), options.learningRate);
+                }
+            }
+            const double trainSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            results.push_back(measure(*student));
+            results.back().trainSeconds = trainSeconds;
+            students.push_back(std::move(student));
+        }
+
+        return results;
+    }
+
+    DistillationResult DistillationTrainer::measure(const DenseNeuralNetwork& network) const
+    {
+        DistillationResult result;
+        result.structure = network.getStructure();
+        for (size_t l = 0; l + 1 < result.structure.size(); ++l)
+            result.parameters += result.structure[l + 1] * (result.structure[l] + 1);
+
+        PredictWorkspace workspace = network.createWorkspace();
+        size_t correct = 0;
+        size_t agreed = 0;
+        for (size_t i = 0; i < validationSet.size(); ++i)
+        {
+            const size_t guess = argmax(network.predict(validationSet[i].data.data(), workspace));
+            if (guess == argmax(validationSet[i].label))
+                ++correct;
+            if (i < teacherValidationGuesses.size() && guess == teacherValidationGuesses[i])
+                ++agreed;
+        }
+
+        if (!validationSet.empty())
+        {
+            result.accuracy = static_cast<float>(correct) / validationSet.size();
+            result.agreement = static_cast<float>(agreed) / validationSet.size();
+        }
+
+        // the same inputs in the same order for every network, after one untimed pass to warm the caches
+        std::span<const Sample> timed = validationSet.empty() ? trainingSet : validationSet;
+        const size_t iterations = std::max<size_t>(1, options.latencySamples);
+        for (size_t i = 0; i < std::min(iterations, timed.size()); ++i)
+            network.predict(timed[i].data.data(), workspace);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+            network.predict(timed[i % timed.size()].data.data(), workspace);
+        result.latencyUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+        return result;
+    }
+
+    int64_t DistillationTrainer::pickFastest(float minAccuracy) const
+    {
+        int64_t best = -1;
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            if (results[i].teacher || results[i].accuracy < minAccuracy)
+                continue;
+
+            if (best < 0 || results[i].latencyUs < results[best].latencyUs)
+                best = static_cast<int64_t>(i);
+        }
+
+        return best;
+    }
+
+    bool DistillationTrainer::writeResults(const std::filesystem::path& file) const
+    {
+        std::ofstream out(file);
+        if (!out.is_open())
+        {
+            std::cerr << "Could not open file for writing: " << file << std::endl;
+            return false;
+        }
+
+        out << "network,structure,parameters,accuracy,teacher_agreement,latency_us,train_seconds\n";
+        for (const DistillationResult& result : results)
+        {
+            out << (result.teacher ? "teacher" : "student") << ',' << describeStructure(result.structure) << ',' << result.parameters << ','
+                << result.accuracy << ',' << result.agreement << ',' << result.latencyUs << ',' << result.trainSeconds << '\n';
+        }
+
+        return !out.fail();
+    }
+} // namespace NTARS
@@ -0,0 +1,90 @@
+#ifndef NTARS_DISTILLATION_HPP
+#define NTARS_DISTILLATION_HPP
+
+#include "ntars/models/DenseNetwork.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace NTARS
+{
+    struct DistillationOptions
+    {
+        float teacherWeight{0.5f};       // share of the teacher's outputs in the targets, the rest is the hard label
+        size_t epochs{3};
+        size_t batchSize{100};
+        float learningRate{0.5f};
+        OptimizerType_ optimizer{OptimizerType_SGD};
+        size_t numThreads{0};            // training threads, 0 uses every hardware thread
+        size_t latencySamples{2000};     // single-sample predictions timed per network
+        uint64_t seed{1};
+    };
+
+    struct DistillationResult
+    {
+        std::vector<size_t> structure;
+        bool teacher{false};             // the baseline row
+        size_t parameters{0};
+        float accuracy{0};               // validation, against the hard labels
+        float agreement{0};              // validation samples where the argmax matches the teacher's
+        double latencyUs{0};             // mean single-sample predict()
+        double trainSeconds{0};
+    };
+
+    // Trains small students to reproduce a large teacher. The teacher runs over the training set once and its
+    // outputs are cached on disk, keyed by a checksum of its parameters and the data, so later runs skip it.
+    // Students train on teacherWeight * teacher outputs + (1 - teacherWeight) * label with the usual trainCPU
+    // loss. Every student is then timed and scored so the fastest one that is still strong enough can be picked.
+    // The sample spans are caller-owned and have to outlive the trainer
+    class DistillationTrainer
+    {
+    public:
+        using Sample = DATA::TrainingData<std::vector<float>>;
+
+        DistillationTrainer(const DenseNeuralNetwork& teacher, std::span<const Sample> trainingSet, std::span<const Sample> validationSet,
+            const DistillationOptions& options = {});
+
+        // Loads the teacher outputs from cacheFile if it matches, otherwise computes and writes them.
+        // Only fails if they could not be computed, an unwritable cache just means recomputing next time
+        bool prepareTeacherOutputs(const std::filesystem::path& cacheFile);
+
+        // Trains one student per structure and measures it next to the teacher, results in the given order
+        // after the teacher's row
+        const std::vector<DistillationResult>& run(const std::vector<std::vector<size_t>>& structures, NeuralNetworkFlags_ flags = NeuralNetworkFlags_None);
+
+        // Fastest student with at least minAccuracy, -1 if none reaches it
+        int64_t pickFastest(float minAccuracy) const;
+
+        inline const std::vector<DistillationResult>& getResults() const { return results; }
+        // Student of results[index], null for the teacher's row
+        inline DenseNeuralNetwork* getStudent(size_t index) { return index < students.size() ? students[index].get() : nullptr; }
+
+        // CSV table of the results, one row per network
+        bool writeResults(const std::filesystem::path& file) const;
+
+    private:
+        uint64_t computeCacheKey() const;
+        void computeTeacherOutputs();
+        bool readCache(const std::filesystem::path& cacheFile, uint64_t key);
+        void writeCache(const std::filesystem::path& cacheFile, uint64_t key) const;
+
+        DistillationResult measure(const DenseNeuralNetwork& network) const;
+
+        const DenseNeuralNetwork& teacher;
+        std::span<const Sample> trainingSet;
+        std::span<const Sample> validationSet;
+        DistillationOptions options;
+
+        size_t numOutputs{0};
+        std::vector<float> teacherOutputs;          // [training sample][output]
+        std::vector<size_t> teacherValidationGuesses;
+
+        std::vector<DistillationResult> results;
+        std::vector<std::unique_ptr<DenseNeuralNetwork>> students;  // parallel to results
+    };
+} // namespace NTARS
+
+#endif // NTARS_DISTILLATION_HPP
@@ -0,0 +1,215 @@
+#include "HyperparameterSweep.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <thread>
+
+namespace NTARS
+{
+    static std::string describeStructure(const std::vector<size_t>& structure)
+    {
+        std::string text;
+        for (size_t i = 0; i < structure.size(); ++i)
+            text += (i == 0 ? "" : "-") + std::to_string(structure[i]);
+
+        return text;
+    }
+
+    std::string SweepConfig::describe() const
+    {
+        std::ostringstream text;
+        text << describeStructure(structure) << " b" << batchSize << " lr" << learningRate << " " << getOptimizerName(optimizer);
+        return text.str();
+    }
+
+    HyperparameterSweep::HyperparameterSweep(std::span<const Sample> trainingSet, std::span<const Sample> validationSet, const SweepOptions& options)
+        : trainingSet(trainingSet), validationSet(validationSet), options(options)
+    {
+        this->options.epochsPerRound = std::max<size_t>(1, options.epochsPerRound);
+        this->options.eta = std::max<size_t>(2, options.eta);
+        this->options.minRuns = std::max<size_t>(1, options.minRuns);
+        if (this->options.numThreads == 0)
+            this->options.numThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    void HyperparameterSweep::add(const SweepConfig& config)
+    {
+        Run run;
+        run.result.config = config;
+        run.result.config.batchSize = std::max<size_t>(1, config.batchSize);
+        // one stream per run, so the batch orders stay the same whichever thread trains it
+        run.shuffler = Random(options.seed, runs.size());
+        runs.push_back(std::move(run));
+    }
+
+    void HyperparameterSweep::addGrid(const std::vector<std::vector<size_t>>& structures, const std::vector<size_t>& batchSizes,
+        const std::vector<float>& learningRates, const std::vector<OptimizerType_>& optimizers, NeuralNetworkFlags_ flags)
+    {
+        for (const auto& structure : structures)
+            for (size_t batchSize : batchSizes)
+                for (float learningRate : learningRates)
+                    for (OptimizerType_ optimizer : optimizers)
+                        add(SweepConfig{structure, batchSize, learningRate, optimizer, flags});
+    }
+
+    const std::vector<SweepResult>& HyperparameterSweep::run()
+    {
+        results.clear();
+        if (runs.empty() || trainingSet.empty())
+            return results;
+
+        // built up front on this thread in run order, so each run's initial weights depend only on the seed and its
+        // place in the sweep. Pool threads get their random streams in the order they first draw, which varies
+        for (auto& run : runs)
+        {
+            if (run.network)
+                continue;
+
+            const SweepConfig& config = run.result.config;
+            run.network = std::make_unique<DenseNeuralNetwork>(config.structure, config.describe(), config.flags);
+            run.network->setOptimizer(createOptimizer(config.optimizer));
+            run.network->getTelemetry().setEnabled(false);
+        }
+
+        std::vector<size_t> active(runs.size());
+        std::iota(active.begin(), active.end(), 0);
+
+        size_t budget = options.epochsPerRound;
+        for (size_t round = 0; !active.empty(); ++round)
+        {
+            // the threads are split as evenly as possible between the runs training at the same time
+            const size_t lanes = std::min(active.size(), options.numThreads);
+            std::cout << "Sweep round " << round << ": " << active.size() << " runs, " << budget << " epochs, "
+                      << lanes << " at a time" << std::endl;
+
+            std::atomic<size_t> nextRun{0};
+            std::vector<std::thread> workers;
+            for (size_t lane = 0; lane < lanes; ++lane)
+            {
+                const size_t laneThreads = options.numThreads / lanes + (lane < options.numThreads % lanes ? 1 : 0);
+                workers.emplace_back([&, laneThreads]()
+                {
+                    for (size_t i = nextRun++; i < active.size(); i = nextRun++)
+                        trainRun(runs[active[i]], budget, laneThreads);
+                });
+            }
+
+            for (auto& worker : workers)
+                worker.join();
+
+            for (size_t index : active)
+                runs[index].result.rounds = round + 1;
+
+            if (active.size() <= options.minRuns)
+            {
+                for (size_t index : active)
+                    runs[index].result.finalist = true;
+                break;
+            }
+
+            std::stable_sort(active.begin(), active.end(), [&](size_t a, size_t b) {
+                return runs[a].result.validationAccuracy > runs[b].result.validationAccuracy;
+            });
+
+            // the losers keep their results and free their network
+            const size_t survivors = std::max(options.minRuns, active.size() / options.eta);
+            for (size_t i = survivors; i < active.size(); ++i)
+                runs[active[i]].network.reset();
+
+            active.resize(survivors);
+            budget *= options.eta;
+        }
+
+        for (const auto& run : runs)
+            results.push_back(run.result);
+
+        std::stable_sort(results.begin(), results.end(), [](const SweepResult& a, const SweepResult& b) {
+            if (a.rounds != b.rounds)
+                return a.rounds > b.rounds;
+            return a.validationAccuracy > b.validationAccuracy;
+        });
+
+        return results;
+    }
+
+    void HyperparameterSweep::trainRun(Run& run, size_t epochs, size_t numThreads)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        DenseNeuralNetwork& network = *run.network;
+        if (network.getThreadCount() != numThreads)
+            network.setThreadCount(numThreads);
+
+        const SweepConfig& config = run.result.config;
+        const size_t numBatches = (trainingSet.size() + config.batchSize - 1) / config.batchSize;
+        if (run.batchOrder.size() != numBatches)
+        {
+            run.batchOrder.resize(numBatches);
+            std::iota(run.batchOrder.begin(), run.batchOrder.end(), 0);
+        }
+
+        for (size_t epoch = 0; epoch < epochs; ++epoch)
+        {
+            run.shuffler.shuffle(run.batchOrder.begin(), run.batchOrder.end());
+
+            float accuracy = 0.0f;
+            for (size_t batch : run.batchOrder)
+            {
+                const size_t first = batch * config.batchSize;
+                accuracy += network.trainCPU(trainingSet.subspan(first, std::min(config.batchSize, trainingSet.size() - first)), config.learningRate);
+            }
+
+            run.result.trainAccuracy = accuracy / numBatches;
+            ++run.result.epochs;
+        }
+
+        run.result.validationAccuracy = evaluate(network);
+        run.result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    float HyperparameterSweep::evaluate(DenseNeuralNetwork& network) const
+    {
+        if (validationSet.empty())
+            return 0.0f;
+
+        PredictWorkspace workspace = network.createWorkspace();
+        size_t correct = 0;
+        for (const Sample& sample : validationSet)
+        {
+            std::span<const float> output = network.predict(sample.data.data(), workspace);
+            const size_t guess = std::distance(output.begin(), std::max_element(output.begin(), output.end()));
+            const size_t expected = std::distance(sample.label.begin(), std::max_element(sample.label.begin(), sample.label.end()));
+            if (guess == expected)
+                ++correct;
+        }
+
+        return static_cast<float>(correct) / validationSet.size();
+    }
+
+    bool HyperparameterSweep::writeResults(const std::filesystem::path& file) const
+    {
+        std::ofstream out(file);
+        if (!out.is_open())
+        {
+            std::cerr << "Could not open file for writing: " << file << std::endl;
+            return false;
+        }
+
+        out << "rank,structure,batch_size,learning_rate,optimizer,epochs,rounds,finalist,train_accuracy,validation_accuracy,seconds\n";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const SweepResult& result = results[i];
+            out << i + 1 << ',' << describeStructure(result.config.structure) << ',' << result.config.batchSize << ','
+                << result.config.learningRate << ',' << getOptimizerName(result.config.optimizer) << ',' << result.epochs << ','
+                << result.rounds << ',' << (result.finalist ? 1 : 0) << ',' << result.trainAccuracy << ','
+                << result.validationAccuracy << ',' << result.seconds << '\n';
+        }
+
+        return !out.fail();
+    }
+} // namespace NTARS
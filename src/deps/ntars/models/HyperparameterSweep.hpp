@@ -0,0 +1,94 @@
+#ifndef NTARS_HYPERPARAMETER_SWEEP_HPP
+#define NTARS_HYPERPARAMETER_SWEEP_HPP
+
+#include "ntars/models/DenseNetwork.hpp"
+#include "ntars/base/random.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace NTARS
+{
+    struct SweepConfig
+    {
+        std::vector<size_t> structure;
+        size_t batchSize{300};
+        float learningRate{1.0f};
+        OptimizerType_ optimizer{OptimizerType_SGD};
+        NeuralNetworkFlags_ flags{NeuralNetworkFlags_None};
+
+        // "784-100-50-10 b300 lr1.5 SGD"
+        std::string describe() const;
+    };
+
+    struct SweepResult
+    {
+        SweepConfig config;
+        size_t epochs{0};                // trained before it finished or was stopped
+        size_t rounds{0};                // successive halving rounds it took part in
+        bool finalist{false};            // survived every round
+        float trainAccuracy{0};          // mean over the last epoch's batches
+        float validationAccuracy{0};
+        double seconds{0};               // training and evaluation time
+    };
+
+    struct SweepOptions
+    {
+        size_t numThreads{0};            // split between the runs of a round, 0 uses every hardware thread
+        size_t epochsPerRound{1};        // budget of the first round, each later round trains eta times longer
+        size_t eta{2};                   // 1 / eta of the runs go on to the next round
+        size_t minRuns{1};               // stop halving at this many runs
+        uint64_t seed{1};
+    };
+
+    // Successive halving over DenseNeuralNetwork configurations. Every run trains on windows of the same
+    // caller-owned sample spans, so the data is never copied per run; they have to outlive run().
+    // A round trains every surviving run for its budget, min(runs, threads) runs at a time with the threads
+    // divided between them, then keeps the best 1 / eta by validation accuracy. Survivors continue from
+    // where they stopped rather than restarting.
+    class HyperparameterSweep
+    {
+    public:
+        using Sample = DATA::TrainingData<std::vector<float>>;
+
+        HyperparameterSweep(std::span<const Sample> trainingSet, std::span<const Sample> validationSet, const SweepOptions& options = {});
+
+        void add(const SweepConfig& config);
+        // Every combination of the given values
+        void addGrid(const std::vector<std::vector<size_t>>& structures, const std::vector<size_t>& batchSizes,
+            const std::vector<float>& learningRates, const std::vector<OptimizerType_>& optimizers,
+            NeuralNetworkFlags_ flags = NeuralNetworkFlags_None);
+
+        // Runs every round and returns the results, best validation accuracy first
+        const std::vector<SweepResult>& run();
+
+        inline const std::vector<SweepResult>& getResults() const { return results; }
+
+        // CSV table of the results, one row per configuration
+        bool writeResults(const std::filesystem::path& file) const;
+
+    private:
+        struct Run
+        {
+            SweepResult result;
+            std::unique_ptr<DenseNeuralNetwork> network;
+            std::vector<size_t> batchOrder;
+            Random shuffler;
+        };
+
+        void trainRun(Run& run, size_t epochs, size_t numThreads);
+        float evaluate(DenseNeuralNetwork& network) const;
+
+        std::span<const Sample> trainingSet;
+        std::span<const Sample> validationSet;
+        SweepOptions options;
+
+        std::vector<Run> runs;
+        std::vector<SweepResult> results;
+    };
+} // namespace NTARS
+
+#endif // NTARS_HYPERPARAMETER_SWEEP_HPP
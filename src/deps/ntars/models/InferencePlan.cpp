@@ -0,0 +1,390 @@
+#include "InferencePlan.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace NTARS
+{
+    template<NeuralNetworkFlags_ Activation>
+    static inline float activateScalar(float x)
+    {
+        if constexpr (Activation == NeuralNetworkFlags_ReLU)
+            return TMATH::relu(x);
+        else if constexpr (Activation == NeuralNetworkFlags_Linear)
+            return x;
+        else
+            return TMATH::sigmoid(x);
+    }
+
+#ifdef USE_SIMD
+    // ReLU stays in the register, sigmoid has no vector exp and runs over the eight values right after the store
+    template<NeuralNetworkFlags_ Activation>
+    static inline void storeActivated(float* outputs, __m256 sums)
+    {
+        if constexpr (Activation == NeuralNetworkFlags_ReLU)
+            sums = _mm256_max_ps(sums, _mm256_setzero_ps());
+
+        _mm256_storeu_ps(outputs, sums);
+
+        if constexpr (Activation == NeuralNetworkFlags_None)
+        {
+            for (size_t i = 0; i < 8; ++i)
+                outputs[i] = TMATH::sigmoid(outputs[i]);
+        }
+    }
+#endif
+
+    // weights [outputs x inputs]
+    template<NeuralNetworkFlags_ Activation>
+    static void dotKernel(const PlanStep& step, const float* inputs, float* outputs, size_t count)
+    {
+        for (size_t s = 0; s < count; ++s)
+        {
+            const float* x = inputs + s * step.inputs;
+            float* y = outputs + s * step.outputs;
+            for (size_t o = 0; o < step.outputs; ++o)
+                y[o] = activateScalar<Activation>(TMATH::dot(x, step.weights + o * step.inputs, step.inputs) + step.biases[o]);
+        }
+    }
+
+    // weights [outputs x inputs]
+    template<NeuralNetworkFlags_ Activation>
+    static void rowBlockKernel(const PlanStep& step, const float* inputs, float* outputs, size_t count)
+    {
+        const size_t numInputs = step.inputs;
+
+        for (size_t s = 0; s < count; ++s)
+        {
+            const float* x = inputs + s * numInputs;
+            float* y = outputs + s * step.outputs;
+            size_t o = 0;
+
+#ifdef USE_SIMD
+            for (; o + 4 <= step.outputs; o += 4)
+            {
+                const float* w0 = step.weights + o * numInputs;
+                const float* w1 = w0 + numInputs;
+                const float* w2 = w1 + numInputs;
+                const float* w3 = w2 + numInputs;
+
+                __m256 acc0 = _mm256_setzero_ps();
+                __m256 acc1 = _mm256_setzero_ps();
+                __m256 acc2 = _mm256_setzero_ps();
+                __m256 acc3 = _mm256_setzero_ps();
+
+                size_t i = 0;
+                for (; i + 8 <= numInputs; i += 8)
+                {
+                    const __m256 xVec = _mm256_loadu_ps(x + i);
+                    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + i), xVec, acc0);
+                    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(w1 + i), xVec, acc1);
+                    acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(w2 + i), xVec, acc2);
+                    acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(w3 + i), xVec, acc3);
+                }
+
+                float sums[4] = {TMATH::horizontalSum(acc0), TMATH::horizontalSum(acc1), TMATH::horizontalSum(acc2), TMATH::horizontalSum(acc3)};
+                for (; i < numInputs; ++i)
+                {
+                    sums[0] += w0[i] * x[i];
+                    sums[1] += w1[i] * x[i];
+                    sums[2] += w2[i] * x[i];
+                    sums[3] += w3[i] * x[i];
+                }
+
+                for (size_t r = 0; r < 4; ++r)
+                    y[o + r] = activateScalar<Activation>(sums[r] + step.biases[o + r]);
+            }
+#endif
+
+            for (; o < step.outputs; ++o)
+                y[o] = activateScalar<Activation>(TMATH::dot(x, step.weights + o * numInputs, numInputs) + step.biases[o]);
+        }
+    }
+
+#ifdef USE_SIMD
+    // Rows samples by Panels panels of eight outputs, the accumulators stay in registers over the whole input loop
+    // and every weight load feeds Rows FMAs
+    template<NeuralNetworkFlags_ Activation, size_t Rows, size_t Panels>
+    static inline void gemmBlock(const PlanStep& step, const float* inputs, float* outputs, size_t panel)
+    {
+        const size_t numInputs = step.inputs;
+        const size_t numOutputs = step.outputs;
+        const float* weights = step.weights + panel * numInputs * 8;
+
+        __m256 acc[Rows][Panels];
+        for (size_t q = 0; q < Panels; ++q)
+        {
+            const __m256 bias = _mm256_loadu_ps(step.biases + (panel + q) * 8);
+            for (size_t r = 0; r < Rows; ++r)
+                acc[r][q] = bias;
+        }
+
+        for (size_t p = 0; p < numInputs; ++p)
+        {
+            __m256 w[Panels];
+            for (size_t q = 0; q < Panels; ++q)
+                w[q] = _mm256_loadu_ps(weights + q * numInputs * 8 + p * 8);
+
+            for (size_t r = 0; r < Rows; ++r)
+            {
+                const __m256 x = _mm256_set1_ps(inputs[r * numInputs + p]);
+                for (size_t q = 0; q < Panels; ++q)
+                    acc[r][q] = _mm256_fmadd_ps(x, w[q], acc[r][q]);
+            }
+        }
+
+        for (size_t r = 0; r < Rows; ++r)
+        {
+            for (size_t q = 0; q < Panels; ++q)
+            {
+                const size_t column = (panel + q) * 8;
+                if (column + 8 <= numOutputs)
+                {
+                    storeActivated<Activation>(outputs + r * numOutputs + column, acc[r][q]);
+                    continue;
+                }
+
+                // the last panel is zero padded past the real outputs
+                alignas(32) float tail[8];
+                storeActivated<Activation>(tail, acc[r][q]);
+                std::copy_n(tail, numOutputs - column, outputs + r * numOutputs + column);
+            }
+        }
+    }
+#endif
+
+    // weights packed in panels of eight outputs, [panel][input][8], zero padded to whole panels like the biases.
+    // Panels are the outer loop, a panel is read from memory once and stays in cache while every sample passes over it
+    template<NeuralNetworkFlags_ Activation>
+    static void gemmKernel(const PlanStep& step, const float* inputs, float* outputs, size_t count)
+    {
+        const size_t numInputs = step.inputs;
+        const size_t numOutputs = step.outputs;
+
+#ifdef USE_SIMD
+        const size_t panels = (numOutputs + 7) / 8;
+        size_t panel = 0;
+        for (; panel + 2 <= panels; panel += 2)
+        {
+            size_t s = 0;
+            for (; s + 4 <= count; s += 4)
+                gemmBlock<Activation, 4, 2>(step, inputs + s * numInputs, outputs + s * numOutputs, panel);
+            for (; s < count; ++s)
+                gemmBlock<Activation, 1, 2>(step, inputs + s * numInputs, outputs + s * numOutputs, panel);
+        }
+
+        for (; panel < panels; ++panel)
+        {
+            size_t s = 0;
+            for (; s + 4 <= count; s += 4)
+                gemmBlock<Activation, 4, 1>(step, inputs + s * numInputs, outputs + s * numOutputs, panel);
+            for (; s < count; ++s)
+                gemmBlock<Activation, 1, 1>(step, inputs + s * numInputs, outputs + s * numOutputs, panel);
+        }
+#else
+        for (size_t s = 0; s < count; ++s)
+        {
+            const float* x = inputs + s * numInputs;
+            for (size_t o = 0; o < numOutputs; ++o)
+            {
+                const float* column = step.weights + (o / 8) * numInputs * 8 + o % 8;
+                float sum = step.biases[o];
+                for (size_t p = 0; p < numInputs; ++p)
+                    sum += x[p] * column[p * 8];
+
+                outputs[s * numOutputs + o] = activateScalar<Activation>(sum);
+            }
+        }
+#endif
+    }
+
+    InferencePlan::InferencePlan(const DenseNeuralNetwork& network, size_t batchSize, bool sparseInput)
+        : batchSize(std::max<size_t>(batchSize, 1))
+    {
+        const std::vector<size_t> structure = network.getStructure();
+        const std::shared_ptr<const WeightSnapshot> snapshot = network.getSnapshot();
+        if (structure.size() < 2 || !snapshot)
+            return;
+
+        // parameters only grow while packing, the steps get their pointers once it is done
+        std::vector<size_t> offsets;
+        for (size_t l = 0; l + 1 < structure.size(); ++l)
+        {
+            PlanStep step;
+            step.inputs = structure[l];
+            step.outputs = structure[l + 1];
+            step.activation = network.getLayers()[l].getActivation();
+            step.kernelType = chooseKernel(step.inputs, step.outputs, this->batchSize);
+            step.kernel = bindKernel(step.kernelType, step.activation);
+
+            const float* weights = snapshot->weights[l];
+            const float* biases = snapshot->biases[l];
+            offsets.push_back(parameters.size());
+
+            if (step.kernelType == PlanKernel_Gemm)
+            {
+                const size_t paddedOutputs = (step.outputs + 7) / 8 * 8;
+                const size_t start = parameters.size();
+                parameters.resize(start + paddedOutputs * (step.inputs + 1), 0.0f);
+
+                float* packed = parameters.data() + start;
+                for (size_t o = 0; o < step.outputs; ++o)
+                {
+                    float* column = packed + (o / 8) * step.inputs * 8 + o % 8;
+                    for (size_t i = 0; i < step.inputs; ++i)
+                        column[i * 8] = weights[o * step.inputs + i];
+                }
+                std::copy_n(biases, step.outputs, packed + paddedOutputs * step.inputs);
+            }
+            else
+            {
+                parameters.insert(parameters.end(), weights, weights + step.outputs * step.inputs);
+                parameters.insert(parameters.end(), biases, biases + step.outputs);
+            }
+
+            widest = std::max(widest, step.outputs);
+            steps.push_back(step);
+        }
+
+        for (size_t l = 0; l < steps.size(); ++l)
+        {
+            const size_t paddedOutputs = steps[l].kernelType == PlanKernel_Gemm ? (steps[l].outputs + 7) / 8 * 8 : steps[l].outputs;
+            steps[l].weights = parameters.data() + offsets[l];
+            steps[l].biases = steps[l].weights + paddedOutputs * steps[l].inputs;
+        }
+
+        if (sparseInput)
+        {
+            sparseLayer = SparseDenseLayer{structure[1], structure[0], steps.front().activation};
+            sparseColumns.resize(structure[0] * structure[1]);
+            sparseLayer.packColumns(snapshot->weights[0], sparseColumns.data());
+        }
+    }
+
+    PlanKernel_ InferencePlan::chooseKernel(size_t inputs, size_t outputs, size_t batchSize)
+    {
+        // the register blocks need four samples and eight outputs, or four outputs and a full vector of inputs
+        if (batchSize >= 4 && outputs >= 8)
+            return PlanKernel_Gemm;
+        if (inputs >= 8 && outputs >= 4)
+            return PlanKernel_RowBlock;
+        return PlanKernel_Dot;
+    }
+
+    PlanStep::Kernel InferencePlan::bindKernel(PlanKernel_ kernel, NeuralNetworkFlags_ activation)
+    {
+        switch (kernel)
+        {
+        case PlanKernel_Gemm:
+            if (activation == NeuralNetworkFlags_ReLU)
+                return gemmKernel<NeuralNetworkFlags_ReLU>;
+            return activation == NeuralNetworkFlags_Linear ? gemmKernel<NeuralNetworkFlags_Linear> : gemmKernel<NeuralNetworkFlags_None>;
+        case PlanKernel_RowBlock:
+            if (activation == NeuralNetworkFlags_ReLU)
+                return rowBlockKernel<NeuralNetworkFlags_ReLU>;
+            return activation == NeuralNetworkFlags_Linear ? rowBlockKernel<NeuralNetworkFlags_Linear> : rowBlockKernel<NeuralNetworkFlags_None>;
+        case PlanKernel_Dot:
+            break;
+        }
+
+        if (activation == NeuralNetworkFlags_ReLU)
+            return dotKernel<NeuralNetworkFlags_ReLU>;
+        return activation == NeuralNetworkFlags_Linear ? dotKernel<NeuralNetworkFlags_Linear> : dotKernel<NeuralNetworkFlags_None>;
+    }
+
+    PredictWorkspace InferencePlan::createWorkspace() const
+    {
+        return PredictWorkspace{std::vector<float>(widest * batchSize), std::vector<float>(widest * batchSize), {}};
+    }
+
+    void InferencePlan::reserve(PredictWorkspace& workspace, size_t count) const
+    {
+        if (workspace.front.size() < widest * count)
+            workspace.front.resize(widest * count);
+        if (workspace.back.size() < widest * count)
+            workspace.back.resize(widest * count);
+    }
+
+    void InferencePlan::run(const float* inputs, size_t count, float* outputs, PredictWorkspace& workspace, size_t firstStep) const
+    {
+        reserve(workspace, count);
+
+        float* buffers[2] = {workspace.front.data(), workspace.back.data()};
+        const float* current = firstStep == 0 ? inputs : buffers[(firstStep - 1) % 2];
+
+        for (size_t l = firstStep; l < steps.size(); ++l)
+        {
+            float* layerOutputs = (outputs && l == steps.size() - 1) ? outputs : buffers[l % 2];
+            steps[l].kernel(steps[l], current, layerOutputs, count);
+            current = layerOutputs;
+        }
+    }
+
+    std::span<const float> InferencePlan::predict(const float* inputs, PredictWorkspace& workspace) const
+    {
+        if (steps.empty())
+            return {};
+
+        run(inputs, 1, nullptr, workspace);
+
+        const float* result = ((steps.size() - 1) % 2 == 0) ? workspace.front.data() : workspace.back.data();
+        return std::span<const float>(result, getNumOutputs());
+    }
+
+    void InferencePlan::predictBatch(const float* inputs, size_t count, float* outputs, PredictWorkspace& workspace) const
+    {
+        if (!steps.empty() && count > 0)
+            run(inputs, count, outputs, workspace);
+    }
+
+    std::span<const float> InferencePlan::predictSparse(std::span<const uint32_t> features, PredictWorkspace& workspace) const
+    {
+        if (!hasSparseInput())
+            return {};
+
+        const uint32_t offsets[2] = {0, static_cast<uint32_t>(features.size())};
+
+        predictSparseBatch(features.data(), offsets, 1, nullptr, workspace);
+
+        const float* result = ((steps.size() - 1) % 2 == 0) ? workspace.front.data() : workspace.back.data();
+        return std::span<const float>(result, getNumOutputs());
+    }
+
+    void InferencePlan::predictSparseBatch(const uint32_t* features, const uint32_t* offsets, size_t count, float* outputs, PredictWorkspace& workspace) const
+    {
+        if (!hasSparseInput() || count == 0)
+            return;
+
+        reserve(workspace, count);
+
+        // the first layer writes where its dense step would have, so the plan carries on from the second step
+        const size_t numOutputs = sparseLayer.getNumOutputs();
+        float* firstOutputs = (outputs && steps.size() == 1) ? outputs : workspace.front.data();
+        for (size_t s = 0; s < count; ++s)
+        {
+            sparseLayer.forward(features + offsets[s], offsets[s + 1] - offsets[s], sparseColumns.data(), steps.front().biases,
+                firstOutputs + s * numOutputs);
+        }
+
+        run(nullptr, count, outputs, workspace, 1);
+    }
+
+    std::string InferencePlan::describe() const
+    {
+        static const char* kernelNames[] = {"dot", "row block", "gemm"};
+
+        std::ostringstream text;
+        if (hasSparseInput())
+            text << "sparse input: " << sparseLayer.getNumInputs() << " -> " << sparseLayer.getNumOutputs() << ", a column per active feature" << std::endl;
+
+        for (size_t l = 0; l < steps.size(); ++l)
+        {
+            const PlanStep& step = steps[l];
+            const char* activation = step.activation == NeuralNetworkFlags_ReLU ? "relu" : step.activation == NeuralNetworkFlags_Linear ? "linear" : "sigmoid";
+            text << "layer " << l << ": " << step.inputs << " -> " << step.outputs << ", " << kernelNames[step.kernelType]
+                 << " + bias + " << activation << ", writes " << (l == steps.size() - 1 ? "outputs" : (l % 2 == 0 ? "front" : "back")) << std::endl;
+        }
+
+        return text.str();
+    }
+} // namespace NTARS
@@ -0,0 +1,84 @@
+#ifndef NTARS_INFERENCE_PLAN_HPP
+#define NTARS_INFERENCE_PLAN_HPP
+
+#include "ntars/models/DenseNetwork.hpp"
+#include "ntars/layers/sparse_dense_layer.hpp"
+
+#include <span>
+#include <string>
+#include <vector>
+
+namespace NTARS
+{
+    enum PlanKernel_ : uint32_t
+    {
+        PlanKernel_Dot = 0,     // one dot product per output, for layers too narrow to block
+        PlanKernel_RowBlock,    // four weight rows per pass over a sample, every input load feeds four FMAs
+        PlanKernel_Gemm,        // batches, weights packed in panels of eight outputs, four samples by sixteen outputs stay in registers
+    };
+
+    // One layer of a plan, outputs = activation(W * inputs + b). Bias and activation are applied by the kernel
+    // while the sums are still in registers, nothing is written before it is final
+    struct PlanStep
+    {
+        using Kernel = void (*)(const PlanStep& step, const float* inputs, float* outputs, size_t count);
+
+        Kernel kernel{nullptr};
+        PlanKernel_ kernelType{PlanKernel_Dot};
+        NeuralNetworkFlags_ activation{NeuralNetworkFlags_None};
+        size_t inputs{0};
+        size_t outputs{0};
+        const float* weights{nullptr};  // into the plan's parameters, in the layout the kernel reads
+        const float* biases{nullptr};
+    };
+
+    // Execution plan compiled once from a trained DenseNeuralNetwork for a given batch size. Every layer gets the
+    // kernel that suits its shape, bound when the plan is built, and its parameters packed for that kernel.
+    // Layers alternate between the two workspace buffers, so only two activations are ever live.
+    // The plan holds its own copy of the parameters and does not follow later training of the network.
+    // Networks whose inputs are one-hot features can also be compiled with a sparse input, which computes the first
+    // layer from the indices of the active features only
+    class InferencePlan
+    {
+    public:
+        explicit InferencePlan(const DenseNeuralNetwork& network, size_t batchSize = 1, bool sparseInput = false);
+
+        PredictWorkspace createWorkspace() const;
+        std::span<const float> predict(const float* inputs, PredictWorkspace& workspace) const;
+        // inputs and outputs hold count samples row after row, any count works but the kernels were picked for batchSize
+        void predictBatch(const float* inputs, size_t count, float* outputs, PredictWorkspace& workspace) const;
+
+        // Sparse input plans only, features are indices of the inputs that are 1, every other input is 0
+        std::span<const float> predictSparse(std::span<const uint32_t> features, PredictWorkspace& workspace) const;
+        // The features of sample s are features[offsets[s]] up to features[offsets[s + 1]]
+        void predictSparseBatch(const uint32_t* features, const uint32_t* offsets, size_t count, float* outputs, PredictWorkspace& workspace) const;
+
+        // One line per layer with its shape, kernel and activation
+        std::string describe() const;
+
+        inline const std::vector<PlanStep>& getSteps() const { return steps; }
+        inline size_t getBatchSize() const { return batchSize; }
+        inline bool hasSparseInput() const { return !sparseColumns.empty(); }
+        inline size_t getNumInputs() const { return steps.empty() ? 0 : steps.front().inputs; }
+        inline size_t getNumOutputs() const { return steps.empty() ? 0 : steps.back().outputs; }
+
+    private:
+        static PlanKernel_ chooseKernel(size_t inputs, size_t outputs, size_t batchSize);
+        static PlanStep::Kernel bindKernel(PlanKernel_ kernel, NeuralNetworkFlags_ activation);
+
+        void reserve(PredictWorkspace& workspace, size_t count) const;
+        // Runs the steps from firstStep on, whose inputs are in the buffer the step before it wrote to
+        void run(const float* inputs, size_t count, float* outputs, PredictWorkspace& workspace, size_t firstStep = 0) const;
+
+        size_t batchSize;
+        size_t widest{0};   // of every layer output, so predict() can leave its result in the workspace
+        std::vector<PlanStep> steps;
+        std::vector<float> parameters;
+
+        // first layer by column for sparse inputs, its biases are those of the first step
+        SparseDenseLayer sparseLayer{0, 0};
+        std::vector<float> sparseColumns;
+    };
+} // namespace NTARS
+
+#endif // NTARS_INFERENCE_PLAN_HPP
@@ -0,0 +1,161 @@
+#include "InferenceService.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace NTARS
+{
+    InferenceService::InferenceService(const DenseNeuralNetwork& network, size_t maxBatchSize, std::chrono::microseconds maxDelay)
+        : network(network), maxBatchSize(std::max<size_t>(1, maxBatchSize)), maxDelay(maxDelay), statsStart(Clock::now())
+    {
+        latencies.reserve(latencyWindow);
+        worker = std::thread([this]() { workerLoop(); });
+    }
+
+    InferenceService::~InferenceService()
+    {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueCondition.notify_all();
+
+        if (worker.joinable())
+            worker.join();
+    }
+
+    std::future<std::vector<float>> InferenceService::submit(std::vector<float> inputs)
+    {
+        Request request{std::move(inputs), {}, Clock::now()};
+        std::future<std::vector<float>> result = request.promise.get_future();
+
+        // a request of the wrong size would run past its row of the batch, it fails on its own instead
+        if (request.inputs.size() != network.getStructure().front())
+        {
+            request.promise.set_exception(std::make_exception_ptr(std::invalid_argument(
+                "Input size " + std::to_string(request.inputs.size()) + " does not match the network's " + std::to_string(network.getStructure().front()))));
+            return result;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queue.push_back(std::move(request));
+        }
+        queueCondition.notify_one();
+
+        return result;
+    }
+
+    void InferenceService::workerLoop()
+    {
+        const std::vector<size_t> structure = network.getStructure();
+        const size_t numInputs = structure.front();
+        const size_t numOutputs = structure.back();
+
+        PredictWorkspace workspace = network.createWorkspace();
+        std::vector<float> batchInputs(maxBatchSize * numInputs);
+        std::vector<float> batchOutputs(maxBatchSize * numOutputs);
+        std::vector<Request> batch;
+        batch.reserve(maxBatchSize);
+
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueCondition.wait(lock, [&]() { return stopping || !queue.empty(); });
+
+                if (queue.empty())
+                    return;
+
+                // hold the batch open until it fills up or the oldest request hits its deadline
+                const Clock::time_point deadline = queue.front().submitted + maxDelay;
+                queueCondition.wait_until(lock, deadline, [&]() { return stopping || queue.size() >= maxBatchSize; });
+
+                const size_t count = std::min(maxBatchSize, queue.size());
+                for (size_t i = 0; i < count; ++i)
+                {
+                    batch.push_back(std::move(queue.front()));
+                    queue.pop_front();
+                }
+            }
+
+            for (size_t i = 0; i < batch.size(); ++i)
+                std::copy(batch[i].inputs.begin(), batch[i].inputs.end(), batchInputs.begin() + i * numInputs);
+
+            // each batch runs on whatever weights were last published, so serving never waits on training
+            std::shared_ptr<const WeightSnapshot> snapshot = network.getSnapshot();
+            network.predictBatch(batchInputs.data(), batch.size(), batchOutputs.data(), workspace, *snapshot);
+
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                const float* output = batchOutputs.data() + i * numOutputs;
+                batch[i].promise.set_value(std::vector<float>(output, output + numOutputs));
+            }
+
+            recordBatch(batch, Clock::now());
+            batch.clear();
+        }
+    }
+
+    void InferenceService::recordBatch(const std::vector<Request>& batch, Clock::time_point finished)
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+
+        for (const auto& request : batch)
+        {
+            const float latency = std::chrono::duration<float, std::micro>(finished - request.submitted).count();
+
+            if (latencies.size() < latencyWindow)
+                latencies.push_back(latency);
+            else
+                latencies[latencyCursor] = latency;
+
+            latencyCursor = (latencyCursor + 1) % latencyWindow;
+        }
+
+        completedRequests += batch.size();
+        ++completedBatches;
+    }
+
+    InferenceServiceStats InferenceService::getStats() const
+    {
+        std::vector<float> sorted;
+        InferenceServiceStats stats;
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            sorted = latencies;
+            stats.requests = completedRequests;
+            stats.batches = completedBatches;
+
+            const float elapsed = std::chrono::duration<float>(Clock::now() - statsStart).count();
+            stats.throughput = elapsed > 0.0f ? completedRequests / elapsed : 0.0f;
+        }
+
+        stats.meanBatchSize = stats.batches > 0 ? static_cast<float>(stats.requests) / stats.batches : 0.0f;
+
+        if (!sorted.empty())
+        {
+            auto percentile = [&](float p) {
+                auto nth = sorted.begin() + static_cast<size_t>(p * (sorted.size() - 1));
+                std::nth_element(sorted.begin(), nth, sorted.end());
+                return *nth;
+            };
+
+            stats.p50LatencyUs = percentile(0.50f);
+            stats.p99LatencyUs = percentile(0.99f);
+        }
+
+        return stats;
+    }
+
+    void InferenceService::resetStats()
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        latencies.clear();
+        latencyCursor = 0;
+        completedRequests = 0;
+        completedBatches = 0;
+        statsStart = Clock::now();
+    }
+} // namespace NTARS
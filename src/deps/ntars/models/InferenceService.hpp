@@ -0,0 +1,80 @@
+#ifndef NTARS_INFERENCE_SERVICE_HPP
+#define NTARS_INFERENCE_SERVICE_HPP
+
+#include "ntars/models/DenseNetwork.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NTARS
+{
+    struct InferenceServiceStats
+    {
+        size_t requests{0};
+        size_t batches{0};
+        float meanBatchSize{0};
+
+        float p50LatencyUs{0};
+        float p99LatencyUs{0};
+        float throughput{0}; // requests per second since the last reset
+    };
+
+    // Coalesces single-input requests from many callers into batches for DenseNeuralNetwork::predictBatch.
+    // A batch is dispatched once it is full or its oldest request has waited maxDelay.
+    class InferenceService
+    {
+    public:
+        InferenceService(const DenseNeuralNetwork& network, size_t maxBatchSize = 32, std::chrono::microseconds maxDelay = std::chrono::microseconds(200));
+        ~InferenceService();
+
+        InferenceService(const InferenceService&) = delete;
+        InferenceService& operator=(const InferenceService&) = delete;
+
+        // The outputs for one input, or a std::invalid_argument in the future when the input is not the network's size
+        std::future<std::vector<float>> submit(std::vector<float> inputs);
+
+        InferenceServiceStats getStats() const;
+        void resetStats();
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Request
+        {
+            std::vector<float> inputs;
+            std::promise<std::vector<float>> promise;
+            Clock::time_point submitted;
+        };
+
+        void workerLoop();
+        void recordBatch(const std::vector<Request>& batch, Clock::time_point finished);
+
+        const DenseNeuralNetwork& network;
+        const size_t maxBatchSize;
+        const std::chrono::microseconds maxDelay;
+
+        std::mutex queueMutex;
+        std::condition_variable queueCondition;
+        std::deque<Request> queue;
+        bool stopping{false};
+
+        // Latencies of the most recent requests, in microseconds
+        static constexpr size_t latencyWindow = 8192;
+
+        mutable std::mutex statsMutex;
+        std::vector<float> latencies;
+        size_t latencyCursor{0};
+        size_t completedRequests{0};
+        size_t completedBatches{0};
+        Clock::time_point statsStart;
+
+        std::thread worker;
+    };
+} // namespace NTARS
+
+#endif // NTARS_INFERENCE_SERVICE_HPP
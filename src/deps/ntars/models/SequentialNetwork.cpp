@@ -0,0 +1,728 @@
+#include "SequentialNetwork.hpp"
+
+#include "ntars/base/random.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace NTARS
+{
+    SequentialNetwork::SequentialNetwork(TensorShape inputShape, const std::string& name)
+        : name(name), inputShape(inputShape)
+    {
+    }
+
+    SequentialNetwork::SequentialNetwork(const std::string& file)
+    {
+        // anything without a layer graph is a DenseNeuralNetwork model, which also takes care of JSON imports
+        const std::filesystem::path inputPath = std::filesystem::current_path() / "networks" / file;
+
+        FORMAT::ModelReader reader;
+        if (inputPath.extension() == ".tars" && std::filesystem::exists(inputPath) && reader.open(inputPath) &&
+            reader.findTensor(FORMAT::TensorKind_LayerGraph, 0))
+        {
+            if (loadGraph(reader))
+                std::cout << "Network loaded successfully: " << inputPath.string() << std::endl;
+            else
+                std::cerr << "Model file has missing or mismatched layers: " << inputPath.string() << std::endl;
+
+            return;
+        }
+
+        loadDense(DenseNeuralNetwork{file});
+    }
+
+    SequentialNetwork::SequentialNetwork(const DenseNeuralNetwork& network)
+    {
+        loadDense(network);
+    }
+
+    bool SequentialNetwork::loadGraph(const FORMAT::ModelReader& reader)
+    {
+        const FORMAT::TensorEntry* graphEntry = reader.findTensor(FORMAT::TensorKind_LayerGraph, 0);
+        const size_t graphBytes = graphEntry->cols * sizeof(float);
+        if (graphBytes < sizeof(FORMAT::LayerGraphHeader))
+            return false;
+
+        FORMAT::LayerGraphHeader header;
+        std::memcpy(&header, reader.blobData(*graphEntry), sizeof(header));
+        if (graphBytes < sizeof(header) + header.numLayers * sizeof(LayerRecord))
+            return false;
+
+        name = reader.getName();
+        inputShape = {header.channels, header.height, header.width};
+        layers.clear();
+
+        for (uint32_t l = 0; l < header.numLayers; ++l)
+        {
+            LayerRecord record;
+            std::memcpy(&record, reader.blobData(*graphEntry) + sizeof(header) + l * sizeof(LayerRecord), sizeof(record));
+            if (!addLayer(record))
+                return false;
+
+            if (layers.back()->getWeightRows() == 0)
+                continue;
+
+            const FORMAT::TensorEntry* weightEntry = reader.findTensor(FORMAT::TensorKind_Weights, l);
+            const FORMAT::TensorEntry* biasEntry = reader.findTensor(FORMAT::TensorKind_Biases, l);
+            if (!weightEntry || !biasEntry ||
+                weightEntry->rows != weights[l].rows() || weightEntry->cols != weights[l].cols() || biasEntry->rows != biases[l].rows())
+            {
+                return false;
+            }
+
+            std::copy_n(reader.tensorData(*weightEntry), weights[l].size(), weights[l].data());
+            std::copy_n(reader.tensorData(*biasEntry), biases[l].size(), biases[l].data());
+
+            const size_t stateSize = layers.back()->getStateSize();
+            if (stateSize == 0)
+                continue;
+
+            const FORMAT::TensorEntry* stateEntry = reader.findTensor(FORMAT::TensorKind_LayerState, l);
+            if (!stateEntry || stateEntry->cols != stateSize)
+                return false;
+
+            std::copy_n(reader.tensorData(*stateEntry), stateSize, layers.back()->getState());
+        }
+
+        return true;
+    }
+
+    void SequentialNetwork::loadDense(const DenseNeuralNetwork& network)
+    {
+        const std::vector<size_t> structure = network.getStructure();
+        const std::shared_ptr<const WeightSnapshot> snapshot = network.getSnapshot();
+
+        name = network.getName();
+        inputShape = {structure.empty() ? 0 : structure.front(), 1, 1};
+        layers.clear();
+
+        for (size_t l = 0; l + 1 < structure.size(); ++l)
+        {
+            addDense(structure[l + 1], network.getLayers()[l].usesReLU() ? NeuralNetworkFlags_ReLU : NeuralNetworkFlags_None);
+            std::copy_n(snapshot->weights[l], weights[l].size(), weights[l].data());
+            std::copy_n(snapshot->biases[l], biases[l].size(), biases[l].data());
+        }
+    }
+
+    std::unique_ptr<Layer> SequentialNetwork::createLayer(const LayerRecord& record, TensorShape inputShape)
+    {
+        const NeuralNetworkFlags_ flags = static_cast<NeuralNetworkFlags_>(record.flags);
+
+        switch (record.type)
+        {
+        case LayerType_Dense:
+            return std::make_unique<DenseLayer>(record.outputs, inputShape.size(), flags);
+        case LayerType_Conv2D:
+            return std::make_unique<Conv2DLayer>(inputShape, record.outputs, record.kernel, record.stride, record.padding, flags);
+        case LayerType_MaxPool2D:
+            return std::make_unique<MaxPool2DLayer>(inputShape, record.kernel, record.stride);
+        case LayerType_Flatten:
+            return std::make_unique<FlattenLayer>(inputShape);
+        case LayerType_BatchNorm:
+            return std::make_unique<BatchNormLayer>(inputShape, flags);
+        }
+
+        std::cerr << "Unknown layer type " << record.type << std::endl;
+        return nullptr;
+    }
+
+    bool SequentialNetwork::addLayer(const LayerRecord& record)
+    {
+        std::unique_ptr<Layer> layer = createLayer(record, getOutputShape());
+        if (!layer)
+            return false;
+
+        addLayer(std::move(layer));
+        return true;
+    }
+
+    template<typename L>
+    L& SequentialNetwork::addLayer(std::unique_ptr<L> layer)
+    {
+        const size_t rows = layer->getWeightRows();
+        const size_t cols = layer->getWeightCols();
+        const float scale = rows ? std::sqrt(2.0 / (rows + cols)) : 0.0f;
+
+        TMATH::Matrix_t<float> weightMatrix(rows, cols);
+        threadRandom().fillNormal(weightMatrix.data(), weightMatrix.size(), 0.0f, scale);
+
+        TMATH::Matrix_t<float> biasMatrix(std::vector<float>(rows, 0.1f), rows, 1);
+        layer->initializeParameters(weightMatrix.data(), biasMatrix.data());
+
+        weights.push_back(std::move(weightMatrix));
+        biases.push_back(std::move(biasMatrix));
+
+        L& added = *layer;
+        layers.push_back(std::move(layer));
+        initializeTrainingBuffers();
+
+        return added;
+    }
+
+    Conv2DLayer& SequentialNetwork::addConv2D(size_t filters, size_t kernel, size_t stride, size_t padding, NeuralNetworkFlags_ flags)
+    {
+        return addLayer(std::make_unique<Conv2DLayer>(getOutputShape(), filters, kernel, stride, padding, flags));
+    }
+
+    MaxPool2DLayer& SequentialNetwork::addMaxPool2D(size_t size, size_t stride)
+    {
+        return addLayer(std::make_unique<MaxPool2DLayer>(getOutputShape(), size, stride));
+    }
+
+    FlattenLayer& SequentialNetwork::addFlatten()
+    {
+        return addLayer(std::make_unique<FlattenLayer>(getOutputShape()));
+    }
+
+    DenseLayer& SequentialNetwork::addDense(size_t outputs, NeuralNetworkFlags_ flags)
+    {
+        return addLayer(std::make_unique<DenseLayer>(outputs, getOutputShape().size(), flags));
+    }
+
+    BatchNormLayer& SequentialNetwork::addBatchNorm(NeuralNetworkFlags_ flags)
+    {
+        return addLayer(std::make_unique<BatchNormLayer>(getOutputShape(), flags));
+    }
+
+    size_t SequentialNetwork::fold()
+    {
+        size_t folded = 0;
+        for (size_t l = 1; l < layers.size(); ++l)
+        {
+            if (layers[l]->getType() != LayerType_BatchNorm)
+                continue;
+
+            Layer& previous = *layers[l - 1];
+            const LayerRecord previousRecord = previous.getRecord();
+            if ((previousRecord.type != LayerType_Dense && previousRecord.type != LayerType_Conv2D) ||
+                Layer::getActivation(static_cast<NeuralNetworkFlags_>(previousRecord.flags)) != NeuralNetworkFlags_Linear)
+            {
+                continue;
+            }
+
+            const BatchNormLayer& norm = static_cast<const BatchNormLayer&>(*layers[l]);
+            const size_t rows = weights[l - 1].rows();
+            const size_t cols = weights[l - 1].cols();
+
+            // y = gamma * (Wx + b - mean) / sqrt(variance + eps) + beta, row by row
+            for (size_t r = 0; r < rows; ++r)
+            {
+                const float scale = weights[l][r] / std::sqrt(norm.runningVariance()[r] + norm.getEpsilon());
+                float* row = weights[l - 1].data() + r * cols;
+                for (size_t c = 0; c < cols; ++c)
+                    row[c] *= scale;
+
+                biases[l - 1][r] = (biases[l - 1][r] - norm.runningMean()[r]) * scale + biases[l][r];
+            }
+
+            LayerRecord record = previousRecord;
+            record.flags = static_cast<uint32_t>(norm.getActivation());
+            layers[l - 1] = createLayer(record, previous.getInputShape());
+
+            layers.erase(layers.begin() + l);
+            weights.erase(weights.begin() + l);
+            biases.erase(biases.begin() + l);
+            --l;
+            ++folded;
+        }
+
+        if (folded)
+            initializeTrainingBuffers();
+
+        return folded;
+    }
+
+    void SequentialNetwork::initializeTrainingBuffers()
+    {
+        weightGradients.clear();
+        biasGradients.clear();
+        for (size_t l = 0; l < layers.size(); ++l)
+        {
+            weightGradients.emplace_back(weights[l].rows(), weights[l].cols());
+            biasGradients.emplace_back(biases[l].rows(), 1);
+        }
+
+        const size_t stateCount = optimizer->getStateCount();
+        weightOptimizerState.assign(layers.size(), {});
+        biasOptimizerState.assign(layers.size(), {});
+        for (size_t l = 0; l < layers.size(); ++l)
+        {
+            for (size_t s = 0; s < stateCount; ++s)
+            {
+                weightOptimizerState[l].emplace_back(weights[l].rows(), weights[l].cols());
+                biasOptimizerState[l].emplace_back(biases[l].rows(), 1);
+            }
+        }
+
+        threadBuffers.clear();
+    }
+
+    void SequentialNetwork::setOptimizer(std::unique_ptr<Optimizer> newOptimizer)
+    {
+        optimizer = newOptimizer ? std::move(newOptimizer) : std::make_unique<SGDOptimizer>();
+        initializeTrainingBuffers();
+    }
+
+    void SequentialNetwork::setThreadCount(size_t numThreads)
+    {
+        threadPool = std::make_unique<ThreadPool>(numThreads);
+        threadBuffers.clear();
+    }
+
+    size_t SequentialNetwork::getParameterCount() const
+    {
+        size_t count = 0;
+        for (const auto& layer : layers)
+            count += layer->getParameterCount();
+
+        return count;
+    }
+
+    double SequentialNetwork::getForwardFlops() const
+    {
+        double flops = 0.0;
+        for (const auto& layer : layers)
+            flops += layer->getForwardFlops();
+
+        return flops;
+    }
+
+    void SequentialNetwork::getBufferSizes(size_t& widest, size_t& scratch) const
+    {
+        widest = inputShape.size();
+        scratch = 0;
+        for (const auto& layer : layers)
+        {
+            widest = std::max(widest, layer->getOutputShape().size());
+            scratch = std::max(scratch, layer->getScratchSize());
+        }
+    }
+
+    PredictWorkspace SequentialNetwork::createWorkspace() const
+    {
+        size_t widest, scratch;
+        getBufferSizes(widest, scratch);
+
+        return PredictWorkspace{std::vector<float>(widest), std::vector<float>(widest), std::vector<float>(scratch)};
+    }
+
+    std::span<const float> SequentialNetwork::predict(const float* inputs, PredictWorkspace& workspace) const
+    {
+        if (layers.empty())
+            return std::span<const float>(inputs, inputShape.size());
+
+        // a workspace from createWorkspace() is already large enough, only a foreign one is grown
+        size_t widest, scratch;
+        getBufferSizes(widest, scratch);
+        if (workspace.front.size() < widest)
+            workspace.front.resize(widest);
+        if (workspace.back.size() < widest)
+            workspace.back.resize(widest);
+        if (workspace.scratch.size() < scratch)
+            workspace.scratch.resize(scratch);
+
+        const float* currentInputs = inputs;
+        float* outputs = workspace.front.data();
+        float* spare = workspace.back.data();
+
+        for (size_t l = 0; l < layers.size(); ++l)
+        {
+            layers[l]->forward(currentInputs, weights[l].data(), biases[l].data(), outputs, 1, workspace.scratch.data());
+            currentInputs = outputs;
+            std::swap(outputs, spare);
+        }
+
+        return std::span<const float>(currentInputs, getOutputShape().size());
+    }
+
+    void SequentialNetwork::prepareThreadBuffers(size_t numThreads, size_t batchSize)
+    {
+        if (threadBuffers.size() < numThreads)
+            threadBuffers.resize(numThreads);
+
+        size_t widest, scratch;
+        getBufferSizes(widest, scratch);
+
+        // only ever grows, so steady state steps allocate nothing
+        auto reserve = [](std::vector<float>& buffer, size_t size) {
+            if (buffer.size() < size)
+                buffer.resize(size);
+        };
+
+        for (auto& buffers : threadBuffers)
+        {
+            reserve(buffers.input, batchSize * inputShape.size());
+            reserve(buffers.delta, batchSize * widest);
+            reserve(buffers.prevDelta, batchSize * widest);
+            reserve(buffers.scratch, scratch);
+
+            buffers.statistics.resize(layers.size());
+            buffers.deltaStatistics.resize(layers.size());
+            for (size_t l = 0; l < layers.size(); ++l)
+            {
+                buffers.statistics[l].resize(layers[l]->getStatisticsSize());
+                buffers.deltaStatistics[l].resize(layers[l]->getDeltaStatisticsSize());
+            }
+
+            buffers.activations.resize(layers.size());
+            for (size_t l = 0; l < layers.size(); ++l)
+                reserve(buffers.activations[l], batchSize * layers[l]->getOutputShape().size());
+
+            if (buffers.weightGradients.size() != layers.size())
+            {
+                buffers.weightGradients.clear();
+                buffers.biasGradients.clear();
+                for (size_t l = 0; l < layers.size(); ++l)
+                {
+                    buffers.weightGradients.emplace_back(weights[l].rows(), weights[l].cols());
+                    buffers.biasGradients.emplace_back(biases[l].rows(), 1);
+                }
+            }
+        }
+    }
+
+    void SequentialNetwork::calcGradient(const DATA::TrainingData<std::vector<float>>* samples, size_t count, ThreadBuffers& buffers)
+    {
+        const size_t numLayers = layers.size();
+        const size_t numInputs = inputShape.size();
+
+        float* input = buffers.input.data();
+        for (size_t s = 0; s < count; ++s)
+            std::copy(samples[s].data.begin(), samples[s].data.end(), input + s * numInputs);
+
+        const float* currentInputs = input;
+        for (size_t l = 0; l < numLayers; ++l)
+        {
+            layers[l]->forwardTraining(currentInputs, weights[l].data(), biases[l].data(), buffers.activations[l].data(), count,
+                buffers.scratch.data(), nullptr);
+            currentInputs = buffers.activations[l].data();
+        }
+
+        float* delta = buffers.delta.data();
+        float* prevDelta = buffers.prevDelta.data();
+        calcOutputDelta(samples, count, currentInputs, delta, buffers);
+
+        for (int64_t l = numLayers - 1; l >= 0; --l)
+        {
+            const float* layerInputs = (l == 0) ? input : buffers.activations[l - 1].data();
+            layers[l]->backward(layerInputs, buffers.activations[l].data(), delta, weights[l].data(),
+                buffers.weightGradients[l].data(), buffers.biasGradients[l].data(), l == 0 ? nullptr : prevDelta, count, buffers.scratch.data());
+            std::swap(delta, prevDelta);
+        }
+    }
+
+    void SequentialNetwork::calcOutputDelta(const DATA::TrainingData<std::vector<float>>* samples, size_t count, const float* outputs, float* delta, ThreadBuffers& buffers) const
+    {
+        const size_t numOutputs = getOutputShape().size();
+        for (size_t s = 0; s < count; ++s)
+        {
+            const std::vector<float>& expected = samples[s].label;
+            const float* sampleOutput = outputs + s * numOutputs;
+
+            for (size_t i = 0; i < numOutputs; ++i)
+                delta[s * numOutputs + i] = expected[i] - sampleOutput[i];
+
+            const size_t expectedLabel = std::distance(expected.begin(), std::max_element(expected.begin(), expected.end()));
+            const size_t guess = std::distance(sampleOutput, std::max_element(sampleOutput, sampleOutput + numOutputs));
+            (guess == expectedLabel) ? ++buffers.numCorrect : ++buffers.numWrong;
+        }
+    }
+
+    bool SequentialNetwork::hasBatchStatistics() const
+    {
+        for (const auto& layer : layers)
+        {
+            if (layer->getStatisticsSize() > 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    // summed in thread order into merged
+    void SequentialNetwork::mergeStatistics(std::vector<std::vector<float>> ThreadBuffers::* statistics, size_t layer, size_t numThreads, std::vector<float>& merged) const
+    {
+        merged = (threadBuffers[0].*statistics)[layer];
+        for (size_t t = 1; t < numThreads; ++t)
+            TMATH::add((threadBuffers[t].*statistics)[layer].data(), merged.data(), merged.size());
+    }
+
+    void SequentialNetwork::calcGradientBatchStatistics(std::span<const DATA::TrainingData<std::vector<float>>> miniBatch, size_t numThreads, size_t chunkSize)
+    {
+        const size_t numLayers = layers.size();
+        const size_t numInputs = inputShape.size();
+        batchStatistics.resize(numLayers);
+        batchDeltaStatistics.resize(numLayers);
+
+        // every thread holds its whole chunk from the first layer to the last
+        auto start = [&](size_t t) { return t * chunkSize; };
+        auto count = [&](size_t t) { return (t == numThreads - 1 ? miniBatch.size() : (t + 1) * chunkSize) - start(t); };
+        auto layerInputs = [&](size_t t, size_t l) -> const float* {
+            return l == 0 ? threadBuffers[t].input.data() : threadBuffers[t].activations[l - 1].data();
+        };
+
+        threadPool->parallelFor(numThreads, [&](size_t t)
+        {
+            for (size_t s = 0; s < count(t); ++s)
+                std::copy(miniBatch[start(t) + s].data.begin(), miniBatch[start(t) + s].data.end(), threadBuffers[t].input.data() + s * numInputs);
+        });
+
+        for (size_t l = 0; l < numLayers; ++l)
+        {
+            const float* statistics = nullptr;
+            if (layers[l]->getStatisticsSize() > 0)
+            {
+                threadPool->parallelFor(numThreads, [&](size_t t)
+                {
+                    layers[l]->addStatistics(layerInputs(t, l), count(t), threadBuffers[t].statistics[l].data());
+                });
+                mergeStatistics(&ThreadBuffers::statistics, l, numThreads, batchStatistics[l]);
+                statistics = batchStatistics[l].data();
+            }
+
+            threadPool->parallelFor(numThreads, [&](size_t t)
+            {
+                layers[l]->forwardTraining(layerInputs(t, l), weights[l].data(), biases[l].data(), threadBuffers[t].activations[l].data(), count(t),
+                    threadBuffers[t].scratch.data(), statistics);
+            });
+        }
+
+        threadPool->parallelFor(numThreads, [&](size_t t)
+        {
+            calcOutputDelta(miniBatch.data() + start(t), count(t), threadBuffers[t].activations.back().data(), threadBuffers[t].delta.data(), threadBuffers[t]);
+        });
+
+        for (int64_t l = numLayers - 1; l >= 0; --l)
+        {
+            const float* statistics = nullptr;
+            const float* deltaStatistics = nullptr;
+            if (layers[l]->getStatisticsSize() > 0)
+            {
+                threadPool->parallelFor(numThreads, [&](size_t t)
+                {
+                    layers[l]->addDeltaStatistics(layerInputs(t, l), threadBuffers[t].activations[l].data(), threadBuffers[t].delta.data(), count(t),
+                        batchStatistics[l].data(), threadBuffers[t].deltaStatistics[l].data());
+                });
+                mergeStatistics(&ThreadBuffers::deltaStatistics, l, numThreads, batchDeltaStatistics[l]);
+                statistics = batchStatistics[l].data();
+                deltaStatistics = batchDeltaStatistics[l].data();
+            }
+
+            threadPool->parallelFor(numThreads, [&](size_t t)
+            {
+                ThreadBuffers& buffers = threadBuffers[t];
+                layers[l]->backwardTraining(layerInputs(t, l), buffers.activations[l].data(), buffers.delta.data(), weights[l].data(),
+                    buffers.weightGradients[l].data(), buffers.biasGradients[l].data(), l == 0 ? nullptr : buffers.prevDelta.data(), count(t),
+                    buffers.scratch.data(), statistics, deltaStatistics);
+                std::swap(buffers.delta, buffers.prevDelta);
+            });
+        }
+    }
+
+    float SequentialNetwork::trainCPU(std::span<const DATA::TrainingData<std::vector<float>>> miniBatch, float learningRate)
+    {
+        if (miniBatch.empty() || layers.empty())
+            return 0.0f;
+
+        if (!threadPool)
+            threadPool = std::make_unique<ThreadPool>();
+
+        const size_t numThreads = std::min(threadPool->size(), miniBatch.size());
+        const size_t chunkSize = miniBatch.size() / numThreads;
+
+        // batch statistics need every thread's chunk in one piece, otherwise chunks go through in arena sized parts
+        const bool synchronized = hasBatchStatistics();
+        const size_t arenaBatch = synchronized ? chunkSize + miniBatch.size() % numThreads
+                                                  : std::min(maxArenaBatch, chunkSize + miniBatch.size() % numThreads);
+
+        prepareThreadBuffers(numThreads, arenaBatch);
+
+        threadPool->parallelFor(numThreads, [&](size_t t)
+        {
+            ThreadBuffers& buffers = threadBuffers[t];
+            buffers.numCorrect = buffers.numWrong = 0;
+            for (size_t l = 0; l < layers.size(); ++l)
+            {
+                buffers.weightGradients[l].zero();
+                buffers.biasGradients[l].zero();
+                std::fill(buffers.statistics[l].begin(), buffers.statistics[l].end(), 0.0f);
+                std::fill(buffers.deltaStatistics[l].begin(), buffers.deltaStatistics[l].end(), 0.0f);
+            }
+
+            if (synchronized)
+                return;
+
+            const size_t start = t * chunkSize;
+            const size_t end = (t == numThreads - 1) ? miniBatch.size() : (t + 1) * chunkSize;
+            for (size_t i = start; i < end; i += arenaBatch)
+                calcGradient(miniBatch.data() + i, std::min(arenaBatch, end - i), buffers);
+        });
+
+        if (synchronized)
+            calcGradientBatchStatistics(miniBatch, numThreads, chunkSize);
+
+        // every thread reduces its own slice of each layer across all per-thread gradients
+        threadPool->parallelFor(numThreads, [&](size_t t)
+        {
+            for (size_t l = 0; l < layers.size(); ++l)
+            {
+                const size_t rows = weights[l].rows();
+                const size_t cols = weights[l].cols();
+                const size_t rowStart = rows * t / numThreads;
+                const size_t rowEnd = rows * (t + 1) / numThreads;
+
+                float* wDst = weightGradients[l].data() + rowStart * cols;
+                float* bDst = biasGradients[l].data() + rowStart;
+                std::copy_n(threadBuffers[0].weightGradients[l].data() + rowStart * cols, (rowEnd - rowStart) * cols, wDst);
+                std::copy_n(threadBuffers[0].biasGradients[l].data() + rowStart, rowEnd - rowStart, bDst);
+
+                for (size_t src = 1; src < numThreads; ++src)
+                {
+                    TMATH::add(threadBuffers[src].weightGradients[l].data() + rowStart * cols, wDst, (rowEnd - rowStart) * cols);
+                    TMATH::add(threadBuffers[src].biasGradients[l].data() + rowStart, bDst, rowEnd - rowStart);
+                }
+            }
+        });
+
+        int32_t numCorrect = 0;
+        int32_t numWrong = 0;
+        for (size_t t = 0; t < numThreads; ++t)
+        {
+            numCorrect += threadBuffers[t].numCorrect;
+            numWrong += threadBuffers[t].numWrong;
+        }
+
+        updateLayerState();
+        applyOptimizer(learningRate, static_cast<float>(miniBatch.size()));
+
+        return static_cast<float>(numCorrect) / (numCorrect + numWrong);
+    }
+
+    void SequentialNetwork::applyOptimizer(float learningRate, float batchSize)
+    {
+        optimizer->beginStep();
+
+        const size_t stateCount = optimizer->getStateCount();
+        std::array<float*, 2> weightState{};
+        std::array<float*, 2> biasState{};
+
+        for (size_t l = 0; l < layers.size(); ++l)
+        {
+            if (weights[l].size() == 0)
+                continue;
+
+            for (size_t s = 0; s < stateCount; ++s)
+            {
+                weightState[s] = weightOptimizerState[l][s].data();
+                biasState[s] = biasOptimizerState[l][s].data();
+            }
+
+            optimizer->update(weights[l].data(), weightGradients[l].data(), weightState.data(), weights[l].size(), learningRate, 1.0f / batchSize, true);
+            optimizer->update(biases[l].data(), biasGradients[l].data(), biasState.data(), biases[l].size(), learningRate, 1.0f / batchSize, false);
+        }
+    }
+
+    // once per step, from the statistics of the whole mini-batch
+    void SequentialNetwork::updateLayerState()
+    {
+        for (size_t l = 0; l < layers.size(); ++l)
+        {
+            if (layers[l]->getStatisticsSize() > 0)
+                layers[l]->updateState(batchStatistics[l].data());
+        }
+    }
+
+    bool SequentialNetwork::getDenseFlags(NeuralNetworkFlags_& flags) const
+    {
+        if (layers.empty() || inputShape.height != 1 || inputShape.width != 1)
+            return false;
+
+        bool internalReLU = true;
+        bool internalSigmoid = true;
+        for (size_t l = 0; l < layers.size(); ++l)
+        {
+            if (layers[l]->getType() != LayerType_Dense)
+                return false;
+
+            const NeuralNetworkFlags_ activation = static_cast<const DenseLayer&>(*layers[l]).getActivation();
+            if (activation == NeuralNetworkFlags_Linear)
+                return false;
+
+            if (l + 1 < layers.size())
+            {
+                internalReLU &= activation == NeuralNetworkFlags_ReLU;
+                internalSigmoid &= activation == NeuralNetworkFlags_None;
+            }
+        }
+
+        const bool lastReLU = static_cast<const DenseLayer&>(*layers.back()).getActivation() == NeuralNetworkFlags_ReLU;
+        if (internalReLU && lastReLU)
+            flags = NeuralNetworkFlags_ReLU;
+        else if (internalSigmoid && !lastReLU)
+            flags = NeuralNetworkFlags_None;
+        else if (internalReLU)
+            flags = NeuralNetworkFlags_ReLU_Internal;
+        else
+            return false;
+
+        return true;
+    }
+
+    void SequentialNetwork::save()
+    {
+        std::filesystem::path outputPath = std::filesystem::current_path() / "networks";
+
+        if (!std::filesystem::exists(outputPath))
+        {
+            std::filesystem::create_directory(outputPath);
+        }
+
+        FORMAT::LayerGraphHeader header{static_cast<uint32_t>(layers.size()), static_cast<uint32_t>(inputShape.channels),
+            static_cast<uint32_t>(inputShape.height), static_cast<uint32_t>(inputShape.width)};
+
+        std::vector<std::byte> graph(sizeof(header) + layers.size() * sizeof(LayerRecord));
+        std::memcpy(graph.data(), &header, sizeof(header));
+
+        // the structure holds every layer's flat output size, for tools that only read the header
+        std::vector<size_t> structure{inputShape.size()};
+        FORMAT::ModelWriter writer;
+        for (uint32_t l = 0; l < layers.size(); ++l)
+        {
+            const LayerRecord record = layers[l]->getRecord();
+            std::memcpy(graph.data() + sizeof(header) + l * sizeof(LayerRecord), &record, sizeof(record));
+            structure.push_back(layers[l]->getOutputShape().size());
+
+            if (weights[l].size() == 0)
+                continue;
+
+            writer.addTensor(FORMAT::TensorKind_Weights, l, 0, weights[l].rows(), weights[l].cols(), weights[l].data());
+            writer.addTensor(FORMAT::TensorKind_Biases, l, 0, biases[l].rows(), 1, biases[l].data());
+
+            if (layers[l]->getStateSize() != 0)
+                writer.addTensor(FORMAT::TensorKind_LayerState, l, 0, 1, layers[l]->getStateSize(), layers[l]->getState());
+        }
+
+        NeuralNetworkFlags_ denseFlags = NeuralNetworkFlags_None;
+        const bool dense = getDenseFlags(denseFlags);
+        if (!dense)
+            writer.addBlob(FORMAT::TensorKind_LayerGraph, graph.data(), graph.size());
+
+        std::filesystem::path filePath = outputPath / std::string(name + ".tars");
+        std::filesystem::path tempPath = outputPath / std::string(name + ".tars.tmp");
+
+        std::error_code error;
+        if (writer.write(tempPath, structure, name, dense ? denseFlags : 0))
+            std::filesystem::rename(tempPath, filePath, error);
+
+        if (!error && std::filesystem::exists(filePath))
+        {
+            std::cout << "Network saved successfully: " << filePath << std::endl;
+        }
+        else
+        {
+            std::cerr << "Could not open file for writing: " << filePath << std::endl;
+        }
+    }
+} // namespace NTARS
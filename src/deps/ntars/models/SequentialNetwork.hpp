@@ -0,0 +1,137 @@
+#ifndef NTARS_SEQUENTIAL_NETWORK_HPP
+#define NTARS_SEQUENTIAL_NETWORK_HPP
+
+#include "ntars/models/DenseNetwork.hpp"
+#include "ntars/layers/layer.hpp"
+#include "ntars/layers/conv2d_layer.hpp"
+#include "ntars/layers/pooling_layer.hpp"
+#include "ntars/layers/flatten_layer.hpp"
+#include "ntars/layers/batch_norm_layer.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace NTARS
+{
+    // Layer graph run in order, each layer reading the previous one's output shape, e.g. for MNIST:
+    //   SequentialNetwork network{{1, 28, 28}, "MnistConv"};
+    //   network.addConv2D(8, 3, 1, 1);
+    //   network.addMaxPool2D(2);
+    //   network.addFlatten();
+    //   network.addDense(10);
+    // Training follows DenseNeuralNetwork: summed descent directions, chunks of samples per thread, one optimizer step.
+    // BatchNorm statistics are those of the whole mini-batch, so the result does not depend on the thread count.
+    // Saved models are .tars files with a layer graph record, dense-only .tars and JSON models load as Dense layers.
+    // A graph of plain dense layers is saved as a DenseNeuralNetwork model, so a folded network loads anywhere
+    class SequentialNetwork
+    {
+    public:
+        SequentialNetwork(TensorShape inputShape, const std::string& name);
+        SequentialNetwork(const std::string& file);
+        explicit SequentialNetwork(const DenseNeuralNetwork& network);
+
+        // Layers are appended after the last one, their parameters initialized as DenseNeuralNetwork does
+        Conv2DLayer& addConv2D(size_t filters, size_t kernel, size_t stride = 1, size_t padding = 0, NeuralNetworkFlags_ flags = NeuralNetworkFlags_ReLU);
+        MaxPool2DLayer& addMaxPool2D(size_t size, size_t stride = 0);
+        FlattenLayer& addFlatten();
+        DenseLayer& addDense(size_t outputs, NeuralNetworkFlags_ flags = NeuralNetworkFlags_None);
+        // Usually after a Dense or Conv2D layer with NeuralNetworkFlags_Linear, which then takes over its activation
+        BatchNormLayer& addBatchNorm(NeuralNetworkFlags_ flags = NeuralNetworkFlags_None);
+
+        // Merges every BatchNorm into the Linear Dense or Conv2D layer right before it: the weights and bias of
+        // each output are scaled and shifted by the running statistics, gamma and beta. Inference then costs what
+        // it would without the BatchNorm. Returns the number of layers folded
+        size_t fold();
+
+        // Output-only inference, reentrant as long as every caller has its own workspace
+        PredictWorkspace createWorkspace() const;
+        std::span<const float> predict(const float* inputs, PredictWorkspace& workspace) const;
+
+        float trainCPU(std::span<const DATA::TrainingData<std::vector<float>>> miniBatch, float learningRate = 1);
+
+        // Resizes the training thread pool, 0 uses every hardware thread
+        void setThreadCount(size_t numThreads);
+        void setOptimizer(std::unique_ptr<Optimizer> newOptimizer);
+
+        void save();
+
+        inline const std::string& getName() const { return name; }
+        inline const TensorShape& getInputShape() const { return inputShape; }
+        inline const TensorShape& getOutputShape() const { return layers.empty() ? inputShape : layers.back()->getOutputShape(); }
+        inline const std::vector<std::unique_ptr<Layer>>& getLayers() const { return layers; }
+        inline std::vector<TMATH::Matrix_t<float>>& getWeights() { return weights; }
+        inline std::vector<TMATH::Matrix_t<float>>& getBiases() { return biases; }
+
+        size_t getParameterCount() const;
+        // Per sample inference cost, a multiply-add counts as two
+        double getForwardFlops() const;
+
+    private:
+        struct ThreadBuffers
+        {
+            std::vector<float> input;
+            std::vector<std::vector<float>> activations;
+            std::vector<float> delta;
+            std::vector<float> prevDelta;
+            std::vector<float> scratch;
+            std::vector<std::vector<float>> statistics;
+            std::vector<std::vector<float>> deltaStatistics;
+            std::vector<TMATH::Matrix_t<float>> weightGradients;
+            std::vector<TMATH::Matrix_t<float>> biasGradients;
+            int32_t numCorrect{0};
+            int32_t numWrong{0};
+        };
+
+        template<typename L>
+        L& addLayer(std::unique_ptr<L> layer);
+        bool addLayer(const LayerRecord& record);
+        static std::unique_ptr<Layer> createLayer(const LayerRecord& record, TensorShape inputShape);
+        // DenseNeuralNetwork flags describing this graph, false if it is not a chain of dense layers it can run
+        bool getDenseFlags(NeuralNetworkFlags_& flags) const;
+
+        bool loadGraph(const FORMAT::ModelReader& reader);
+        void loadDense(const DenseNeuralNetwork& network);
+
+        void initializeTrainingBuffers();
+        // Widest activation and largest layer scratch, in floats
+        void getBufferSizes(size_t& widest, size_t& scratch) const;
+        void prepareThreadBuffers(size_t numThreads, size_t batchSize);
+        void calcGradient(const DATA::TrainingData<std::vector<float>>* samples, size_t count, ThreadBuffers& buffers);
+        // Expected minus actual outputs of count samples, counting the right and wrong guesses
+        void calcOutputDelta(const DATA::TrainingData<std::vector<float>>* samples, size_t count, const float* outputs, float* delta, ThreadBuffers& buffers) const;
+        // Layer by layer across the threads, so layers with batch statistics see those of the whole mini-batch
+        void calcGradientBatchStatistics(std::span<const DATA::TrainingData<std::vector<float>>> miniBatch, size_t numThreads, size_t chunkSize);
+        void mergeStatistics(std::vector<std::vector<float>> ThreadBuffers::* statistics, size_t layer, size_t numThreads, std::vector<float>& merged) const;
+        bool hasBatchStatistics() const;
+        void applyOptimizer(float learningRate, float batchSize);
+        void updateLayerState();
+
+        static constexpr size_t maxArenaBatch = 64;
+
+        std::string name;
+        TensorShape inputShape;
+        std::vector<std::unique_ptr<Layer>> layers;
+
+        // [layer], 0 x 0 for layers without parameters
+        std::vector<TMATH::Matrix_t<float>> weights;
+        std::vector<TMATH::Matrix_t<float>> biases;
+        std::vector<TMATH::Matrix_t<float>> weightGradients;
+        std::vector<TMATH::Matrix_t<float>> biasGradients;
+
+        std::unique_ptr<ThreadPool> threadPool;
+        std::vector<ThreadBuffers> threadBuffers;
+        // [layer], the statistics of the current mini-batch summed over every thread
+        std::vector<std::vector<float>> batchStatistics;
+        std::vector<std::vector<float>> batchDeltaStatistics;
+
+        // Optimizer state, [layer][slot] with slot < optimizer->getStateCount()
+        std::unique_ptr<Optimizer> optimizer{std::make_unique<SGDOptimizer>()};
+        std::vector<std::vector<TMATH::Matrix_t<float>>> weightOptimizerState;
+        std::vector<std::vector<TMATH::Matrix_t<float>>> biasOptimizerState;
+    };
+} // namespace NTARS
+
+#endif // NTARS_SEQUENTIAL_NETWORK_HPP
@@ -0,0 +1,189 @@
+#ifndef NTARS_STATIC_DENSE_NETWORK_HPP
+#define NTARS_STATIC_DENSE_NETWORK_HPP
+
+#include "ntars/models/DenseNetwork.hpp"
+#include "ntars/layers/layer.hpp"
+#include "tarsmath/calculus/relu.hpp"
+#include "tarsmath/calculus/sigmoid.hpp"
+#include "tarsmath/linear_algebra/simd_kernels.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <utility>
+
+namespace NTARS
+{
+    // Inference-only network with its topology fixed at compile time, e.g. StaticDenseNetwork<784, 100, 50, 10>.
+    // Weights live inline, every row padded to a multiple of 8 floats with zeros, so the kernels have no tails and
+    // all loop bounds are constants. Activations stay in two stack buffers. The object holds every parameter,
+    // so large topologies belong on the heap (std::make_unique).
+    template<size_t... Sizes>
+    class StaticDenseNetwork
+    {
+        static_assert(sizeof...(Sizes) >= 2, "a network needs an input and an output size");
+        static_assert(((Sizes > 0) && ...), "layer sizes must be positive");
+
+    public:
+        static constexpr std::array<size_t, sizeof...(Sizes)> structure{Sizes...};
+        static constexpr size_t numLayers = sizeof...(Sizes) - 1;
+        static constexpr size_t numInputs = structure.front();
+        static constexpr size_t numOutputs = structure.back();
+
+        // Copies the parameters of a network with the same structure
+        bool load(const DenseNeuralNetwork& network)
+        {
+            const std::vector<size_t> otherStructure = network.getStructure();
+            if (!std::equal(otherStructure.begin(), otherStructure.end(), structure.begin(), structure.end()))
+            {
+                std::cerr << "Network structure does not match the static topology" << std::endl;
+                return false;
+            }
+
+            const std::shared_ptr<const WeightSnapshot> snapshot = network.getSnapshot();
+            for (size_t l = 0; l < numLayers; ++l)
+            {
+                const size_t in = structure[l];
+                const size_t out = structure[l + 1];
+
+                for (size_t o = 0; o < out; ++o)
+                {
+                    float* row = weights.data() + weightOffset(l) + o * padded(in);
+                    std::copy_n(snapshot->weights[l] + o * in, in, row);
+                    std::fill(row + in, row + padded(in), 0.0f);
+                }
+
+                std::copy_n(snapshot->biases[l], out, biases.data() + biasOffset(l));
+
+                // per layer, ReLU_Internal and Linear networks mix activations
+                activations[l] = network.getLayers()[l].getActivation();
+            }
+
+            return true;
+        }
+
+        // Any file DenseNeuralNetwork loads, resolved the same way
+        bool load(const std::string& file)
+        {
+            DenseNeuralNetwork network{file};
+            return load(network);
+        }
+
+        // outputs holds numOutputs floats
+        void predict(const float* inputs, float* outputs) const
+        {
+            alignas(64) float buffers[2][widest];
+
+            // inputs that don't fill whole vectors are padded once, every later layer is padded by construction
+            const float* current = inputs;
+            if constexpr (numInputs % 8 != 0)
+            {
+                std::copy_n(inputs, numInputs, buffers[1]);
+                std::fill(buffers[1] + numInputs, buffers[1] + padded(numInputs), 0.0f);
+                current = buffers[1];
+            }
+
+            [&]<size_t... L>(std::index_sequence<L...>)
+            {
+                ((current = runLayer<L>(current, L + 1 == numLayers ? outputs : buffers[L % 2])), ...);
+            }(std::make_index_sequence<numLayers>{});
+        }
+
+        inline NeuralNetworkFlags_ getActivation(size_t layer) const { return activations[layer]; }
+
+    private:
+        static constexpr size_t padded(size_t size) { return (size + 7) / 8 * 8; }
+
+        static constexpr size_t weightOffset(size_t layer)
+        {
+            size_t offset = 0;
+            for (size_t l = 0; l < layer; ++l)
+                offset += structure[l + 1] * padded(structure[l]);
+            return offset;
+        }
+
+        static constexpr size_t biasOffset(size_t layer)
+        {
+            size_t offset = 0;
+            for (size_t l = 0; l < layer; ++l)
+                offset += structure[l + 1];
+            return offset;
+        }
+
+        static constexpr size_t widest = []()
+        {
+            size_t width = 0;
+            for (size_t size : structure)
+                width = std::max(width, padded(size));
+            return width;
+        }();
+
+        // Four output rows share every load of the input vector; the row tile is unrolled at compile time
+        static constexpr size_t rowTile = 4;
+
+        template<size_t Layer>
+        const float* runLayer(const float* inputs, float* outputs) const
+        {
+            constexpr size_t in = structure[Layer];
+            constexpr size_t out = structure[Layer + 1];
+            constexpr size_t stride = padded(in);
+            constexpr bool last = Layer + 1 == numLayers;
+
+            const float* layerWeights = weights.data() + weightOffset(Layer);
+            const float* layerBiases = biases.data() + biasOffset(Layer);
+
+            const NeuralNetworkFlags_ activation = activations[Layer];
+
+            auto activate = [&](size_t o, float sum) {
+                outputs[o] = NTARS::Layer::activate(sum + layerBiases[o], activation);
+            };
+
+            size_t o = 0;
+            for (; o + rowTile <= out; o += rowTile)
+            {
+                float sums[rowTile];
+                dotRows<stride>(inputs, layerWeights + o * stride, std::make_index_sequence<rowTile>{}, sums);
+                for (size_t r = 0; r < rowTile; ++r)
+                    activate(o + r, sums[r]);
+            }
+
+            if constexpr (out % rowTile != 0)
+            {
+                float sums[out % rowTile];
+                dotRows<stride>(inputs, layerWeights + o * stride, std::make_index_sequence<out % rowTile>{}, sums);
+                for (size_t r = 0; r < out % rowTile; ++r)
+                    activate(o + r, sums[r]);
+            }
+
+            // the padding lanes meet zero weights in the next layer, they only have to be finite
+            if constexpr (!last)
+                std::fill(outputs + out, outputs + padded(out), 0.0f);
+
+            return outputs;
+        }
+
+        template<size_t Stride, size_t... R>
+        static void dotRows(const float* inputs, const float* rows, std::index_sequence<R...>, float* sums)
+        {
+            #ifdef USE_SIMD
+            __m256 acc[sizeof...(R)] = {(static_cast<void>(R), _mm256_setzero_ps())...};
+            for (size_t i = 0; i < Stride; i += 8)
+            {
+                const __m256 x = _mm256_loadu_ps(inputs + i);
+                ((acc[R] = _mm256_fmadd_ps(_mm256_load_ps(rows + R * Stride + i), x, acc[R])), ...);
+            }
+            ((sums[R] = TMATH::horizontalSum(acc[R])), ...);
+            #else
+            ((sums[R] = TMATH::dot(inputs, rows + R * Stride, Stride)), ...);
+            #endif
+        }
+
+        alignas(64) std::array<float, weightOffset(numLayers)> weights{};
+        alignas(64) std::array<float, biasOffset(numLayers)> biases{};
+        std::array<NeuralNetworkFlags_, numLayers> activations{};
+    };
+} // namespace NTARS
+
+#endif // NTARS_STATIC_DENSE_NETWORK_HPP
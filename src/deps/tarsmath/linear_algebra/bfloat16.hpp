@@ -0,0 +1,186 @@
+#ifndef TARS_MATH_BFLOAT16_HPP
+#define TARS_MATH_BFLOAT16_HPP
+
+#include "tarsmath/linear_algebra/simd_kernels.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace TMATH
+{
+    // Upper half of an IEEE float: same exponent range, 8 bit mantissa
+    using bf16_t = uint16_t;
+
+    // Round to nearest even, NaN stays a (quiet) NaN
+    inline bf16_t toBF16(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        if ((bits & 0x7FFFFFFFu) > 0x7F800000u)
+            return static_cast<bf16_t>((bits >> 16) | 0x0040u);
+
+        bits += 0x7FFFu + ((bits >> 16) & 1u);
+        return static_cast<bf16_t>(bits >> 16);
+    }
+
+    inline float fromBF16(bf16_t value)
+    {
+        const uint32_t bits = static_cast<uint32_t>(value) << 16;
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    #ifdef USE_SIMD
+    inline __m256 loadBF16(const bf16_t* x)
+    {
+        const __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(half), 16));
+    }
+
+    inline void storeBF16(bf16_t* y, __m256 v)
+    {
+        const __m256i bits = _mm256_castps_si256(v);
+        const __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+        __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(bits, _mm256_add_epi32(_mm256_set1_epi32(0x7FFF), lsb)), 16);
+
+        const __m256i magnitude = _mm256_and_si256(bits, _mm256_set1_epi32(0x7FFFFFFF));
+        const __m256i isNaN = _mm256_cmpgt_epi32(magnitude, _mm256_set1_epi32(0x7F800000));
+        rounded = _mm256_blendv_epi8(rounded, _mm256_or_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(0x0040)), isNaN);
+
+        // packus works per 128 bit lane, the permute brings the two halves together
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(rounded, rounded), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y), _mm256_castsi256_si128(packed));
+    }
+    #endif
+
+    inline void toBF16(const float* x, bf16_t* y, size_t size)
+    {
+        size_t i = 0;
+
+        #ifdef USE_SIMD
+        for (; i + 8 <= size; i += 8)
+            storeBF16(&y[i], _mm256_loadu_ps(&x[i]));
+        #endif
+
+        for (; i < size; ++i)
+            y[i] = toBF16(x[i]);
+    }
+
+    inline void fromBF16(const bf16_t* x, float* y, size_t size)
+    {
+        size_t i = 0;
+
+        #ifdef USE_SIMD
+        for (; i + 8 <= size; i += 8)
+            _mm256_storeu_ps(&y[i], loadBF16(&x[i]));
+        #endif
+
+        for (; i < size; ++i)
+            y[i] = fromBF16(x[i]);
+    }
+
+    // BF16 inputs, FP32 products and accumulation
+    inline float dot(const bf16_t* a, const bf16_t* b, size_t size)
+    {
+        float sum = 0.0f;
+        size_t i = 0;
+
+        #ifdef USE_SIMD
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        for (; i + 16 <= size; i += 16)
+        {
+            acc0 = _mm256_fmadd_ps(loadBF16(&a[i]), loadBF16(&b[i]), acc0);
+            acc1 = _mm256_fmadd_ps(loadBF16(&a[i + 8]), loadBF16(&b[i + 8]), acc1);
+        }
+        for (; i + 8 <= size; i += 8)
+            acc0 = _mm256_fmadd_ps(loadBF16(&a[i]), loadBF16(&b[i]), acc0);
+
+        sum = horizontalSum(_mm256_add_ps(acc0, acc1));
+        #endif
+
+        for (; i < size; ++i)
+            sum += fromBF16(a[i]) * fromBF16(b[i]);
+
+        return sum;
+    }
+
+    // y += a * x, with y kept in FP32
+    inline void axpy(float a, const bf16_t* x, float* y, size_t size)
+    {
+        size_t i = 0;
+
+        #ifdef USE_SIMD
+        const __m256 aVec = _mm256_set1_ps(a);
+        for (; i + 8 <= size; i += 8)
+            _mm256_storeu_ps(&y[i], _mm256_fmadd_ps(aVec, loadBF16(&x[i]), _mm256_loadu_ps(&y[i])));
+        #endif
+
+        for (; i < size; ++i)
+            y[i] += a * fromBF16(x[i]);
+    }
+
+    // out[j] = dot(x[j], w) for four rows, every chunk of w is widened once for all of them
+    inline void dot4(const bf16_t* const* x, const bf16_t* w, size_t size, float* out)
+    {
+        size_t i = 0;
+        out[0] = out[1] = out[2] = out[3] = 0.0f;
+
+        #ifdef USE_SIMD
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps();
+        __m256 acc3 = _mm256_setzero_ps();
+        for (; i + 8 <= size; i += 8)
+        {
+            const __m256 wv = loadBF16(&w[i]);
+            acc0 = _mm256_fmadd_ps(loadBF16(&x[0][i]), wv, acc0);
+            acc1 = _mm256_fmadd_ps(loadBF16(&x[1][i]), wv, acc1);
+            acc2 = _mm256_fmadd_ps(loadBF16(&x[2][i]), wv, acc2);
+            acc3 = _mm256_fmadd_ps(loadBF16(&x[3][i]), wv, acc3);
+        }
+
+        out[0] = horizontalSum(acc0);
+        out[1] = horizontalSum(acc1);
+        out[2] = horizontalSum(acc2);
+        out[3] = horizontalSum(acc3);
+        #endif
+
+        for (; i < size; ++i)
+        {
+            const float wv = fromBF16(w[i]);
+            for (size_t j = 0; j < 4; ++j)
+                out[j] += fromBF16(x[j][i]) * wv;
+        }
+    }
+
+    // y += a[0] * x[0] + ... + a[3] * x[3], y is loaded and stored once for all four rows
+    inline void axpy4(const float* a, const bf16_t* const* x, float* y, size_t size)
+    {
+        size_t i = 0;
+
+        #ifdef USE_SIMD
+        const __m256 a0 = _mm256_set1_ps(a[0]);
+        const __m256 a1 = _mm256_set1_ps(a[1]);
+        const __m256 a2 = _mm256_set1_ps(a[2]);
+        const __m256 a3 = _mm256_set1_ps(a[3]);
+        for (; i + 8 <= size; i += 8)
+        {
+            __m256 acc = _mm256_loadu_ps(&y[i]);
+            acc = _mm256_fmadd_ps(a0, loadBF16(&x[0][i]), acc);
+            acc = _mm256_fmadd_ps(a1, loadBF16(&x[1][i]), acc);
+            acc = _mm256_fmadd_ps(a2, loadBF16(&x[2][i]), acc);
+            acc = _mm256_fmadd_ps(a3, loadBF16(&x[3][i]), acc);
+            _mm256_storeu_ps(&y[i], acc);
+        }
+        #endif
+
+        for (; i < size; ++i)
+            y[i] += a[0] * fromBF16(x[0][i]) + a[1] * fromBF16(x[1][i]) + a[2] * fromBF16(x[2][i]) + a[3] * fromBF16(x[3][i]);
+    }
+} // namespace TMATH
+
+#endif // TARS_MATH_BFLOAT16_HPP
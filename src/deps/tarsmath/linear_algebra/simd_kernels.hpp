@@ -0,0 +1,165 @@
+#ifndef TARS_MATH_SIMD_KERNELS_HPP
+#define TARS_MATH_SIMD_KERNELS_HPP
+
+#include "tarsmath/linear_algebra/matrix_component.hpp"
+
+#include <cstddef>
+
+namespace TMATH
+{
+    #ifdef USE_SIMD
+    inline float horizontalSum(__m256 v)
+    {
+        __m128 low = _mm256_castps256_ps128(v);
+        __m128 high = _mm256_extractf128_ps(v, 1);
+        low = _mm_add_ps(low, high);
+        low = _mm_add_ps(low, _mm_movehl_ps(low, low));
+        low = _mm_add_ss(low, _mm_shuffle_ps(low, low, 0x1));
+        return _mm_cvtss_f32(low);
+    }
+    #endif
+
+    inline float dot(const float* a, const float* b, size_t size)
+    {
+        float sum = 0.0f;
+        size_t i = 0;
+
+        #ifdef USE_SIMD
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        for (; i + 16 <= size; i += 16)
+        {
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(&a[i]), _mm256_loadu_ps(&b[i]), acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(&a[i + 8]), _mm256_loadu_ps(&b[i + 8]), acc1);
+        }
+        for (; i + 8 <= size; i += 8)
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(&a[i]), _mm256_loadu_ps(&b[i]), acc0);
+
+        sum = horizontalSum(_mm256_add_ps(acc0, acc1));
+        #endif
+
+        for (; i < size; ++i)
+            sum += a[i] * b[i];
+
+        return sum;
+    }
+
+    // y += a * x
+    inline void axpy(float a, const float* x, float* y, size_t size)
+    {
+        size_t i = 0;
+
+        #ifdef USE_SIMD
+        const __m256 aVec = _mm256_set1_ps(a);
+        for (; i + 8 <= size; i += 8)
+            _mm256_storeu_ps(&y[i], _mm256_fmadd_ps(aVec, _mm256_loadu_ps(&x[i]), _mm256_loadu_ps(&y[i])));
+        #endif
+
+        for (; i < size; ++i)
+            y[i] += a * x[i];
+    }
+
+    // y += x
+    inline void add(const float* x, float* y, size_t size)
+    {
+        size_t i = 0;
+
+        #ifdef USE_SIMD
+        for (; i + 8 <= size; i += 8)
+            _mm256_storeu_ps(&y[i], _mm256_add_ps(_mm256_loadu_ps(&x[i]), _mm256_loadu_ps(&y[i])));
+        #endif
+
+        for (; i < size; ++i)
+            y[i] += x[i];
+    }
+
+    // C[m x n] += A[m x k] * B[k x n], all row-major. Element (i, p) of A is read from a[i * aRowStride + p * aColStride],
+    // which lets the same kernel read A transposed. Four rows by eight columns of C stay in registers over the whole
+    // k loop, so every load of B feeds four FMAs and C is written once
+    inline void gemmStrided(const float* a, size_t aRowStride, size_t aColStride, const float* b, float* c, size_t m, size_t n, size_t k)
+    {
+        size_t i = 0;
+
+        #ifdef USE_SIMD
+        for (; i + 4 <= m; i += 4)
+        {
+            const float* a0 = a + i * aRowStride;
+            const float* a1 = a0 + aRowStride;
+            const float* a2 = a1 + aRowStride;
+            const float* a3 = a2 + aRowStride;
+            float* c0 = c + i * n;
+
+            size_t j = 0;
+            for (; j + 8 <= n; j += 8)
+            {
+                __m256 acc0 = _mm256_loadu_ps(c0 + j);
+                __m256 acc1 = _mm256_loadu_ps(c0 + n + j);
+                __m256 acc2 = _mm256_loadu_ps(c0 + 2 * n + j);
+                __m256 acc3 = _mm256_loadu_ps(c0 + 3 * n + j);
+
+                for (size_t p = 0; p < k; ++p)
+                {
+                    const __m256 bVec = _mm256_loadu_ps(b + p * n + j);
+                    const size_t ap = p * aColStride;
+                    acc0 = _mm256_fmadd_ps(_mm256_set1_ps(a0[ap]), bVec, acc0);
+                    acc1 = _mm256_fmadd_ps(_mm256_set1_ps(a1[ap]), bVec, acc1);
+                    acc2 = _mm256_fmadd_ps(_mm256_set1_ps(a2[ap]), bVec, acc2);
+                    acc3 = _mm256_fmadd_ps(_mm256_set1_ps(a3[ap]), bVec, acc3);
+                }
+
+                _mm256_storeu_ps(c0 + j, acc0);
+                _mm256_storeu_ps(c0 + n + j, acc1);
+                _mm256_storeu_ps(c0 + 2 * n + j, acc2);
+                _mm256_storeu_ps(c0 + 3 * n + j, acc3);
+            }
+
+            for (; j < n; ++j)
+            {
+                float sums[4] = {c0[j], c0[n + j], c0[2 * n + j], c0[3 * n + j]};
+                for (size_t p = 0; p < k; ++p)
+                {
+                    const float bValue = b[p * n + j];
+                    const size_t ap = p * aColStride;
+                    sums[0] += a0[ap] * bValue;
+                    sums[1] += a1[ap] * bValue;
+                    sums[2] += a2[ap] * bValue;
+                    sums[3] += a3[ap] * bValue;
+                }
+
+                for (size_t r = 0; r < 4; ++r)
+                    c0[r * n + j] = sums[r];
+            }
+        }
+        #endif
+
+        for (; i < m; ++i)
+        {
+            for (size_t p = 0; p < k; ++p)
+                axpy(a[i * aRowStride + p * aColStride], b + p * n, c + i * n, n);
+        }
+    }
+
+    // C[m x n] += A[m x k] * B[k x n]
+    inline void gemm(const float* a, const float* b, float* c, size_t m, size_t n, size_t k)
+    {
+        gemmStrided(a, k, 1, b, c, m, n, k);
+    }
+
+    // C[m x n] += A^T * B with A stored as [k x m]
+    inline void gemmTransA(const float* a, const float* b, float* c, size_t m, size_t n, size_t k)
+    {
+        gemmStrided(a, 1, m, b, c, m, n, k);
+    }
+
+    // C[m x n] += A * B^T with B stored as [n x k], every element is a contiguous dot product
+    inline void gemmTransB(const float* a, const float* b, float* c, size_t m, size_t n, size_t k)
+    {
+        for (size_t i = 0; i < m; ++i)
+        {
+            for (size_t j = 0; j < n; ++j)
+                c[i * n + j] += dot(a + i * k, b + j * k, k);
+        }
+    }
+} // namespace TMATH
+
+#endif // TARS_MATH_SIMD_KERNELS_HPP
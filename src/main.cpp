@@ -1,13 +1,58 @@
 #include "core/application.hpp"
 #include <iostream>
+#include <string>
 
 #include "deps/tarsmath/linear_algebra/matrix_component.hpp"
 #include "deps/tarscuda/tensor_operations.hpp"
 #include <chrono>
 #include <omp.h>
 
-int main() 
+int main(int argc, char** argv) 
 {
+    // data-parallel training rank: --train-worker <rank> <world size> <transport> <session>
+    if (argc == 6 && std::string(argv[1]) == "--train-worker")
+    {
+        NTARS::TransportConfig config;
+        config.rank = std::stoul(argv[2]);
+        config.worldSize = std::stoul(argv[3]);
+        config.type = static_cast<NTARS::TransportType_>(std::stoi(argv[4]));
+        config.session = argv[5];
+
+        return core::runTrainingWorker(config);
+    }
+
+    // loopback check of data-parallel training: --verify-loopback <world size> <transport>
+    if (argc == 4 && std::string(argv[1]) == "--verify-loopback")
+        return core::verifyLoopbackTraining(std::stoul(argv[2]), static_cast<NTARS::TransportType_>(std::stoi(argv[3])));
+
+    // one of its ranks: --loopback-worker <rank> <world size> <transport> <session>
+    if (argc == 6 && std::string(argv[1]) == "--loopback-worker")
+    {
+        NTARS::TransportConfig config;
+        config.rank = std::stoul(argv[2]);
+        config.worldSize = std::stoul(argv[3]);
+        config.type = static_cast<NTARS::TransportType_>(std::stoi(argv[4]));
+        config.session = argv[5];
+
+        return core::runLoopbackWorker(config);
+    }
+
+    // .tds index and shard headers that lie about their counts: --verify-dataset
+    if (argc == 2 && std::string(argv[1]) == "--verify-dataset")
+        return core::verifyDatasetChecks();
+
+    // BatchNorm training that must not depend on the thread count: --verify-batchnorm
+    if (argc == 2 && std::string(argv[1]) == "--verify-batchnorm")
+        return core::verifyBatchNormThreads();
+
+    // checkpointed training resumed with dropout and loss scaling: --verify-resume
+    if (argc == 2 && std::string(argv[1]) == "--verify-resume")
+        return core::verifyCheckpointResume();
+
+    // NDJSON records holding NaN or infinities: --verify-ndjson
+    if (argc == 2 && std::string(argv[1]) == "--verify-ndjson")
+        return core::verifyNDJSONRoundTrip();
+
     omp_set_num_threads(omp_get_max_threads());
     core::application app{"Neural Network Controller", 1000, 800};
 